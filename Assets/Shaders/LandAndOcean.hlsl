@@ -31,11 +31,23 @@ struct PSInput
     float4 Color : COLOR;
 };
 
+#ifdef INSTANCED
+// Per instance copy of ObjectConstants, the root SRV points at the first instance of the draw.
+struct InstanceConstants
+{
+    float4x4 Model;
+    float4x4 ModelViewProjection;
+    float4x4 TextureTransform;
+};
+
+StructuredBuffer<InstanceConstants> Instances : register(t0, space1);
+#else
 cbuffer ObjectConstants : register(b0)
 {
     float4x4 Model;
     float4x4 TextureTransform;
 };
+#endif
 
 cbuffer MaterialConstants : register(b1)
 {
@@ -81,10 +93,15 @@ cbuffer PassConstants : register(b2)
 Texture2D albedo : register(t0);
 SamplerState textureSampler : register(s0);
 
-PSInput VSMain(VSInput input)
+PSInput VSMain(VSInput input, uint instanceID : SV_InstanceID)
 {
     PSInput result;
 
+#ifdef INSTANCED
+    float4x4 Model = Instances[instanceID].Model;
+    float4x4 TextureTransform = Instances[instanceID].TextureTransform;
+#endif
+
     // result.position = mul(float4(input.position, 1.0f), testMatrix);
     result.WorldPosition = mul(Model, float4(input.Position, 1.0f)).xyz;
     result.Position = mul(ViewProjection, float4(result.WorldPosition, 1.0));
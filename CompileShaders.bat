@@ -1,8 +1,15 @@
 %~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T vs_6_0 -E VSMain Assets/Shaders/7.RenderToTexture.hlsl -Fo Assets/Shaders/RenderToTextureVS.dxil
 %~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T ps_6_0 -E PSMain Assets/Shaders/7.RenderToTexture.hlsl -Fo Assets/Shaders/RenderToTexturePS.dxil
 
-%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T vs_6_0 -E VSMain Assets/Shaders/7.RenderToTexture.hlsl -Fo Assets/Shaders/LandAndOcean.dxil
-%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T ps_6_0 -E PSMain Assets/Shaders/7.RenderToTexture.hlsl -Fo Assets/Shaders/LandAndOcean.dxil
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T vs_6_0 -E VSMain Assets/Shaders/LandAndOcean.hlsl -Fo Assets/Shaders/LandAndOceanVS.dxil
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T vs_6_0 -E VSMain -D INSTANCED Assets/Shaders/LandAndOcean.hlsl -Fo Assets/Shaders/LandAndOceanInstancedVS.dxil
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T ps_6_0 -E PSMain -D FOG Assets/Shaders/LandAndOcean.hlsl -Fo Assets/Shaders/LandAndOceanFogPS.dxil
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T ps_6_0 -E PSMain -D ALPHA_TEST -D FOG Assets/Shaders/LandAndOcean.hlsl -Fo Assets/Shaders/LandAndOceanAlphaTestFogPS.dxil
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T ps_6_0 -E PSMain -D ALPHA_TEST -D FOG -D NO_ALPHA Assets/Shaders/LandAndOcean.hlsl -Fo Assets/Shaders/LandAndOceanAlphaTestFogNoAlphaPS.dxil
 
-%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T vs_6_0 -E VSMain Assets/Shaders/7.Skybox.hlsl -Fo Assets/Shaders/SkyboxVS.dxil
-%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T ps_6_0 -E PSMain Assets/Shaders/7.Skybox.hlsl -Fo Assets/Shaders/SkyboxPS.dxil
\ No newline at end of file
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T vs_6_0 -E VSMain Assets/Shaders/7.Skybox.hlsl -Fo Assets/Shaders/7.SkyboxVS.dxil
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T ps_6_0 -E PSMain -D FOG Assets/Shaders/7.Skybox.hlsl -Fo Assets/Shaders/7.SkyboxFogPS.dxil
+
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T vs_6_0 -E VSMain Assets/Shaders/TreeSprite.hlsl -Fo Assets/Shaders/TreeSpriteVS.dxil
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T gs_6_0 -E GSMain -D FOG Assets/Shaders/TreeSprite.hlsl -Fo Assets/Shaders/TreeSpriteFogGS.dxil
+%~dp0/Tools/dxc_2022_12_16/bin/x64/dxc.exe -T ps_6_0 -E PSMain -D ALPHA_TEST -D FOG Assets/Shaders/TreeSprite.hlsl -Fo Assets/Shaders/TreeSpriteAlphaTestFogPS.dxil
\ No newline at end of file
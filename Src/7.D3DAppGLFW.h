@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <future>
 #include <memory>
 #include <unordered_map>
 #include <wrl.h>
@@ -28,6 +29,33 @@ using namespace Microsoft::WRL;
 #include "GameTimer.h"
 #include "FrameResource.h"
 #include "GeometryGenerator.h"
+#include "StagingRing.h"
+#include "AssetCache.h"
+#include "StateCachedCommandList.h"
+#include "DrawSort.h"
+#include "InstanceBatcher.h"
+#include "IndirectCommands.h"
+#include "TaskScheduler.h"
+#include "CommandListPool.h"
+#include "DeferredReleaseQueue.h"
+#include "FrameTelemetry.h"
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
+#include "DescriptorAllocator.h"
+#include "PipelineStateCache.h"
+#include "ShaderCache.h"
+#include "ShaderHotReload.h"
+#include "ShaderPermutations.h"
+#include "TextureStreamer.h"
+#include "MappedFile.h"
+
+// ģļصͬݵļеͬһGPU
+// ϴ֮modelеĶᱻ(releaseModelData)ֻ
+struct ModelAsset
+{
+	DXModel model;
+	GeometryHandle geometry = InvalidGeometryHandle;
+};
 
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
@@ -42,14 +70,8 @@ struct RenderItem
 
 	glm::mat4 textureTransform = glm::mat4(1.0f);
 
-	// Dirty flag indicating the object data has changed and we need to update the constant buffer.
-	// Because we have an object cbuffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify object data we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-	uint32_t numFramesDirty = NumFrameResources;
-
-	// Index into GPU constant buffer corresponding to the ObjectCB for this render item.
-	uint32_t objectConstantBufferIndex = -1;
+	// GPU virtual address of this frame's ObjectCB, allocated from the frame resource's dynamic constant buffer.
+	D3D12_GPU_VIRTUAL_ADDRESS objectConstantBufferAddress = 0;
 
 	Material* material = nullptr;
 	MeshGeometry* meshGeometry = nullptr;
@@ -61,6 +83,13 @@ struct RenderItem
 	uint32_t indexCount = 0;
 	uint32_t startIndexLocation = 0;
 	uint32_t baseVertexLocation = 0;
+
+	// Small dense ids of the material and mesh, packed into the draw sort key.
+	uint32_t materialSortId = 0;
+	uint32_t meshSortId = 0;
+
+	// Local space bounds of the submesh, used to estimate how large the item is on screen.
+	DirectX::BoundingBox bounds;
 };
 
 enum class RenderLayer : int
@@ -75,10 +104,75 @@ enum class RenderLayer : int
 	Count
 };
 
+// ͸ύʽ
+enum class DrawSubmission : int
+{
+	PerItem = 0,
+	Instanced,
+	Indirect
+};
+
+// ݴ滺ΪһԴõĿռ䣬layoutsеOffsetݴ滺ʼλõ
+struct StagedSubresources
+{
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+	std::vector<uint32_t> rowCounts;
+	std::vector<uint64_t> rowSizes;
+};
+
+// ͼԪͬһһExecuteIndirectύ
+struct IndirectDrawGroup
+{
+	CD3DX12_GPU_DESCRIPTOR_HANDLE textureHandle;
+	D3D12_PRIMITIVE_TOPOLOGY primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	uint32_t firstCommand = 0;
+	uint32_t commandCount = 0;
+};
+
+// еһƽ׶ΣdrawCountύʽֱȾʵλ
+struct ScenePass
+{
+	RenderLayer layer = RenderLayer::Opaque;
+	DrawSubmission submission = DrawSubmission::PerItem;
+	ID3D12PipelineState* pipelineState = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS passConstantBufferAddress = 0;
+	uint32_t stencilRef = 0;
+	uint32_t drawCount = 0;
+};
+
+// ɫ˳createShadersAndInputlayoutsеǼǵ˳һ
+enum class ShaderProgram : uint32_t
+{
+	LandAndOceanVS = 0,
+	LandAndOceanPS,
+	SkyboxVS,
+	SkyboxPS,
+	TreeSpriteVS,
+	TreeSpritePS,
+	TreeSpriteGS
+};
+
+// ɫλÿһλһ궨壬һһλһɫ
+namespace ShaderFeature
+{
+	enum : ShaderFeatureMask
+	{
+		Instanced = 1 << 0,
+		AlphaTest = 1 << 1,
+		Fog = 1 << 2,
+		NoAlpha = 1 << 3
+	};
+}
+
 class D3DApp
 {
 public:
-	D3DApp();
+	// е֡ҲFrameResourceĸ
+	static constexpr uint32_t MinFrameResourceCount = 1;
+	static constexpr uint32_t MaxFrameResourceCount = 4;
+	static constexpr uint32_t DefaultFrameResourceCount = 3;
+
+	explicit D3DApp(uint32_t inFrameResourceCount = DefaultFrameResourceCount);
 	~D3DApp();
 
 	bool initialize(HINSTANCE hInstance, int32_t cmdShow);
@@ -96,36 +190,68 @@ private:
 	void createDevice();
 	void createCommandQueue();
 	void createSwapChain();
-	void createShaderResourceViewDescriptorHeap();
-	void createTextureShaderResourceView(const std::unique_ptr<Texture>& texture, uint32_t index = 0);
+	void createDescriptorHeaps();
+	void createTextureShaderResourceView(const std::unique_ptr<Texture>& texture);
 	void createTextureArrayShaderResourceView(const std::unique_ptr<Texture>& texture, uint32_t index = 0);
 	void createTextureShaderResourceViews();
 	void createRenderTargetView();
-	void createSkyboxDescriptorHeap();
-	void createSkyboxDescriptors();
 	void createRootSignature();
 	void createShadersAndInputlayouts();
 	void createGraphicsPipelineState();
 	void createSkyboxGraphicsPipelineState();
+	void createPendingPipelineStates();
+	void installPipelineStates();
+	void updateShaderHotReload();
+	static std::vector<uint8_t> compileShaderProgram(const ShaderCompileParameters& parameters);
+	void compileShaderPermutations(const std::vector<ShaderPermutationKey>& keys);
+	D3D12_SHADER_BYTECODE shaderBytecode(ShaderPermutationKey key);
 	void createCommandLists();
 	void createFence();
 	void createUploadHeap(uint64_t heapSize);
+	void createStagingBuffer(uint64_t bufferSize);
+	void createHeaps(const HeapAllocator& heapAllocator, std::vector<ComPtr<ID3D12Heap>>& heaps, D3D12_HEAP_FLAGS flags, const std::wstring& name);
+	void freeHeapMemory(HeapAllocator& heapAllocator, std::vector<ComPtr<ID3D12Heap>>& heaps, const HeapAllocation& allocation);
+	HeapAllocation allocateTextureMemory(D3D12_RESOURCE_DESC& textureDesc);
+	ComPtr<ID3D12Resource> createPlacedBuffer(uint64_t size, HeapAllocation& allocation, const std::wstring& name);
+	void uploadBufferData(ID3D12Resource* buffer, uint64_t offset, const void* data, uint64_t size);
+	void createGeometryPages();
+	GeometryHandle uploadGeometry(const void* vertices, uint32_t vertexCount, uint32_t vertexStride, const uint32_t* indices, uint32_t indexCount);
+	void setPooledMeshGeometry(MeshGeometry* meshGeometry, GeometryHandle geometry, const std::string& submeshName);
+	void defragmentGeometry();
+	uint64_t allocateStagingMemory(uint64_t size, uint64_t alignment);
+	StagedSubresources stageTextureSubresources(ID3D12Resource* resource, uint32_t firstSubresource, uint32_t subresourceCount);
+	void copyStagedTextureSubresources(ID3D12Resource* resource, uint32_t firstSubresource, const StagedSubresources& staged);
+	void uploadTextureSubresources(ID3D12Resource* resource, uint32_t firstSubresource, uint32_t subresourceCount, const D3D12_SUBRESOURCE_DATA* subresources);
+	void submitUploads();
 	void loadCubeResource();
 	void createTexture(std::unique_ptr<Texture>& texture);
+	std::shared_ptr<TextureAsset> createTextureAsset(const ComPtr<ID3D12Resource>& resource, const HeapAllocation& allocation);
 	void createTexture(const std::string& name, const std::wstring& path);
 	void loadResources();
 
 	void loadModels();
+	std::shared_ptr<ModelAsset> loadModel(const std::string& path, const std::string& name);
+	void releaseModelData();
 
 	void flushCommandQueue();
+	void waitForFenceValue(uint64_t value);
+	uint64_t pendingFenceValue() const;
 
 	void loadDDSTexture(const std::string& name, const std::wstring& path, TextureDimension dimension = TextureDimension::Texture2D);
+	static uint32_t streamingTailMip(const D3D12_RESOURCE_DESC& textureDesc);
+	static D3D12_RESOURCE_DESC mipRangeDesc(const D3D12_RESOURCE_DESC& textureDesc, uint32_t mip);
+	void registerStreamedTexture(const std::string& name, const std::shared_ptr<TextureAsset>& asset, MappedFile&& file, const D3D12_RESOURCE_DESC& textureDesc,
+								 std::vector<D3D12_SUBRESOURCE_DATA>&& subresources, uint32_t tailMip);
+	void requestTextureMips();
+	void resizeStreamedTexture(uint32_t streamedTexture, uint32_t mip);
+	void updateTextureStreaming();
 	void createRenderTextureRTVDescriptorHeap();
 	void createRenderTextureRTV(uint32_t width, uint32_t height);
 	void createRenderTextureSRVDescriptorHeap();
 	void createRenderTextureSRV();
 	void createRenderTextureDSVDescriptorHeap();
-	void createRenderTextureDSV(uint32_t width, uint32_t height);
+	void setRenderTextureDepthStencilSize(uint32_t width, uint32_t height);
+	void createRenderTextureDSV(ID3D12Resource* depthStencilBuffer);
 
 	/// ڴ㻺İ
 	///
@@ -165,26 +291,27 @@ private:
 	/// \param modelViewProjectionBuffer: ӳ䵽CPUĳָ
 	void createConstantBufferView(const ComPtr<ID3D12Heap>& heap, 
 								  uint64_t offset, uint32_t size, 
-								  const ComPtr<ID3D12DescriptorHeap>& descriptorHeap,
-								  uint32_t index,
 								  ComPtr<ID3D12Resource>& constantBuffer, 
 								  ObjectConstants** objectConstantBuffer);
 
 	void createConstantBufferView();
 	void createSkyboxConstantBufferView();
 	void createRenderTextureConstantBufferView();
-	void createDepthStencilDescriptorHeap();
 	void createDepthStencilView();
 	void createSamplerDescriptorHeap();
 	void createSamplers();
-	void createSkyboxSamplerDescriptorHeap();
 	void createSkyboxSampler();
 	void recordCommands();
 	void createMaterials();
 	void setMaterialSRVHeapHandles();
 	void createRenderItems();
+	void assignDrawSortIds();
+	void sortRenderItems();
+	void printDrawSortBenchmark();
+	void updateInstanceBatches();
+	void createIndirectCommandSignature();
+	void updateIndirectArguments();
 	void createFrameResources();
-	void createFrameResourceConstantBufferViews();
 
 	/// ڴбİ
 	/// \param type: б
@@ -219,7 +346,7 @@ private:
 	/// \param depthStencilDescriptorHeap: ڴ/ģ建ͼ
 	/// \param depthStencilBuffer: /ģ建
 	void createDepthStencilView(uint32_t width, uint32_t height, DXGI_FORMAT format,
-								const ComPtr<ID3D12DescriptorHeap>& depthStencilDescriptorHeap, 
+								D3D12_CPU_DESCRIPTOR_HANDLE depthStencilViewHandle, 
 								ComPtr<ID3D12Resource>& depthStencilBuffer);
 
 	/// ڴѵİ
@@ -241,11 +368,11 @@ private:
 	/// ڴSRVİ
 	/// \param dimension: SRVά(1D, 2D, CUBE)
 	/// \param texture: ڴSRVԴ
-	/// \param descriptorHeap: ڴSRV
-	/// \param index: е
-	void createShaderResourceView(TextureDimension dimension, const ComPtr<ID3D12Resource>& texture, const ComPtr<ID3D12DescriptorHeap>& descriptorHeap, uint32_t index = 0);
+	/// \param descriptorHandle: SRVдλ(ͨݴ)
+	void createShaderResourceView(TextureDimension dimension, const ComPtr<ID3D12Resource>& texture, D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandle, uint32_t componentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING);
 
 	std::unique_ptr<struct MeshGeometry> createMeshGeometry(const DXModel& model);
+	std::unique_ptr<struct MeshGeometry> createMeshGeometry(const std::shared_ptr<ModelAsset>& asset, const std::string& name);
 	void createMeshDataGeometry(const GeometryGenerator::MeshData& meshData, const std::string& name);
 	void createOceanMeshGeometry();
 	void createTreeSpritesGeometry(uint32_t treeCount);
@@ -274,23 +401,30 @@ private:
 
 	void processInput(float deltaTime);
 	void render();
+	void buildRenderGraph();
+	void renderScenePass();
+	void renderImGuiPass();
 
 	void renderScene();
+	void renderSkybox(StateCachedCommandList<ID3D12GraphicsCommandList>& commandList);
+	void buildScenePasses();
+	void bindScenePass(StateCachedCommandList<ID3D12GraphicsCommandList>& commandList, const ScenePass& pass);
+	void drawScenePass(StateCachedCommandList<ID3D12GraphicsCommandList>& commandList, const ScenePass& pass, uint32_t begin, uint32_t end);
+	void recordSceneParallel(const D3D12_CPU_DESCRIPTOR_HANDLE& renderTargetView, const D3D12_CPU_DESCRIPTOR_HANDLE& depthStencilView);
 
 	void present();
 
 	void executeCommandLists();
 
 	void advanceFrameResourceFence();
+	void recordFrameTelemetry(std::chrono::steady_clock::time_point submitTime);
 
-	void beginRenderTargetTransition(const ComPtr<ID3D12Resource>& renderTarget);
-	void endRenderTargetTransition(const ComPtr<ID3D12Resource>& renderTarget);
-
-	void resourceTransition(const ComPtr<ID3D12Resource>& resource, D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter);
+	void beginCommandList();
+	void releaseSubmittedCommandLists();
 
-	void resetFrameResourceCommandAllocator();
-
-	void drawRenderItems(const ComPtr<ID3D12GraphicsCommandList>& commandList, const std::vector<RenderItem*>& renderItmes);
+	void drawRenderItems(StateCachedCommandList<ID3D12GraphicsCommandList>& commandList, const std::vector<RenderItem*>& renderItmes, uint32_t begin, uint32_t end);
+	void drawInstanceBatches(StateCachedCommandList<ID3D12GraphicsCommandList>& commandList, const std::vector<RenderItem*>& renderItmes, uint32_t begin, uint32_t end);
+	void drawIndirect(StateCachedCommandList<ID3D12GraphicsCommandList>& commandList, uint32_t begin, uint32_t end);
 
 	void waitCommandListComplete();
 
@@ -334,10 +468,17 @@ private:
 	uint32_t imGuiCurrentFrameIndex = 0;
 	uint32_t frame = 0;
 
+	// ʱԽCPUԽٵȴGPU뵽ӳҲԽ
+	uint32_t frameResourceCount = DefaultFrameResourceCount;
 	std::vector<std::unique_ptr<FrameResource>> frameResources;
 	FrameResource* currentFrameResource = nullptr;
 	uint32_t currentFrameResourceIndex = 0;
 
+	// ÿ֡CPUȴGPUʱ䡢GPU֡ʹӶȡ뵽ύӳ
+	FrameTelemetry frameTelemetry;
+	std::chrono::steady_clock::time_point frameInputTime;
+	double frameWaitMilliseconds = 0.0;
+
 	RenderItem* wavesRenderItem = nullptr;
 	RenderItem* sphereRenderItem = nullptr;
 	RenderItem* reflectedSphereRenderItem = nullptr;
@@ -349,6 +490,57 @@ private:
 	// Render items divided by PSO.
 	std::vector<RenderItem*> renderItemLayer[(int)RenderLayer::Count];
 
+	// renderItemLayer in draw order, rebuilt every frame from the sort keys.
+	std::vector<RenderItem*> sortedRenderItemLayer[(int)RenderLayer::Count];
+	std::vector<uint64_t> drawSortKeys;
+	RadixSorter drawSorter;
+
+	// ͸㰴(, , , PSO)ϲɵʵƣԼÿ峣GPUַ
+	InstanceBatcher instanceBatcher;
+	std::vector<D3D12_GPU_VIRTUAL_ADDRESS> instanceBatchAddresses;
+	std::vector<ObjectConstants> instanceConstants;
+
+	// ͸ļӻ֡ǩԼһ֡дõĲͷ
+	IndirectCommandLayout indirectCommandLayout;
+	uint32_t indirectObjectArgument = 0;
+	uint32_t indirectMaterialArgument = 0;
+	uint32_t indirectVertexBufferArgument = 0;
+	uint32_t indirectIndexBufferArgument = 0;
+	uint32_t indirectDrawArgument = 0;
+	ComPtr<ID3D12CommandSignature> indirectCommandSignature;
+	DynamicAllocation indirectArguments;
+	std::vector<IndirectDrawGroup> indirectDrawGroups;
+
+	// ÿ֡¹ݸpassĶдԶ
+	RenderGraph renderGraph;
+
+	// Ⱦͼ֮Դ()ĵǰ״̬״̬תŶӣʹǰһύ
+	ResourceStateTracker resourceStateTracker;
+
+	// ݴ(CPU)ѺΨһɫɼѣʱ黹ҲҪ֮ǰ
+	std::unique_ptr<StagingDescriptorHeap> renderTargetViewHeap;
+	std::unique_ptr<StagingDescriptorHeap> depthStencilViewHeap;
+	std::unique_ptr<StagingDescriptorHeap> shaderResourceViewHeap;
+	std::unique_ptr<ShaderVisibleDescriptorHeap> shaderVisibleDescriptorHeap;
+
+	D3D12Lite::Descriptor renderTargetViewDescriptors[FrameBackbufferCount];
+	D3D12Lite::Descriptor depthStencilViewDescriptor;
+	D3D12Lite::Descriptor renderTextureRTVDescriptor;
+	D3D12Lite::Descriptor renderTextureDSVDescriptor;
+	D3D12Lite::Descriptor renderTextureSRVDescriptor;
+
+	// ÿ֡Ļƽ׶Σύ˳
+	std::vector<ScenePass> scenePasses;
+
+	// һôλʱֵٷָһ߳
+	static constexpr uint32_t MinRecordingChunkSize = 64;
+
+	std::unique_ptr<TaskScheduler> recordingScheduler;
+
+	// ÿ¼һбһ״̬ת
+	std::vector<PooledCommandList> recordingCommandLists;
+	std::vector<CommandListStateStatistics> recordingStatistics;
+
 	std::unique_ptr<Waves> waves;
 
 	uint32_t DXGIFactoryFlags = 0;
@@ -357,10 +549,7 @@ private:
 	uint32_t SRVCBVUAVDescriptorSize = 0;
 	uint32_t samplerDescriptorSize = 0;
 
-	uint32_t passConstantBufferViewOffset = 0;
 	uint32_t textureCount = 0;
-	uint32_t objectCount = 0;
-	uint32_t materialCount = 0;
 
 	uint32_t currentSamplerNo = 0;		//ǰʹõĲ
 	uint32_t sampleMaxCount = 5;		//͵Ĳ
@@ -395,33 +584,29 @@ private:
 	// DXR stuff
 	//ComPtr<IDXGISwapChain4> swapChain;
 	ComPtr<IDXGISwapChain> swapChain;
-	ComPtr<ID3D12DescriptorHeap> renderTargetViewDescriptorHeap;
-	ComPtr<ID3D12DescriptorHeap> renderTextureRTVDescriptorHeap;
-	ComPtr<ID3D12DescriptorHeap> shaderResourceViewDescriptorHeap;
-	ComPtr<ID3D12DescriptorHeap> renderTextureSRVDescriptorHeap;
-	ComPtr<ID3D12DescriptorHeap> imGuiShaderResourceViewDescriptorHeap;
 	ComPtr<ID3D12DescriptorHeap> samplerDescriptorHeap;
-	ComPtr<ID3D12DescriptorHeap> depthStencilViewDescriptorHeap;
-	ComPtr<ID3D12DescriptorHeap> renderTextureDSVDescriptorHeap;
 	ComPtr<ID3D12Resource> renderTargets[FrameBackbufferCount];
 	ComPtr<ID3D12Resource> imGuiRenderTargets[FrameBackbufferCount];
-	ComPtr<ID3D12CommandAllocator> commandAllocatorDirectPre;
-	ComPtr<ID3D12CommandAllocator> commandAllocatorDirectPost;
-	ComPtr<ID3D12CommandAllocator> commandAllocatorDirectImGui;
 	ComPtr<ID3D12CommandAllocator> commandAllocatorSkybox;
 	ComPtr<ID3D12CommandAllocator> commandAllocatorScene;
-	ComPtr<ID3D12CommandAllocator> commandAllocatorRenderTextureObject;
 	ComPtr<ID3D12RootSignature> rootSignature;
 	ComPtr<ID3D12RootSignature> renderTextureRootSignature;
+	// лǩĹϣPSOǩָ
+	uint64_t rootSignatureHash = 0;
 	ComPtr<ID3D12PipelineState> skyboxGraphicsPipelineState;
 	ComPtr<ID3D12PipelineState> renderTextureGraphicsPipelineState;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> pipelineStates;
+	// PSOĹϣȥأڹ߳ϲдͨ߿⻺浽
+	std::unique_ptr<PipelineStateCache> pipelineStateCache;
+	// ̵߳ǰ¼ебcommandListDirectPreָб
+	std::unique_ptr<CommandListPool> commandListPool;
+	PooledCommandList directCommandList;
 	ComPtr<ID3D12GraphicsCommandList> commandListDirectPre;
-	ComPtr<ID3D12GraphicsCommandList> commandListDirectPost;
-	ComPtr<ID3D12GraphicsCommandList> commandListDirectImGui;
 	ComPtr<ID3D12GraphicsCommandList> skyboxBundle;
 	ComPtr<ID3D12GraphicsCommandList> sceneBundle;
-	ComPtr<ID3D12GraphicsCommandList> renderTextureObject;
+
+	// ѾύȴһΧֵб
+	std::vector<PooledCommandList> submittedCommandLists;
 	std::vector<ID3D12CommandList*> commandlists;
 	ComPtr<ID3D12Resource> vertexBuffer;
 	ComPtr<ID3D12Resource> indexBuffer;
@@ -429,21 +614,99 @@ private:
 	ComPtr<ID3D12Resource> renderTextureConstantBuffer;
 	ComPtr<ID3D12Resource> depthStencilBuffer;
 	ComPtr<ID3D12Resource> renderTexture;
-	ComPtr<ID3D12Resource> renderTextureDepthStencilBuffer;
+	// ȾȻֻڳpassʹãȾͼʱԴֻ¼DSVָԴ
+	D3D12_RESOURCE_DESC renderTextureDepthStencilDesc{};
+	D3D12_RESOURCE_ALLOCATION_INFO renderTextureDepthStencilAllocation{};
+	ID3D12Resource* renderTextureDSVResource = nullptr;
 	ComPtr<ID3D12Fence> fence;
 
+	// Ĭ϶ӷ䣬ÿһ
+	HeapAllocator textureHeapAllocator{ 64 * 1024 * 1024 };
+	std::vector<ComPtr<ID3D12Heap>> textureHeaps;
+
+	// 㻺ͬӻרõĴӷ
+	HeapAllocator bufferHeapAllocator{ 64 * 1024 * 1024 };
+	std::vector<ComPtr<ID3D12Heap>> bufferHeaps;
+
+	// ĶڼĻУÿͨbaseVertexLocationstartIndexLocationλ
+	struct GeometryPage
+	{
+		ComPtr<ID3D12Resource> vertexBuffer;
+		ComPtr<ID3D12Resource> indexBuffer;
+		HeapAllocation vertexAllocation;
+		HeapAllocation indexAllocation;
+	};
+
+	GeometryPool geometryPool{ 16 * 1024 * 1024, 4 * 1024 * 1024 };
+	std::vector<GeometryPage> geometryPages;
+
+	// ģͺ淶·ݹϣ棬ÿļֻϴһ
+	// ֻãԴͷ(黹ѺͼصĿռ)һʱУ
+	// ķҪгԴĳԱ֮ǰ
+	AssetCache<ModelAsset> modelCache;
+	AssetCache<TextureAsset> textureCache;
+
+	// ͨ2DDDSʱֻMipβϸMipĻϵĴС֡룬Ԥʱûõ
+	// ֻפMipػ򻻳ʱ½һСʵMipGPUϸƹȥµMipӳļϴ
+	struct StreamedTexture
+	{
+		std::wstring name;
+		// ͷźʽ
+		std::weak_ptr<TextureAsset> asset;
+		// ļӳ䣬ԴָиMip
+		MappedFile file;
+		std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+		// ȫMip
+		D3D12_RESOURCE_DESC desc{};
+		// ϸMip
+		uint32_t residentMip = 0;
+	};
+
+	static constexpr uint32_t StreamingTailSize = 64;
+	static constexpr uint64_t StreamingBudget = 32 * 1024 * 1024;
+	static constexpr uint64_t MaxStreamingBytesPerFrame = 4 * 1024 * 1024;
+	TextureStreamer textureStreamer{ StreamingBudget };
+	// StreamedTextureId
+	std::vector<std::unique_ptr<StreamedTexture>> streamedTextures;
+	uint64_t streamingFrame = 0;
+
 	std::unordered_map<std::string, std::unique_ptr<Material>> materials;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> textures;
 	std::unordered_map<std::string, ComPtr<IDxcBlob>> shaders;
+	// õDXILݹϣڴϣֻcompileOnTheFlyʱʹ
+	std::unique_ptr<ShaderCache> shaderCache;
+	// ÿɫֵ֧ԣõϲŻ
+	std::unique_ptr<ShaderPermutations> shaderPermutations;
+	// shadersÿֶӦı
+	std::vector<std::pair<std::string, ShaderCompileParameters>> shaderPrograms;
+
+	// ɫأļ仯ֻ±ɫں̨߳ϱʹPSO
+	// ɺ֡ı߽滻滻PSOGPUͷţҪȴGPU
+	static constexpr std::chrono::milliseconds ShaderWatchInterval{ 500 };
+	ShaderDependencyGraph shaderDependencyGraph{ { "Assets/Shaders" } };
+	FileWatcher shaderFileWatcher;
+	std::chrono::steady_clock::time_point shaderWatchTime;
+	std::unique_ptr<TaskScheduler> shaderReloadScheduler;
+	// ±shaderPrograms±
+	std::vector<size_t> reloadingShaderPrograms;
+	// ±滻ɫPSOʧʱȥ
+	std::unordered_map<std::string, ComPtr<IDxcBlob>> replacedShaders;
+	std::future<std::vector<std::vector<uint8_t>>> shaderReloadCompilation;
+	std::future<void> shaderReloadPipelineStates;
+	uint32_t shaderReloadCount = 0;
+
+	// 滻GPUܻʹõԴPSOͶѿռ䣬ȵΧֵɺͷ
+	// صѿռ仹ķҪ֮
+	DeferredReleaseQueue deferredReleases;
 
-	ComPtr<ID3D12Heap> textureHeap;
 	ComPtr<ID3D12Heap> uploadHeap;
 
-	ComPtr<ID3D12DescriptorHeap> skyboxDescriptorHeap;
-	ComPtr<ID3D12DescriptorHeap> skyboxSamplerDescriptorHeap;
+	// פӳϴ壬ϴλз
+	ComPtr<ID3D12Resource> stagingBuffer;
+	uint8_t* stagingBufferData = nullptr;
+	StagingRing stagingRing;
 
 	ComPtr<ID3D12Heap> skyboxUploadHeap;
-	ComPtr<ID3D12Resource> skyboxTextureUploadBuffer;
 	ComPtr<ID3D12Resource> skyboxConstantBuffer;
 	ComPtr<ID3D12Resource> skyboxPassConstantBuffer;
 	ComPtr<ID3D12Resource> skyboxVertexBuffer;
@@ -486,8 +749,6 @@ private:
 	float sunTheta = glm::pi<float>() * 0.625f;
 	float sunPhi = glm::pi<float>() * 0.8f;
 
-	uint64_t textureUploadBufferSize = 0;
-	uint64_t skyboxTextureUploadBufferSize = 0;
 	uint32_t vertexBufferSize = 0;
 	uint32_t indexBufferSize = 0;
 	uint32_t skyboxVertexBufferSize = 0;
@@ -502,6 +763,9 @@ private:
 	uint32_t skyboxIndexCount = 0;
 	uint32_t triangleCount = 0;
 
+	// һ֡¼ʱʵдͱ˵״̬
+	CommandListStateStatistics renderStateStatistics;
+
 	glm::vec2 lastMousePosition;
 
 	bool appPaused = false;
@@ -513,7 +777,19 @@ private:
 	bool rightMouseButtonDown = false;
 	bool middleMouseButtonDown = false;
 	bool compileOnTheFly = true;
+	bool shaderHotReload = true;
+	// BCѹÿʱҪCPU±룬ĬϹرգҪԱԴռʱٴ
+	bool compressTextures = false;
+	// ÿѹ0(RMSE/PSNR)
+	bool reportCompressionError = false;
 	bool wireframe = false;
+	bool sortDraws = true;
+	bool parallelRecording = true;
+	// жģͺ󼸺˿նһ֡ʼʱ
+	bool geometryDefragmentPending = false;
+	DrawSubmission opaqueSubmission = DrawSubmission::Instanced;
+	// ѡύʽһupdateʼʱЧͬһ֡ĳκͻõͬһַʽ
+	DrawSubmission selectedOpaqueSubmission = DrawSubmission::Instanced;
 
 	ObjectConstants* objectConstants;
 	ObjectConstants* skyboxConstants;
@@ -524,10 +800,10 @@ private:
 	PassConstants reflectedPassConstants;
 
 	DXModel cubeModel;
-	DXModel cube;
-	DXModel bunny;
-	DXModel skybox;
-	DXModel marry;
+	std::shared_ptr<ModelAsset> cube;
+	std::shared_ptr<ModelAsset> bunny;
+	std::shared_ptr<ModelAsset> skybox;
+	std::shared_ptr<ModelAsset> marry;
 
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> meshGeometries;
 
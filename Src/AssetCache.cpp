@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "AssetCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+	constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	constexpr uint64_t Prime3 = 0x165667B19E3779F9ull;
+
+	uint64_t rotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	uint64_t mix(uint64_t hash, uint64_t value)
+	{
+		hash ^= rotateLeft(value * Prime2, 31) * Prime1;
+		return rotateLeft(hash, 27) * Prime1 + Prime3;
+	}
+}
+
+std::string normalizeAssetPath(const std::filesystem::path& path)
+{
+	auto normalized = path.lexically_normal().generic_string();
+
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char character)
+	{
+		return static_cast<char>(std::tolower(character));
+	});
+
+	return normalized;
+}
+
+uint64_t hashAssetContent(const void* data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = Prime3 ^ (static_cast<uint64_t>(size) * Prime1);
+
+	// Four independent lanes over 32 byte blocks keep the multiplies pipelined
+	uint64_t lanes[4] = { hash + Prime1, hash + Prime2, hash, hash - Prime1 };
+
+	size_t offset = 0;
+
+	for (; offset + 32 <= size; offset += 32)
+	{
+		for (int lane = 0; lane < 4; lane++)
+		{
+			uint64_t value = 0;
+			std::memcpy(&value, bytes + offset + lane * 8, sizeof(value));
+			lanes[lane] = mix(lanes[lane], value);
+		}
+	}
+
+	for (auto lane : lanes)
+	{
+		hash = mix(hash, lane);
+	}
+
+	for (; offset + 8 <= size; offset += 8)
+	{
+		uint64_t value = 0;
+		std::memcpy(&value, bytes + offset, sizeof(value));
+		hash = mix(hash, value);
+	}
+
+	if (offset < size)
+	{
+		uint64_t tail = 0;
+		std::memcpy(&tail, bytes + offset, size - offset);
+		hash = mix(hash, tail);
+	}
+
+	// Final avalanche
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+	hash *= Prime3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
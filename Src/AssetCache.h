@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "MappedFile.h"
+
+// Lexically normalized, forward slashes and lower case, so "Assets\\Models\\..\\Models\\Cube.obj"
+// and "assets/models/cube.obj" name the same asset.
+std::string normalizeAssetPath(const std::filesystem::path& path);
+
+// Fast non-cryptographic 64 bit hash of a file's content.
+uint64_t hashAssetContent(const void* data, size_t size);
+
+struct AssetCacheStatistics
+{
+	// Same normalized path as a live asset.
+	uint64_t pathHits = 0;
+	// Different path, but the same content as a live asset.
+	uint64_t contentHits = 0;
+	// Decoded and uploaded.
+	uint64_t misses = 0;
+	uint32_t liveAssets = 0;
+
+	uint64_t hits() const { return pathHits + contentHits; }
+};
+
+// Hands out shared handles to assets keyed by normalized path and by content hash, so each file
+// is decoded and uploaded once however many names it is loaded under. The cache only holds weak
+// references: an asset is released (through the deleter its creator gave the shared_ptr) when the
+// last handle goes away, and the next load creates it again. Loads of one file with different
+// parameters (compression, view dimension...) make different assets and never share.
+template <typename T>
+class AssetCache
+{
+public:
+	using Creator = std::function<std::shared_ptr<T>()>;
+
+	// Returns the live asset loaded from path or from a file with identical content,
+	// otherwise calls create. Files that can not be read are only keyed by path.
+	std::shared_ptr<T> load(const std::filesystem::path& path, const Creator& create)
+	{
+		return load(path, 0, create);
+	}
+
+	// parameters packs whatever besides the file decides the asset's content.
+	std::shared_ptr<T> load(const std::filesystem::path& path, uint64_t parameters, const Creator& create)
+	{
+		auto key = normalizeAssetPath(path);
+
+		if (parameters != 0)
+		{
+			key += '?' + std::to_string(parameters);
+		}
+
+		auto pathEntry = mPaths.find(key);
+
+		if (pathEntry != mPaths.end())
+		{
+			if (auto asset = pathEntry->second.asset.lock())
+			{
+				mStatistics.pathHits++;
+				return asset;
+			}
+		}
+
+		ContentKey content;
+		MappedFile file;
+
+		if (file.open(path))
+		{
+			content.hash = hashAssetContent(file.data(), file.size());
+			content.size = file.size();
+			content.parameters = parameters;
+			content.valid = true;
+		}
+
+		file.close();
+
+		if (content.valid)
+		{
+			auto contentEntry = mContents.find(content.key());
+
+			if (contentEntry != mContents.end() && contentEntry->second.size == content.size && contentEntry->second.parameters == parameters)
+			{
+				if (auto asset = contentEntry->second.asset.lock())
+				{
+					mStatistics.contentHits++;
+					mPaths[key] = { asset, content };
+					return asset;
+				}
+			}
+		}
+
+		mStatistics.misses++;
+
+		auto asset = create();
+
+		if (asset)
+		{
+			mPaths[key] = { asset, content };
+
+			if (content.valid)
+			{
+				mContents[content.key()] = { asset, content.size, parameters };
+			}
+		}
+
+		return asset;
+	}
+
+	// Drops the entries of released assets.
+	void prune()
+	{
+		for (auto iterator = mPaths.begin(); iterator != mPaths.end();)
+		{
+			iterator = iterator->second.asset.expired() ? mPaths.erase(iterator) : std::next(iterator);
+		}
+
+		for (auto iterator = mContents.begin(); iterator != mContents.end();)
+		{
+			iterator = iterator->second.asset.expired() ? mContents.erase(iterator) : std::next(iterator);
+		}
+	}
+
+	AssetCacheStatistics statistics() const
+	{
+		auto statistics = mStatistics;
+
+		// Several paths may share one asset
+		std::unordered_set<const T*> liveAssets;
+
+		for (const auto& path : mPaths)
+		{
+			if (auto asset = path.second.asset.lock())
+			{
+				liveAssets.insert(asset.get());
+			}
+		}
+
+		statistics.liveAssets = static_cast<uint32_t>(liveAssets.size());
+
+		return statistics;
+	}
+
+private:
+	struct ContentKey
+	{
+		uint64_t hash = 0;
+		size_t size = 0;
+		uint64_t parameters = 0;
+		bool valid = false;
+
+		uint64_t key() const { return hash ^ (parameters * 0x9E3779B97F4A7C15ull); }
+	};
+
+	struct PathEntry
+	{
+		std::weak_ptr<T> asset;
+		ContentKey content;
+	};
+
+	struct ContentEntry
+	{
+		std::weak_ptr<T> asset;
+		size_t size = 0;
+		uint64_t parameters = 0;
+	};
+
+	std::unordered_map<std::string, PathEntry> mPaths;
+	std::unordered_map<uint64_t, ContentEntry> mContents;
+	AssetCacheStatistics mStatistics;
+};
@@ -0,0 +1,1086 @@
+#include "pch.h"
+#include "BCEncoder.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BC_ENCODER_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t MinBlockRowsPerThread = 2;
+
+	// 16 texels of a 4x4 block in structure of arrays layout, values in 0-255.
+	struct Block
+	{
+		alignas(16) float channels[4][16];
+	};
+
+	struct DecodedBlock
+	{
+		uint8_t texels[16][4];
+	};
+
+	struct Endpoints
+	{
+		float values[2][4];
+	};
+
+	uint32_t refinementPasses(BCQuality quality)
+	{
+		switch (quality)
+		{
+		case BCQuality::Fast:
+			return 0;
+		case BCQuality::Normal:
+			return 1;
+		case BCQuality::High:
+			return 4;
+		}
+
+		return 1;
+	}
+
+	uint8_t toByte(float value)
+	{
+		return static_cast<uint8_t>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+	}
+
+	void loadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, uint32_t blockX, uint32_t blockY, Block& block)
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			const auto* row = pixels + std::min(blockY * 4 + y, height - 1) * rowPitch;
+
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				const auto* texel = row + std::min(blockX * 4 + x, width - 1) * 4;
+
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					block.channels[c][y * 4 + x] = texel[c];
+				}
+			}
+		}
+	}
+
+	// Picks the nearest palette entry for every texel over channels [firstChannel, firstChannel + channelCount).
+	// Returns the summed squared error.
+	float selectIndices(const Block& block, uint32_t firstChannel, uint32_t channelCount, const float (*palette)[4], uint32_t paletteSize, uint8_t indices[16])
+	{
+		float totalError = 0.0f;
+
+#if BC_ENCODER_SSE
+		for (uint32_t group = 0; group < 16; group += 4)
+		{
+			auto bestError = _mm_set1_ps(FLT_MAX);
+			auto bestIndex = _mm_setzero_si128();
+
+			for (uint32_t i = 0; i < paletteSize; i++)
+			{
+				auto error = _mm_setzero_ps();
+
+				for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+				{
+					auto difference = _mm_sub_ps(_mm_load_ps(&block.channels[c][group]), _mm_set1_ps(palette[i][c]));
+					error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+				}
+
+				auto closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+				bestError = _mm_min_ps(error, bestError);
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int32_t>(i))), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			alignas(16) int32_t laneIndices[4];
+			alignas(16) float laneErrors[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(laneIndices), bestIndex);
+			_mm_store_ps(laneErrors, bestError);
+
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				indices[group + lane] = static_cast<uint8_t>(laneIndices[lane]);
+				totalError += laneErrors[lane];
+			}
+		}
+#else
+		for (uint32_t texel = 0; texel < 16; texel++)
+		{
+			auto bestError = FLT_MAX;
+
+			for (uint32_t i = 0; i < paletteSize; i++)
+			{
+				float error = 0.0f;
+
+				for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+				{
+					auto difference = block.channels[c][texel] - palette[i][c];
+					error += difference * difference;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					indices[texel] = static_cast<uint8_t>(i);
+				}
+			}
+
+			totalError += bestError;
+		}
+#endif
+
+		return totalError;
+	}
+
+	// Least squares endpoints for the given per texel interpolation weights (0 = first endpoint, 1 = second).
+	bool fitEndpoints(const Block& block, uint32_t firstChannel, uint32_t channelCount, const float weights[16], const bool* excluded, Endpoints& endpoints)
+	{
+		float aa = 0.0f;
+		float bb = 0.0f;
+		float ab = 0.0f;
+		float ax[4] = {};
+		float bx[4] = {};
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (excluded != nullptr && excluded[i])
+			{
+				continue;
+			}
+
+			auto b = weights[i];
+			auto a = 1.0f - b;
+
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+
+			for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+			{
+				ax[c] += a * block.channels[c][i];
+				bx[c] += b * block.channels[c][i];
+			}
+		}
+
+		auto determinant = aa * bb - ab * ab;
+
+		if (std::abs(determinant) < 1e-6f)
+		{
+			return false;
+		}
+
+		for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+		{
+			endpoints.values[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+			endpoints.values[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+		}
+
+		return true;
+	}
+
+	// Initial endpoints: the bounding box diagonal for Fast, the extent along the principal axis otherwise.
+	void initialEndpoints(const Block& block, uint32_t firstChannel, uint32_t channelCount, const bool* excluded, BCQuality quality, Endpoints& endpoints)
+	{
+		float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+		float maximum[4] = {};
+		float mean[4] = {};
+		float count = 0.0f;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (excluded != nullptr && excluded[i])
+			{
+				continue;
+			}
+
+			for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+			{
+				minimum[c] = std::min(minimum[c], block.channels[c][i]);
+				maximum[c] = std::max(maximum[c], block.channels[c][i]);
+				mean[c] += block.channels[c][i];
+			}
+
+			count++;
+		}
+
+		if (quality == BCQuality::Fast || count < 2.0f)
+		{
+			for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+			{
+				endpoints.values[0][c] = count > 0.0f ? minimum[c] : 0.0f;
+				endpoints.values[1][c] = count > 0.0f ? maximum[c] : 0.0f;
+			}
+
+			return;
+		}
+
+		float covariance[4][4] = {};
+
+		for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+		{
+			mean[c] /= count;
+		}
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (excluded != nullptr && excluded[i])
+			{
+				continue;
+			}
+
+			for (uint32_t r = firstChannel; r < firstChannel + channelCount; r++)
+			{
+				for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+				{
+					covariance[r][c] += (block.channels[r][i] - mean[r]) * (block.channels[c][i] - mean[c]);
+				}
+			}
+		}
+
+		// Power iteration, seeded with the bounding box diagonal
+		float axis[4] = {};
+
+		for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+		{
+			axis[c] = maximum[c] - minimum[c];
+		}
+
+		for (uint32_t iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+
+			for (uint32_t r = firstChannel; r < firstChannel + channelCount; r++)
+			{
+				for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+				{
+					next[r] += covariance[r][c] * axis[c];
+				}
+
+				length = std::max(length, std::abs(next[r]));
+			}
+
+			if (length < 1e-6f)
+			{
+				break;
+			}
+
+			for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+
+		auto minimumT = FLT_MAX;
+		auto maximumT = -FLT_MAX;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (excluded != nullptr && excluded[i])
+			{
+				continue;
+			}
+
+			float t = 0.0f;
+
+			for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+			{
+				t += (block.channels[c][i] - mean[c]) * axis[c];
+			}
+
+			minimumT = std::min(minimumT, t);
+			maximumT = std::max(maximumT, t);
+		}
+
+		float axisLengthSquared = 0.0f;
+
+		for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+		{
+			axisLengthSquared += axis[c] * axis[c];
+		}
+
+		if (axisLengthSquared < 1e-6f)
+		{
+			axisLengthSquared = 1.0f;
+		}
+
+		for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++)
+		{
+			endpoints.values[0][c] = std::clamp(mean[c] + axis[c] * minimumT / axisLengthSquared, 0.0f, 255.0f);
+			endpoints.values[1][c] = std::clamp(mean[c] + axis[c] * maximumT / axisLengthSquared, 0.0f, 255.0f);
+		}
+	}
+
+	//
+	// BC1 color block
+	//
+
+	uint16_t packRGB565(const float color[4])
+	{
+		auto r = static_cast<uint16_t>(std::clamp(color[0] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+		auto g = static_cast<uint16_t>(std::clamp(color[1] * 63.0f / 255.0f + 0.5f, 0.0f, 63.0f));
+		auto b = static_cast<uint16_t>(std::clamp(color[2] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void unpackRGB565(uint16_t value, float color[4])
+	{
+		uint32_t r = (value >> 11) & 31;
+		uint32_t g = (value >> 5) & 63;
+		uint32_t b = value & 31;
+
+		color[0] = static_cast<float>((r << 3) | (r >> 2));
+		color[1] = static_cast<float>((g << 2) | (g >> 4));
+		color[2] = static_cast<float>((b << 3) | (b >> 2));
+		color[3] = 255.0f;
+	}
+
+	void buildColorPalette(uint16_t color0, uint16_t color1, bool threeColor, float palette[4][4])
+	{
+		unpackRGB565(color0, palette[0]);
+		unpackRGB565(color1, palette[1]);
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			if (threeColor)
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2.0f;
+				palette[3][c] = 0.0f;
+			}
+			else
+			{
+				palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+				palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+			}
+		}
+
+		palette[2][3] = 255.0f;
+		palette[3][3] = threeColor ? 0.0f : 255.0f;
+	}
+
+	// Encodes the RGB of a block. With allowTransparent set, texels with alpha below 128
+	// use the 3 color mode's transparent index (BC1 only, BC3 always decodes 4 colors).
+	void encodeColorBlock(const Block& block, BCQuality quality, bool allowTransparent, uint8_t* output, DecodedBlock& decoded)
+	{
+		bool transparent[16] = {};
+		uint32_t transparentCount = 0;
+
+		if (allowTransparent)
+		{
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				transparent[i] = block.channels[3][i] < 128.0f;
+				transparentCount += transparent[i] ? 1 : 0;
+			}
+		}
+
+		const bool threeColor = transparentCount > 0;
+
+		Endpoints endpoints{};
+		initialEndpoints(block, 0, 3, transparent, quality, endpoints);
+
+		uint16_t bestColors[2] = {};
+		uint8_t bestIndices[16] = {};
+		auto bestError = FLT_MAX;
+
+		const float weights4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		const float weights3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+
+		for (uint32_t pass = 0; pass <= refinementPasses(quality); pass++)
+		{
+			auto color0 = packRGB565(endpoints.values[0]);
+			auto color1 = packRGB565(endpoints.values[1]);
+
+			// 4 color mode requires color0 > color1, 3 color mode color0 <= color1
+			if ((threeColor && color0 > color1) || (!threeColor && color0 < color1))
+			{
+				std::swap(color0, color1);
+			}
+
+			float palette[4][4];
+			buildColorPalette(color0, color1, threeColor, palette);
+
+			uint8_t indices[16];
+			auto error = selectIndices(block, 0, 3, palette, threeColor ? 3 : 4, indices);
+
+			if (threeColor)
+			{
+				// Transparent texels do not count towards the color error
+				error = 0.0f;
+
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					if (transparent[i])
+					{
+						indices[i] = 3;
+						continue;
+					}
+
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						auto difference = block.channels[c][i] - palette[indices[i]][c];
+						error += difference * difference;
+					}
+				}
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				bestColors[0] = color0;
+				bestColors[1] = color1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (transparentCount == 16)
+			{
+				break;
+			}
+
+			float indexWeights[16];
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				indexWeights[i] = threeColor ? weights3[indices[i]] : weights4[indices[i]];
+			}
+
+			if (!fitEndpoints(block, 0, 3, indexWeights, transparent, endpoints))
+			{
+				break;
+			}
+		}
+
+		uint32_t packedIndices = 0;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			packedIndices |= static_cast<uint32_t>(bestIndices[i]) << (i * 2);
+		}
+
+		memcpy(output, &bestColors[0], 2);
+		memcpy(output + 2, &bestColors[1], 2);
+		memcpy(output + 4, &packedIndices, 4);
+
+		float palette[4][4];
+		buildColorPalette(bestColors[0], bestColors[1], threeColor, palette);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				decoded.texels[i][c] = toByte(palette[bestIndices[i]][c]);
+			}
+		}
+	}
+
+	//
+	// BC4 single channel block, also the alpha block of BC3 and both halves of BC5
+	//
+
+	void buildChannelPalette(uint8_t value0, uint8_t value1, uint32_t channel, float palette[8][4])
+	{
+		float v0 = value0;
+		float v1 = value1;
+
+		palette[0][channel] = v0;
+		palette[1][channel] = v1;
+
+		if (value0 > value1)
+		{
+			for (uint32_t i = 1; i < 7; i++)
+			{
+				palette[i + 1][channel] = ((7 - i) * v0 + i * v1) / 7.0f;
+			}
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; i++)
+			{
+				palette[i + 1][channel] = ((5 - i) * v0 + i * v1) / 5.0f;
+			}
+
+			palette[6][channel] = 0.0f;
+			palette[7][channel] = 255.0f;
+		}
+	}
+
+	float indexWeight(uint8_t value0, uint8_t value1, uint8_t index)
+	{
+		if (index <= 1)
+		{
+			return static_cast<float>(index);
+		}
+
+		return value0 > value1 ? (index - 1) / 7.0f : (index - 1) / 5.0f;
+	}
+
+	struct ChannelCandidate
+	{
+		uint8_t values[2];
+		uint8_t indices[16];
+		float error;
+	};
+
+	void evaluateChannelCandidate(const Block& block, uint32_t channel, uint8_t value0, uint8_t value1, ChannelCandidate& candidate)
+	{
+		float palette[8][4];
+		buildChannelPalette(value0, value1, channel, palette);
+
+		candidate.values[0] = value0;
+		candidate.values[1] = value1;
+		candidate.error = selectIndices(block, channel, 1, palette, 8, candidate.indices);
+	}
+
+	// Refines a candidate while keeping its interpolation mode.
+	void refineChannelCandidate(const Block& block, uint32_t channel, uint32_t passes, ChannelCandidate& candidate)
+	{
+		const bool eightValues = candidate.values[0] > candidate.values[1];
+
+		for (uint32_t pass = 0; pass < passes; pass++)
+		{
+			float weights[16];
+			bool excluded[16] = {};
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				// The constant 0 and 255 entries of the 6 value mode are not interpolated
+				excluded[i] = !eightValues && candidate.indices[i] >= 6;
+				weights[i] = excluded[i] ? 0.0f : indexWeight(candidate.values[0], candidate.values[1], candidate.indices[i]);
+			}
+
+			Endpoints endpoints{};
+
+			if (!fitEndpoints(block, channel, 1, weights, excluded, endpoints))
+			{
+				return;
+			}
+
+			auto value0 = toByte(endpoints.values[0][channel]);
+			auto value1 = toByte(endpoints.values[1][channel]);
+
+			if ((value0 > value1) != eightValues)
+			{
+				std::swap(value0, value1);
+			}
+
+			if (eightValues && value0 == value1)
+			{
+				return;
+			}
+
+			ChannelCandidate refined;
+			evaluateChannelCandidate(block, channel, value0, value1, refined);
+
+			if (refined.error >= candidate.error)
+			{
+				return;
+			}
+
+			candidate = refined;
+		}
+	}
+
+	void encodeChannelBlock(const Block& block, uint32_t channel, BCQuality quality, uint8_t* output, DecodedBlock& decoded)
+	{
+		auto minimum = 255.0f;
+		auto maximum = 0.0f;
+		auto innerMinimum = 255.0f;
+		auto innerMaximum = 0.0f;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			auto value = block.channels[channel][i];
+			minimum = std::min(minimum, value);
+			maximum = std::max(maximum, value);
+
+			if (value > 0.0f && value < 255.0f)
+			{
+				innerMinimum = std::min(innerMinimum, value);
+				innerMaximum = std::max(innerMaximum, value);
+			}
+		}
+
+		// 8 value mode spanning the whole range
+		ChannelCandidate best;
+		evaluateChannelCandidate(block, channel, toByte(maximum), toByte(minimum), best);
+		refineChannelCandidate(block, channel, refinementPasses(quality), best);
+
+		// 6 value mode, which gets exact 0 and 255 for free
+		bool tryExtremes = quality == BCQuality::High || (quality == BCQuality::Normal && (minimum == 0.0f || maximum == 255.0f));
+
+		if (tryExtremes)
+		{
+			if (innerMinimum > innerMaximum)
+			{
+				innerMinimum = innerMaximum = 0.0f;
+			}
+
+			ChannelCandidate candidate;
+			evaluateChannelCandidate(block, channel, toByte(innerMinimum), toByte(innerMaximum), candidate);
+			refineChannelCandidate(block, channel, refinementPasses(quality), candidate);
+
+			if (candidate.error < best.error)
+			{
+				best = candidate;
+			}
+		}
+
+		uint64_t packedIndices = 0;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			packedIndices |= static_cast<uint64_t>(best.indices[i]) << (i * 3);
+		}
+
+		output[0] = best.values[0];
+		output[1] = best.values[1];
+
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			output[2 + i] = static_cast<uint8_t>(packedIndices >> (i * 8));
+		}
+
+		float palette[8][4];
+		buildChannelPalette(best.values[0], best.values[1], channel, palette);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			decoded.texels[i][channel] = toByte(palette[best.indices[i]][channel]);
+		}
+	}
+
+	//
+	// BC7 mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4 bit indices
+	//
+
+	const uint32_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Endpoints
+	{
+		uint8_t values[2][4];	// 7 bit
+		uint8_t pbits[2];
+	};
+
+	void quantizeBC7Endpoint(const float endpoint[4], uint8_t pbit, uint8_t values[4], float& error)
+	{
+		error = 0.0f;
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			auto value = static_cast<uint8_t>(std::clamp((endpoint[c] - pbit) / 2.0f + 0.5f, 0.0f, 127.0f));
+			auto difference = static_cast<float>((value << 1) | pbit) - endpoint[c];
+
+			values[c] = value;
+			error += difference * difference;
+		}
+	}
+
+	void buildBC7Palette(const BC7Endpoints& endpoints, float palette[16][4])
+	{
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			uint32_t value0 = (endpoints.values[0][c] << 1) | endpoints.pbits[0];
+			uint32_t value1 = (endpoints.values[1][c] << 1) | endpoints.pbits[1];
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				palette[i][c] = static_cast<float>(((64 - BC7Weights4[i]) * value0 + BC7Weights4[i] * value1 + 32) >> 6);
+			}
+		}
+	}
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8_t* output) : mOutput(output)
+		{
+			memset(mOutput, 0, 16);
+		}
+
+		void write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t i = 0; i < bitCount; i++, mPosition++)
+			{
+				mOutput[mPosition >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (mPosition & 7));
+			}
+		}
+
+	private:
+		uint8_t* mOutput;
+		uint32_t mPosition = 0;
+	};
+
+	void encodeBC7Block(const Block& block, BCQuality quality, uint8_t* output, DecodedBlock& decoded)
+	{
+		Endpoints endpoints{};
+		initialEndpoints(block, 0, 4, nullptr, quality, endpoints);
+
+		BC7Endpoints best{};
+		uint8_t bestIndices[16] = {};
+		auto bestError = FLT_MAX;
+
+		for (uint32_t pass = 0; pass <= refinementPasses(quality); pass++)
+		{
+			// Fast and Normal round each endpoint to its closest p-bit, High tries all four combinations
+			BC7Endpoints candidates[4];
+			uint32_t candidateCount = 0;
+
+			if (quality == BCQuality::High)
+			{
+				for (uint8_t pbits = 0; pbits < 4; pbits++)
+				{
+					auto& candidate = candidates[candidateCount++];
+					float error;
+					candidate.pbits[0] = pbits & 1;
+					candidate.pbits[1] = pbits >> 1;
+					quantizeBC7Endpoint(endpoints.values[0], candidate.pbits[0], candidate.values[0], error);
+					quantizeBC7Endpoint(endpoints.values[1], candidate.pbits[1], candidate.values[1], error);
+				}
+			}
+			else
+			{
+				auto& candidate = candidates[candidateCount++];
+
+				for (uint32_t e = 0; e < 2; e++)
+				{
+					uint8_t values[2][4];
+					float errors[2];
+					quantizeBC7Endpoint(endpoints.values[e], 0, values[0], errors[0]);
+					quantizeBC7Endpoint(endpoints.values[e], 1, values[1], errors[1]);
+
+					candidate.pbits[e] = errors[1] < errors[0] ? 1 : 0;
+					memcpy(candidate.values[e], values[candidate.pbits[e]], 4);
+				}
+			}
+
+			uint8_t indices[16];
+
+			for (uint32_t i = 0; i < candidateCount; i++)
+			{
+				float palette[16][4];
+				buildBC7Palette(candidates[i], palette);
+
+				auto error = selectIndices(block, 0, 4, palette, 16, indices);
+
+				if (error < bestError)
+				{
+					bestError = error;
+					best = candidates[i];
+					memcpy(bestIndices, indices, sizeof(indices));
+				}
+			}
+
+			float weights[16];
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				weights[i] = BC7Weights4[bestIndices[i]] / 64.0f;
+			}
+
+			if (!fitEndpoints(block, 0, 4, weights, nullptr, endpoints))
+			{
+				break;
+			}
+		}
+
+		// The anchor texel's index MSB is implicit 0, swap the endpoints so that it holds
+		if (bestIndices[0] >= 8)
+		{
+			std::swap(best.values[0], best.values[1]);
+			std::swap(best.pbits[0], best.pbits[1]);
+
+			for (auto& index : bestIndices)
+			{
+				index = 15 - index;
+			}
+		}
+
+		BitWriter writer(output);
+		writer.write(1 << 6, 7);
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			writer.write(best.values[0][c], 7);
+			writer.write(best.values[1][c], 7);
+		}
+
+		writer.write(best.pbits[0], 1);
+		writer.write(best.pbits[1], 1);
+		writer.write(bestIndices[0], 3);
+
+		for (uint32_t i = 1; i < 16; i++)
+		{
+			writer.write(bestIndices[i], 4);
+		}
+
+		float palette[16][4];
+		buildBC7Palette(best, palette);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				decoded.texels[i][c] = toByte(palette[bestIndices[i]][c]);
+			}
+		}
+	}
+
+	void encodeBlock(const Block& block, BCFormat format, BCQuality quality, uint8_t* output, DecodedBlock& decoded)
+	{
+		switch (format)
+		{
+		case BCFormat::BC1:
+			encodeColorBlock(block, quality, true, output, decoded);
+			break;
+		case BCFormat::BC3:
+			encodeColorBlock(block, quality, false, output + 8, decoded);
+			encodeChannelBlock(block, 3, quality, output, decoded);
+			break;
+		case BCFormat::BC4:
+			encodeChannelBlock(block, 0, quality, output, decoded);
+			break;
+		case BCFormat::BC5:
+			encodeChannelBlock(block, 0, quality, output, decoded);
+			encodeChannelBlock(block, 1, quality, output + 8, decoded);
+			break;
+		case BCFormat::BC7:
+			encodeBC7Block(block, quality, output, decoded);
+			break;
+		}
+	}
+
+	uint32_t reportedChannelCount(BCFormat format)
+	{
+		switch (format)
+		{
+		case BCFormat::BC4:
+			return 1;
+		case BCFormat::BC5:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	// Squared error sums of one worker, merged into the report at the end
+	struct ErrorAccumulator
+	{
+		double sums[4] = {};
+		uint64_t texelCount = 0;
+		uint64_t blockCount = 0;
+		uint32_t maxError = 0;
+	};
+}
+
+uint32_t getBCBlockSize(BCFormat format)
+{
+	return (format == BCFormat::BC1 || format == BCFormat::BC4) ? 8 : 16;
+}
+
+size_t getBCRowPitch(BCFormat format, uint32_t width)
+{
+	return static_cast<size_t>((width + 3) / 4) * getBCBlockSize(format);
+}
+
+size_t getBCImageSize(BCFormat format, uint32_t width, uint32_t height)
+{
+	return getBCRowPitch(format, width) * ((height + 3) / 4);
+}
+
+uint32_t getBCDXGIFormat(BCFormat format, bool sRGB)
+{
+	// DXGI_FORMAT_BC1_UNORM = 71 ... DXGI_FORMAT_BC7_UNORM_SRGB = 99
+	switch (format)
+	{
+	case BCFormat::BC1:
+		return sRGB ? 72 : 71;
+	case BCFormat::BC3:
+		return sRGB ? 78 : 77;
+	case BCFormat::BC4:
+		return 80;
+	case BCFormat::BC5:
+		return 83;
+	case BCFormat::BC7:
+		return sRGB ? 99 : 98;
+	}
+
+	return 0;
+}
+
+bool hasTransparency(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch)
+{
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const auto* row = pixels + y * rowPitch;
+
+		for (uint32_t x = 0; x < width; x++)
+		{
+			if (row[x * 4 + 3] < 255)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+BCErrorReport encodeBC(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+					   BCFormat format, uint8_t* destination, size_t destinationRowPitch,
+					   const BCEncodeOptions& options)
+{
+	const auto blocksWide = (width + 3) / 4;
+	const auto blocksHigh = (height + 3) / 4;
+	const auto blockSize = getBCBlockSize(format);
+	const auto channelCount = reportedChannelCount(format);
+
+	ErrorAccumulator total;
+	std::mutex totalMutex;
+
+	parallelFor(blocksHigh, options.threadCount, MinBlockRowsPerThread, [&](uint32_t begin, uint32_t end)
+	{
+		ErrorAccumulator accumulator;
+		Block block;
+
+		for (auto blockY = begin; blockY < end; blockY++)
+		{
+			auto* output = destination + blockY * destinationRowPitch;
+
+			for (uint32_t blockX = 0; blockX < blocksWide; blockX++)
+			{
+				loadBlock(pixels, width, height, rowPitch, blockX, blockY, block);
+
+				DecodedBlock decoded{};
+				encodeBlock(block, format, options.quality, output + blockX * blockSize, decoded);
+
+				// Only texels inside the image count, not the replicated padding
+				for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+				{
+					for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+					{
+						auto texel = y * 4 + x;
+
+						for (uint32_t c = 0; c < channelCount; c++)
+						{
+							auto error = static_cast<uint32_t>(std::abs(static_cast<int32_t>(decoded.texels[texel][c]) - static_cast<int32_t>(block.channels[c][texel])));
+							accumulator.sums[c] += static_cast<double>(error) * error;
+							accumulator.maxError = std::max(accumulator.maxError, error);
+						}
+
+						accumulator.texelCount++;
+					}
+				}
+
+				accumulator.blockCount++;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(totalMutex);
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			total.sums[c] += accumulator.sums[c];
+		}
+
+		total.texelCount += accumulator.texelCount;
+		total.blockCount += accumulator.blockCount;
+		total.maxError = std::max(total.maxError, accumulator.maxError);
+	});
+
+	BCErrorReport report;
+	report.blockCount = total.blockCount;
+	report.maxError = total.maxError;
+
+	double meanSquaredError = 0.0;
+
+	for (uint32_t c = 0; c < channelCount; c++)
+	{
+		report.mse[c] = total.texelCount > 0 ? total.sums[c] / total.texelCount : 0.0;
+		meanSquaredError += report.mse[c] / channelCount;
+	}
+
+	report.rmse = std::sqrt(meanSquaredError);
+	report.psnr = meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+
+	return report;
+}
+
+bool saveBCImageToDDS(const std::filesystem::path& path, BCFormat format, bool sRGB, const std::vector<BCImage>& mipLevels)
+{
+	if (mipLevels.empty())
+	{
+		return false;
+	}
+
+	// DDS_HEADER followed by DDS_HEADER_DXT10, see DDS.h in DirectXTex
+	struct DDSFile
+	{
+		uint32_t magic;
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[11];
+		uint32_t pixelFormatSize;
+		uint32_t pixelFormatFlags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t bitMasks[4];
+		uint32_t caps;
+		uint32_t caps2;
+		uint32_t caps3;
+		uint32_t caps4;
+		uint32_t reserved2;
+		uint32_t dxgiFormat;
+		uint32_t resourceDimension;
+		uint32_t miscFlag;
+		uint32_t arraySize;
+		uint32_t miscFlags2;
+	};
+
+	static_assert(sizeof(DDSFile) == 4 + 124 + 20, "Unexpected DDS header size");
+
+	DDSFile header{};
+	header.magic = 0x20534444;				// "DDS "
+	header.size = 124;
+	header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | 0x20000;	// CAPS | HEIGHT | WIDTH | PIXELFORMAT | LINEARSIZE | MIPMAPCOUNT
+	header.height = mipLevels[0].height;
+	header.width = mipLevels[0].width;
+	header.pitchOrLinearSize = static_cast<uint32_t>(mipLevels[0].data.size());
+	header.mipMapCount = static_cast<uint32_t>(mipLevels.size());
+	header.pixelFormatSize = 32;
+	header.pixelFormatFlags = 0x4;			// DDPF_FOURCC
+	header.fourCC = 0x30315844;				// "DX10"
+	header.caps = 0x1000 | (mipLevels.size() > 1 ? 0x8 | 0x400000 : 0);	// TEXTURE | COMPLEX | MIPMAP
+	header.dxgiFormat = getBCDXGIFormat(format, sRGB);
+	header.resourceDimension = 3;			// D3D10_RESOURCE_DIMENSION_TEXTURE2D
+	header.arraySize = 1;
+
+	std::ofstream file(path, std::ios::binary);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const auto& mipLevel : mipLevels)
+	{
+		file.write(reinterpret_cast<const char*>(mipLevel.data.data()), mipLevel.data.size());
+	}
+
+	return static_cast<bool>(file);
+}
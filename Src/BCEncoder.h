@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+enum class BCFormat
+{
+	BC1,	// RGB + 1 bit alpha, 8 bytes per block
+	BC3,	// RGBA, 16 bytes per block
+	BC4,	// R, 8 bytes per block
+	BC5,	// RG, 16 bytes per block
+	BC7		// RGBA, 16 bytes per block (mode 6 only)
+};
+
+enum class BCQuality
+{
+	// Bounding box endpoints, no refinement.
+	Fast,
+	// Principal axis endpoints with one least squares refinement.
+	Normal,
+	// Several refinement passes and an exhaustive mode / p-bit search.
+	High
+};
+
+struct BCEncodeOptions
+{
+	BCQuality quality = BCQuality::Normal;
+
+	// 0 uses std::thread::hardware_concurrency().
+	uint32_t threadCount = 0;
+};
+
+// Error of the decoded blocks against the source, over the channels the format stores.
+struct BCErrorReport
+{
+	// Mean squared error per RGBA channel, in 0-255 units.
+	double mse[4] = {};
+	double rmse = 0.0;
+	double psnr = 0.0;
+	uint32_t maxError = 0;
+	uint64_t blockCount = 0;
+};
+
+uint32_t getBCBlockSize(BCFormat format);
+
+// Bytes of one row of 4x4 blocks.
+size_t getBCRowPitch(BCFormat format, uint32_t width);
+
+size_t getBCImageSize(BCFormat format, uint32_t width, uint32_t height);
+
+// The matching DXGI_FORMAT value, kept as an integer so this header does not need the Windows SDK.
+uint32_t getBCDXGIFormat(BCFormat format, bool sRGB);
+
+// True when any texel has alpha below 255, used to choose between BC1 and BC3/BC7.
+bool hasTransparency(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch);
+
+// Compresses a RGBA8 image into destination, writing block row y at destination + y * destinationRowPitch.
+// BC4 encodes R and BC5 encodes RG. Sizes that are not multiples of 4 replicate the edge texels.
+// Block rows are split across worker threads and the index search uses SSE when available.
+BCErrorReport encodeBC(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+					   BCFormat format, uint8_t* destination, size_t destinationRowPitch,
+					   const BCEncodeOptions& options = {});
+
+struct BCImage
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> data;
+};
+
+// Writes a DDS file (DX10 header) with one BCImage per mip level, for offline conversion.
+bool saveBCImageToDDS(const std::filesystem::path& path, BCFormat format, bool sRGB, const std::vector<BCImage>& mipLevels);
@@ -0,0 +1,61 @@
+#include "pch.h"
+#include "CommandListPool.h"
+#include "DXException.h"
+
+#include <cassert>
+
+CommandListPool::CommandListPool(ID3D12Device* device, uint32_t threadCount)
+: mDevice(device), mPools(threadCount)
+{
+}
+
+PooledCommandList CommandListPool::acquire(uint32_t threadIndex, D3D12_COMMAND_LIST_TYPE type, uint64_t completedFenceValue, ID3D12PipelineState* initialState)
+{
+	assert(threadIndex < mPools.size() && static_cast<uint32_t>(type) < CommandListTypeCount);
+
+	auto commandList = mPools[threadIndex][type].acquire(completedFenceValue, [this, threadIndex, type]() { return create(threadIndex, type); });
+
+	// The GPU is done with everything recorded into the allocator, and its list is closed
+	DXCheck(commandList.commandAllocator->Reset(), L"ID3D12CommandAllocator::Reset failed!");
+	DXCheck(commandList.commandList->Reset(commandList.commandAllocator.Get(), initialState), L"ID3D12GraphicsCommandList::Reset failed!");
+
+	return commandList;
+}
+
+void CommandListPool::release(PooledCommandList commandList, uint64_t fenceValue)
+{
+	auto threadIndex = commandList.threadIndex;
+	auto type = commandList.type;
+
+	mPools[threadIndex][type].retire(std::move(commandList), fenceValue);
+}
+
+FencedRecyclerStatistics CommandListPool::statistics(D3D12_COMMAND_LIST_TYPE type) const
+{
+	FencedRecyclerStatistics statistics;
+
+	for (const auto& pools : mPools)
+	{
+		statistics.add(pools[type].statistics());
+	}
+
+	return statistics;
+}
+
+PooledCommandList CommandListPool::create(uint32_t threadIndex, D3D12_COMMAND_LIST_TYPE type)
+{
+	PooledCommandList commandList;
+	commandList.threadIndex = threadIndex;
+	commandList.type = type;
+
+	DXCheck(mDevice->CreateCommandAllocator(type, IID_PPV_ARGS(&commandList.commandAllocator)), L"ID3D12Device::CreateCommandAllocator failed!");
+	DXCheck(mDevice->CreateCommandList(0, type, commandList.commandAllocator.Get(), nullptr, IID_PPV_ARGS(&commandList.commandList)), L"ID3D12Device::CreateCommandList failed!");
+
+	setD3D12DebugNameIndexd(commandList.commandAllocator.Get(), L"PooledCommandAllocator", threadIndex);
+	setD3D12DebugNameIndexd(commandList.commandList.Get(), L"PooledCommandList", threadIndex);
+
+	// New lists start open, acquire() resets them like the recycled ones
+	DXCheck(commandList.commandList->Close(), L"ID3D12GraphicsCommandList::Close failed!");
+
+	return commandList;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "FencedRecycler.h"
+
+// A command allocator with the command list that records into it. They are handed out and
+// recycled together, so a list never has to look for a free allocator.
+struct PooledCommandList
+{
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
+
+	uint32_t threadIndex = 0;
+	D3D12_COMMAND_LIST_TYPE type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+};
+
+// Hands out allocator + list pairs per recording thread and command list type. A pair goes back
+// to the pool tagged with the fence value signaled after its submission and is reset for another
+// frame only once that value has completed, so no frame has to wait for an allocator of its own.
+// Each thread index has its own pools: acquire() needs no lock as long as every thread only passes
+// its own index, release() and statistics() must not overlap with acquisitions of the same thread.
+class CommandListPool
+{
+public:
+	CommandListPool(ID3D12Device* device, uint32_t threadCount);
+	CommandListPool(const CommandListPool& rhs) = delete;
+	CommandListPool& operator=(const CommandListPool& rhs) = delete;
+
+	// Returns a pair whose list is reset and open for recording.
+	PooledCommandList acquire(uint32_t threadIndex, D3D12_COMMAND_LIST_TYPE type, uint64_t completedFenceValue, ID3D12PipelineState* initialState = nullptr);
+
+	// Takes back a pair whose list was closed and submitted before fenceValue was signaled.
+	void release(PooledCommandList commandList, uint64_t fenceValue);
+
+	uint32_t threadCount() const { return static_cast<uint32_t>(mPools.size()); }
+
+	// Summed over all threads, except highWaterMark: the peak of the busiest thread.
+	FencedRecyclerStatistics statistics(D3D12_COMMAND_LIST_TYPE type) const;
+
+private:
+	// DIRECT, BUNDLE, COMPUTE and COPY
+	static constexpr uint32_t CommandListTypeCount = 4;
+
+	PooledCommandList create(uint32_t threadIndex, D3D12_COMMAND_LIST_TYPE type);
+
+	ID3D12Device* mDevice = nullptr;
+	std::vector<std::array<FencedRecycler<PooledCommandList>, CommandListTypeCount>> mPools;
+};
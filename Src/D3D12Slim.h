@@ -2,12 +2,16 @@
 
 #include <d3d12.h>
 #include <dxgi1_6.h>
+#include <wrl.h>
 #include <cstdint>
+#include <climits>
 #include <array>
 #include <cassert>
 
 namespace D3D12Lite
 {
+	using Microsoft::WRL::ComPtr;
+
 	constexpr uint32_t NUM_FRAMES_IN_FLIGHT = 2;
 	constexpr uint32_t NUM_BACK_BUFFERS = 3;
 	constexpr uint32_t NUM_RTV_STAGING_DESCRIPTORS = 256;
@@ -25,9 +29,9 @@ namespace D3D12Lite
 	constexpr uint32_t NUM_SRV_RENDER_PASS_USER_DESCRIPTORS = 65536;
 	constexpr uint32_t INVALID_RESOURCE_TABLE_INDEX = UINT_MAX;
 	constexpr uint32_t MAX_TEXTURE_SUBRESOURCE_COUNT = 32;
-	static const wchar_t* SHADER_SOURCE_PATH = L"Shaders/";
-	static const wchar_t* SHADER_OUTPUT_PATH = L"Shaders/Compiled/";
-	static const char* RESOURCE_PATH = "Resources/";
+	constexpr const wchar_t* SHADER_SOURCE_PATH = L"Shaders/";
+	constexpr const wchar_t* SHADER_OUTPUT_PATH = L"Shaders/Compiled/";
+	constexpr const char* RESOURCE_PATH = "Resources/";
 
 	using SubResourceLayouts = std::array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT, MAX_TEXTURE_SUBRESOURCE_COUNT>;
 
@@ -172,7 +176,7 @@ namespace D3D12Lite
 		void SetMappedData(void* data, size_t dataSize)
 		{
 			assert(mMappedResource != nullptr && data != nullptr && dataSize > 0 && dataSize <= mDesc.Width);
-			memcpy_s(mMappedResource, mDesc.Width, data, dataSize);
+			memcpy(mMappedResource, data, dataSize);
 		}
 
 		uint8_t* mMappedResource = nullptr;
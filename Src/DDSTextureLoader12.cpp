@@ -1236,7 +1236,8 @@ namespace
         DXGI_FORMAT format,
         D3D12_RESOURCE_FLAGS resFlags,
         DDS_LOADER_FLAGS loadFlags,
-        _Outptr_ ID3D12Resource** texture) noexcept
+        _Outptr_opt_ ID3D12Resource** texture,
+        _Out_opt_ D3D12_RESOURCE_DESC* outDesc) noexcept
     {
         if (!d3dDevice)
             return E_POINTER;
@@ -1263,6 +1264,17 @@ namespace
         desc.SampleDesc.Quality = 0;
         desc.Dimension = resDim;
 
+        if (outDesc)
+        {
+            *outDesc = desc;
+        }
+
+        // Only describing the texture
+        if (!texture)
+        {
+            return S_OK;
+        }
+
         const CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
 
         hr = d3dDevice->CreateCommittedResource(
@@ -1291,7 +1303,8 @@ namespace
         size_t maxsize,
         D3D12_RESOURCE_FLAGS resFlags,
         DDS_LOADER_FLAGS loadFlags,
-        _Outptr_ ID3D12Resource** texture,
+        _Outptr_opt_ ID3D12Resource** texture,
+        _Out_opt_ D3D12_RESOURCE_DESC* outDesc,
         std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
         _Out_opt_ bool* outIsCubeMap) noexcept(false)
     {
@@ -1508,7 +1521,7 @@ namespace
             }
 
             hr = CreateTextureResource(d3dDevice, resDim, twidth, theight, tdepth, reservedMips - skipMip, arraySize,
-                format, resFlags, loadFlags, texture);
+                format, resFlags, loadFlags, texture, outDesc);
 
             if (FAILED(hr) && !maxsize && (mipCount > 1))
             {
@@ -1526,7 +1539,7 @@ namespace
                 if (SUCCEEDED(hr))
                 {
                     hr = CreateTextureResource(d3dDevice, resDim, twidth, theight, tdepth, mipCount - skipMip, arraySize,
-                        format, resFlags, loadFlags, texture);
+                        format, resFlags, loadFlags, texture, outDesc);
                 }
             }
         }
@@ -1671,7 +1684,7 @@ HRESULT DirectX::LoadDDSTextureFromMemoryEx(
     hr = CreateTextureFromDDS(d3dDevice,
         header, bitData, bitSize, maxsize,
         resFlags, loadFlags,
-        texture, subresources, isCubeMap);
+        texture, nullptr, subresources, isCubeMap);
     if (SUCCEEDED(hr))
     {
         SetDebugObjectName(*texture, L"DDSTextureLoader");
@@ -1684,6 +1697,63 @@ HRESULT DirectX::LoadDDSTextureFromMemoryEx(
 }
 
 
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadDDSTextureDescFromMemory(
+    ID3D12Device* d3dDevice,
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    size_t maxsize,
+    DDS_LOADER_FLAGS loadFlags,
+    D3D12_RESOURCE_DESC* desc,
+    std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+    DDS_ALPHA_MODE* alphaMode,
+    bool* isCubeMap)
+{
+    if (alphaMode)
+    {
+        *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+    }
+    if (isCubeMap)
+    {
+        *isCubeMap = false;
+    }
+
+    if (!d3dDevice || !ddsData || !desc)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Validate DDS file in memory
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+
+    HRESULT hr = LoadTextureDataFromMemory(ddsData,
+        ddsDataSize,
+        &header,
+        &bitData,
+        &bitSize
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = CreateTextureFromDDS(d3dDevice,
+        header, bitData, bitSize, maxsize,
+        D3D12_RESOURCE_FLAG_NONE, loadFlags,
+        nullptr, desc, subresources, isCubeMap);
+    if (SUCCEEDED(hr))
+    {
+        if (alphaMode)
+            *alphaMode = GetAlphaMode(header);
+    }
+
+    return hr;
+}
+
+
 //--------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT DirectX::LoadDDSTextureFromFile(
@@ -1758,7 +1828,7 @@ HRESULT DirectX::LoadDDSTextureFromFileEx(
     hr = CreateTextureFromDDS(d3dDevice,
         header, bitData, bitSize, maxsize,
         resFlags, loadFlags,
-        texture, subresources, isCubeMap);
+        texture, nullptr, subresources, isCubeMap);
 
     if (SUCCEEDED(hr))
     {
@@ -111,6 +111,19 @@ namespace DirectX
         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
         _Out_opt_ bool* isCubeMap = nullptr);
 
+    // Parses like LoadDDSTextureFromMemoryEx but only describes the texture instead of creating
+    // a committed resource, so the caller can place it in a heap of its own
+    HRESULT __cdecl LoadDDSTextureDescFromMemory(
+        _In_ ID3D12Device* d3dDevice,
+        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+        size_t ddsDataSize,
+        size_t maxsize,
+        DDS_LOADER_FLAGS loadFlags,
+        _Out_ D3D12_RESOURCE_DESC* desc,
+        std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+        _Out_opt_ bool* isCubeMap = nullptr);
+
     HRESULT __cdecl LoadDDSTextureFromFileEx(
         _In_ ID3D12Device* d3dDevice,
         _In_z_ const wchar_t* szFileName,
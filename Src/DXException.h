@@ -0,0 +1,57 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <string>
+
+// The error handling and debug name helpers of Utils.h, for modules that need nothing else from it.
+// Utils.h includes this header, so code that already includes Utils.h is unaffected.
+
+#define WIDE(x) L##x
+#define WIDE1(x) WIDE(x)
+#define FILE_NAME WIDE1(__FILE__)
+#ifdef _MSC_VER
+#define FUNCTION_NAME WIDE1(__FUNCTION__)
+#else
+// __FUNCTION__ is not a macro elsewhere, so it can not be pasted into a wide literal
+#define FUNCTION_NAME std::wstring(__func__, __func__ + std::char_traits<char>::length(__func__))
+#endif
+#define ObjectName(object) L#object
+
+inline void setD3D12DebugName(ID3D12Object * object, const std::wstring& name)
+{
+	object->SetName(name.c_str());
+}
+
+#define setD3D12DebugNameComPtr(object) setD3D12DebugName(object.Get(), ObjectName(object));
+
+inline void setD3D12DebugNameIndexd(ID3D12Object* object, const std::wstring& name, uint32_t index)
+{
+	auto fullName = name + L"[" + std::to_wstring(index) + L"]";
+	object->SetName(fullName.c_str());
+}
+
+class DXException
+{
+public:
+	DXException() = default;
+	DXException(HRESULT hr, const std::wstring& inFunctionName, const std::wstring& inFilename, int inLineNumber, const std::wstring& inErrorMessage = L"")
+	: errorCode(hr), functionName(inFunctionName), filename(inFilename), lineNumber(inLineNumber), errorMessage(inErrorMessage)
+	{
+	}
+
+	// Defined in Utils.cpp
+	std::wstring ToWString() const;
+	std::string ToString() const;
+
+	HRESULT errorCode = S_OK;
+	std::wstring functionName;
+	std::wstring filename;
+	int lineNumber = -1;
+	std::wstring errorMessage;
+};
+
+#define DXThrow(result, message) throw DXException(result, FUNCTION_NAME, FILE_NAME, __LINE__, message);
+
+#define DXCheck(result, message) if (FAILED(result)) { DXThrow(result, message); }
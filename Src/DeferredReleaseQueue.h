@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+struct DeferredReleaseStatistics
+{
+	// Objects and callbacks ever retired, and the ones released so far.
+	size_t retiredCount = 0;
+	size_t releasedCount = 0;
+
+	// Waiting for their fence value now, and the most that ever did at once.
+	size_t pendingCount = 0;
+	size_t highWaterMark = 0;
+};
+
+// Things the CPU is done with but the GPU may still be reading: resources replaced by a resize,
+// PSOs replaced by a shader reload, heap ranges and descriptors of freed buffers. Each is tagged
+// with a fence value signaled after its last use and kept until the caller reports that value as
+// completed, so replacing a resource never needs to wait for the GPU to go idle. Fence values
+// passed to retire() must not decrease. Like FencedRecycler it knows nothing about D3D12.
+class DeferredReleaseQueue
+{
+public:
+	DeferredReleaseQueue() = default;
+	DeferredReleaseQueue(const DeferredReleaseQueue& rhs) = delete;
+	DeferredReleaseQueue& operator=(const DeferredReleaseQueue& rhs) = delete;
+
+	~DeferredReleaseQueue()
+	{
+		releaseAll();
+	}
+
+	// Keeps object, typically a ComPtr, alive until fenceValue is completed.
+	template <typename T>
+	void retire(T object, uint64_t fenceValue)
+	{
+		push(std::make_unique<RetiredObject<T>>(std::move(object)), fenceValue);
+	}
+
+	// Calls release() once fenceValue is completed, for frees that are not a destructor,
+	// such as a range going back to a heap allocator.
+	template <typename Release>
+	void defer(Release release, uint64_t fenceValue)
+	{
+		push(std::make_unique<DeferredCall<Release>>(std::move(release)), fenceValue);
+	}
+
+	// Releases everything whose fence value is <= completedFenceValue, oldest first.
+	size_t releaseCompleted(uint64_t completedFenceValue)
+	{
+		size_t count = 0;
+
+		while (!mPending.empty() && mPending.front().fenceValue <= completedFenceValue)
+		{
+			mPending.pop_front();
+			count++;
+		}
+
+		mStatistics.releasedCount += count;
+
+		return count;
+	}
+
+	// Releases everything, only valid once the GPU is idle.
+	void releaseAll()
+	{
+		releaseCompleted(UINT64_MAX);
+	}
+
+	size_t pendingCount() const { return mPending.size(); }
+
+	DeferredReleaseStatistics statistics() const
+	{
+		auto statistics = mStatistics;
+		statistics.pendingCount = mPending.size();
+
+		return statistics;
+	}
+
+private:
+	struct Retired
+	{
+		virtual ~Retired() = default;
+	};
+
+	template <typename T>
+	struct RetiredObject : Retired
+	{
+		explicit RetiredObject(T inObject) : object(std::move(inObject)) {}
+
+		T object;
+	};
+
+	template <typename Release>
+	struct DeferredCall : Retired
+	{
+		explicit DeferredCall(Release inRelease) : release(std::move(inRelease)) {}
+		~DeferredCall() override { release(); }
+
+		Release release;
+	};
+
+	struct Entry
+	{
+		uint64_t fenceValue = 0;
+		std::unique_ptr<Retired> item;
+	};
+
+	void push(std::unique_ptr<Retired> item, uint64_t fenceValue)
+	{
+		assert(mPending.empty() || mPending.back().fenceValue <= fenceValue);
+
+		mPending.push_back({ fenceValue, std::move(item) });
+
+		mStatistics.retiredCount++;
+		mStatistics.highWaterMark = std::max(mStatistics.highWaterMark, mPending.size());
+	}
+
+	std::deque<Entry> mPending;
+	DeferredReleaseStatistics mStatistics;
+};
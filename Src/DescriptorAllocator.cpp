@@ -0,0 +1,237 @@
+#include "pch.h"
+#include "DescriptorAllocator.h"
+#include "DXException.h"
+
+#include <algorithm>
+#include <cassert>
+
+DescriptorFreeList::DescriptorFreeList(uint32_t first, uint32_t count)
+: mFirst(first), mCount(count), mAllocated(count, false)
+{
+}
+
+uint32_t DescriptorFreeList::allocate()
+{
+	uint32_t index = InvalidDescriptorIndex;
+
+	if (!mFreeIndices.empty())
+	{
+		index = mFreeIndices.back();
+		mFreeIndices.pop_back();
+	}
+	else if (mNextUnused < mCount)
+	{
+		index = mFirst + mNextUnused++;
+	}
+	else
+	{
+		return InvalidDescriptorIndex;
+	}
+
+	mAllocated[index - mFirst] = true;
+	mAllocatedCount++;
+	mHighWaterMark = std::max(mHighWaterMark, mAllocatedCount);
+
+	return index;
+}
+
+void DescriptorFreeList::free(uint32_t index)
+{
+	assert(index >= mFirst && index - mFirst < mCount && mAllocated[index - mFirst]);
+
+	mAllocated[index - mFirst] = false;
+	release(index);
+}
+
+void DescriptorFreeList::freeDeferred(uint32_t index, uint64_t fenceValue)
+{
+	assert(index >= mFirst && index - mFirst < mCount && mAllocated[index - mFirst]);
+	assert(mDeferredFrees.empty() || mDeferredFrees.back().fenceValue <= fenceValue);
+
+	mAllocated[index - mFirst] = false;
+	mDeferredFrees.push_back({ fenceValue, index });
+}
+
+void DescriptorFreeList::releaseCompleted(uint64_t completedFenceValue)
+{
+	while (!mDeferredFrees.empty() && mDeferredFrees.front().fenceValue <= completedFenceValue)
+	{
+		release(mDeferredFrees.front().index);
+		mDeferredFrees.pop_front();
+	}
+}
+
+void DescriptorFreeList::release(uint32_t index)
+{
+	mAllocatedCount--;
+	mFreeIndices.push_back(index);
+}
+
+DescriptorAllocatorStatistics DescriptorFreeList::statistics() const
+{
+	DescriptorAllocatorStatistics statistics;
+	statistics.capacity = mCount;
+	statistics.allocatedCount = mAllocatedCount;
+	statistics.pendingFreeCount = static_cast<uint32_t>(mDeferredFrees.size());
+	statistics.highWaterMark = mHighWaterMark;
+
+	return statistics;
+}
+
+DescriptorLinearAllocator::DescriptorLinearAllocator(uint32_t first, uint32_t count, uint32_t frameCount)
+: mFirst(first), mSegmentSize(count / frameCount), mFrames(frameCount, LinearAllocator(count / frameCount))
+{
+	assert(frameCount > 0);
+}
+
+void DescriptorLinearAllocator::beginFrame(uint32_t frameIndex)
+{
+	assert(frameIndex < mFrames.size());
+
+	mFrameIndex = frameIndex;
+	mFrames[mFrameIndex].reset();
+}
+
+uint32_t DescriptorLinearAllocator::allocate(uint32_t count)
+{
+	auto offset = mFrames[mFrameIndex].allocate(count);
+
+	if (offset == LinearAllocator::InvalidOffset)
+	{
+		return InvalidDescriptorIndex;
+	}
+
+	mHighWaterMark = std::max(mHighWaterMark, static_cast<uint32_t>(mFrames[mFrameIndex].usedSize()));
+
+	return mFirst + mFrameIndex * mSegmentSize + static_cast<uint32_t>(offset);
+}
+
+DescriptorAllocatorStatistics DescriptorLinearAllocator::statistics() const
+{
+	DescriptorAllocatorStatistics statistics;
+	statistics.capacity = mSegmentSize;
+	statistics.allocatedCount = mFrames.empty() ? 0 : static_cast<uint32_t>(mFrames[mFrameIndex].usedSize());
+	statistics.highWaterMark = mHighWaterMark;
+
+	return statistics;
+}
+
+StagingDescriptorHeap::StagingDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t count, const wchar_t* name)
+: mType(type), mFreeList(0, count)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc{};
+	descriptorHeapDesc.Type = type;
+	descriptorHeapDesc.NumDescriptors = count;
+	descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+	DXCheck(device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&mHeap)), L"ID3D12Device::CreateDescriptorHeap failed!");
+	mHeap->SetName(name);
+
+	mCPUStart = mHeap->GetCPUDescriptorHandleForHeapStart();
+	mDescriptorSize = device->GetDescriptorHandleIncrementSize(type);
+}
+
+D3D12Lite::Descriptor StagingDescriptorHeap::allocate()
+{
+	auto index = mFreeList.allocate();
+
+	if (index == InvalidDescriptorIndex)
+	{
+		DXThrow(E_OUTOFMEMORY, L"Staging descriptor heap is full!");
+	}
+
+	D3D12Lite::Descriptor descriptor;
+	descriptor.mCPUHandle.ptr = mCPUStart.ptr + static_cast<size_t>(index) * mDescriptorSize;
+	descriptor.mHeapIndex = index;
+
+	return descriptor;
+}
+
+void StagingDescriptorHeap::free(D3D12Lite::Descriptor& descriptor)
+{
+	if (descriptor.IsValid())
+	{
+		mFreeList.free(descriptor.mHeapIndex);
+		descriptor = {};
+	}
+}
+
+ShaderVisibleDescriptorHeap::ShaderVisibleDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t reservedCount, uint32_t persistentCount,
+														 uint32_t perFrameCount, uint32_t frameCount, const wchar_t* name)
+: mDevice(device), mType(type), mPersistent(reservedCount, persistentCount - reservedCount), mPerFrame(persistentCount, perFrameCount, frameCount)
+{
+	assert(reservedCount <= persistentCount);
+
+	D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc{};
+	descriptorHeapDesc.Type = type;
+	descriptorHeapDesc.NumDescriptors = persistentCount + perFrameCount;
+	descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+	DXCheck(device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&mHeap)), L"ID3D12Device::CreateDescriptorHeap failed!");
+	mHeap->SetName(name);
+
+	mCPUStart = mHeap->GetCPUDescriptorHandleForHeapStart();
+	mGPUStart = mHeap->GetGPUDescriptorHandleForHeapStart();
+	mDescriptorSize = device->GetDescriptorHandleIncrementSize(type);
+}
+
+D3D12Lite::Descriptor ShaderVisibleDescriptorHeap::descriptor(uint32_t index) const
+{
+	D3D12Lite::Descriptor descriptor;
+	descriptor.mCPUHandle.ptr = mCPUStart.ptr + static_cast<size_t>(index) * mDescriptorSize;
+	descriptor.mGPUHandle.ptr = mGPUStart.ptr + static_cast<uint64_t>(index) * mDescriptorSize;
+	descriptor.mHeapIndex = index;
+
+	return descriptor;
+}
+
+D3D12Lite::Descriptor ShaderVisibleDescriptorHeap::allocatePersistent(const D3D12Lite::Descriptor& staging)
+{
+	assert(staging.IsValid());
+
+	auto index = mPersistent.allocate();
+
+	if (index == InvalidDescriptorIndex)
+	{
+		DXThrow(E_OUTOFMEMORY, L"Bindless descriptor range is full!");
+	}
+
+	auto persistent = descriptor(index);
+	mDevice->CopyDescriptorsSimple(1, persistent.mCPUHandle, staging.mCPUHandle, mType);
+
+	return persistent;
+}
+
+void ShaderVisibleDescriptorHeap::freePersistent(D3D12Lite::Descriptor& descriptor, uint64_t fenceValue)
+{
+	if (descriptor.IsValid())
+	{
+		mPersistent.freeDeferred(descriptor.mHeapIndex, fenceValue);
+		descriptor = {};
+	}
+}
+
+D3D12Lite::Descriptor ShaderVisibleDescriptorHeap::allocateFrameTable(const D3D12Lite::Descriptor* staging, uint32_t count)
+{
+	auto index = mPerFrame.allocate(count);
+
+	if (index == InvalidDescriptorIndex)
+	{
+		DXThrow(E_OUTOFMEMORY, L"Per frame descriptor range is full!");
+	}
+
+	auto table = descriptor(index);
+
+	// One destination range, one source range per staging descriptor since they need not be adjacent
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> sourceHandles(count);
+	std::vector<uint32_t> sourceSizes(count, 1);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		sourceHandles[i] = staging[i].mCPUHandle;
+	}
+
+	mDevice->CopyDescriptors(1, &table.mCPUHandle, &count, count, sourceHandles.data(), sourceSizes.data(), mType);
+
+	return table;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "D3D12Slim.h"
+#include "LinearAllocator.h"
+
+constexpr uint32_t InvalidDescriptorIndex = D3D12Lite::INVALID_RESOURCE_TABLE_INDEX;
+
+struct DescriptorAllocatorStatistics
+{
+	uint32_t capacity = 0;
+
+	// Indices handed out and not returned yet, freeDeferred() ones count until their fence value completes
+	uint32_t allocatedCount = 0;
+	uint32_t pendingFreeCount = 0;
+
+	// Most indices ever allocated at the same time
+	uint32_t highWaterMark = 0;
+};
+
+// Hands out single indices of [first, first + count) and takes them back in any order, the most
+// recently freed index is reused first. An index the GPU may still read goes back through
+// freeDeferred() and only becomes free once releaseCompleted() sees its fence value completed.
+// Like StagingRing it knows nothing about D3D12.
+class DescriptorFreeList
+{
+public:
+	DescriptorFreeList() = default;
+	DescriptorFreeList(uint32_t first, uint32_t count);
+
+	// Returns InvalidDescriptorIndex when every index is in use.
+	uint32_t allocate();
+
+	void free(uint32_t index);
+
+	// Fence values passed here must not decrease.
+	void freeDeferred(uint32_t index, uint64_t fenceValue);
+
+	// Frees every deferred index whose fence value is <= completedFenceValue.
+	void releaseCompleted(uint64_t completedFenceValue);
+
+	uint32_t first() const { return mFirst; }
+	uint32_t count() const { return mCount; }
+
+	DescriptorAllocatorStatistics statistics() const;
+
+private:
+	struct DeferredFree
+	{
+		uint64_t fenceValue = 0;
+		uint32_t index = 0;
+	};
+
+	// Makes the index available to allocate() again
+	void release(uint32_t index);
+
+	uint32_t mFirst = 0;
+	uint32_t mCount = 0;
+
+	// Indices below this were handed out at least once, the ones above never were
+	uint32_t mNextUnused = 0;
+	std::vector<uint32_t> mFreeIndices;
+	std::deque<DeferredFree> mDeferredFrees;
+
+	// Catches double frees, one flag per index. Cleared by free() and freeDeferred() alike, so an
+	// index waiting for its fence can not be freed a second time either.
+	std::vector<bool> mAllocated;
+
+	uint32_t mAllocatedCount = 0;
+	uint32_t mHighWaterMark = 0;
+};
+
+// Contiguous runs of indices for descriptor tables that are rebuilt every frame. [first, first + count)
+// is split into one segment per frame in flight, beginFrame() drops what the frame allocated the
+// last time it was current, so the caller has to wait for that frame first.
+class DescriptorLinearAllocator
+{
+public:
+	DescriptorLinearAllocator() = default;
+	DescriptorLinearAllocator(uint32_t first, uint32_t count, uint32_t frameCount);
+
+	void beginFrame(uint32_t frameIndex);
+
+	// Returns the first of count contiguous indices, InvalidDescriptorIndex when the frame's segment is full.
+	uint32_t allocate(uint32_t count = 1);
+
+	uint32_t frameCount() const { return static_cast<uint32_t>(mFrames.size()); }
+	uint32_t segmentSize() const { return mSegmentSize; }
+
+	// Capacity and use of the current frame's segment
+	DescriptorAllocatorStatistics statistics() const;
+
+private:
+	uint32_t mFirst = 0;
+	uint32_t mSegmentSize = 0;
+	uint32_t mFrameIndex = 0;
+	std::vector<LinearAllocator> mFrames;
+	uint32_t mHighWaterMark = 0;
+};
+
+// CPU only heap the views are created in (RTV, DSV, and SRV/CBV/UAV views that are copied to
+// ShaderVisibleDescriptorHeap). The GPU never reads these descriptors: OMSetRenderTargets and
+// CopyDescriptors read them while recording, so free() takes them back right away.
+class StagingDescriptorHeap
+{
+public:
+	StagingDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t count, const wchar_t* name);
+	StagingDescriptorHeap(const StagingDescriptorHeap& rhs) = delete;
+	StagingDescriptorHeap& operator=(const StagingDescriptorHeap& rhs) = delete;
+
+	// Throws when the heap is full.
+	D3D12Lite::Descriptor allocate();
+
+	// Resets descriptor, freeing an invalid one does nothing.
+	void free(D3D12Lite::Descriptor& descriptor);
+
+	D3D12_DESCRIPTOR_HEAP_TYPE type() const { return mType; }
+
+	DescriptorAllocatorStatistics statistics() const { return mFreeList.statistics(); }
+
+private:
+	D3D12_DESCRIPTOR_HEAP_TYPE mType;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mHeap;
+	D3D12_CPU_DESCRIPTOR_HANDLE mCPUStart{};
+	uint32_t mDescriptorSize = 0;
+	DescriptorFreeList mFreeList;
+};
+
+// The shader visible CBV/SRV/UAV (or sampler) heap, bound once for the whole frame:
+//   [0, reservedCount)                              fixed slots such as the ImGui font texture,
+//   [reservedCount, persistentCount)                bindless range, one slot per view for as long as it lives,
+//   [persistentCount, persistentCount + frameCount) per frame tables, split between the frames in flight.
+// Persistent slots the GPU may still read are freed with the fence value that covers the last
+// submission using them. Views are created in a StagingDescriptorHeap and copied here.
+class ShaderVisibleDescriptorHeap
+{
+public:
+	ShaderVisibleDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t reservedCount, uint32_t persistentCount,
+								uint32_t perFrameCount, uint32_t frameCount, const wchar_t* name);
+	ShaderVisibleDescriptorHeap(const ShaderVisibleDescriptorHeap& rhs) = delete;
+	ShaderVisibleDescriptorHeap& operator=(const ShaderVisibleDescriptorHeap& rhs) = delete;
+
+	ID3D12DescriptorHeap* heap() const { return mHeap.Get(); }
+
+	// Any slot of the heap, mostly for the reserved ones.
+	D3D12Lite::Descriptor descriptor(uint32_t index) const;
+
+	// A bindless slot holding a copy of staging. Throws when the range is full.
+	D3D12Lite::Descriptor allocatePersistent(const D3D12Lite::Descriptor& staging);
+
+	// Resets descriptor, the slot is reused once fenceValue has completed.
+	void freePersistent(D3D12Lite::Descriptor& descriptor, uint64_t fenceValue);
+
+	void releaseCompleted(uint64_t completedFenceValue) { mPersistent.releaseCompleted(completedFenceValue); }
+
+	// Starts reusing the per frame segment of frameIndex, whose previous submission must have completed.
+	void beginFrame(uint32_t frameIndex) { mPerFrame.beginFrame(frameIndex); }
+
+	// Copies count staging descriptors into a contiguous table that lives until the frame is begun
+	// again, and returns its first slot. Throws when the frame's segment is full.
+	D3D12Lite::Descriptor allocateFrameTable(const D3D12Lite::Descriptor* staging, uint32_t count);
+
+	DescriptorAllocatorStatistics persistentStatistics() const { return mPersistent.statistics(); }
+	DescriptorAllocatorStatistics perFrameStatistics() const { return mPerFrame.statistics(); }
+
+private:
+	ID3D12Device* mDevice = nullptr;
+	D3D12_DESCRIPTOR_HEAP_TYPE mType;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mHeap;
+	D3D12_CPU_DESCRIPTOR_HANDLE mCPUStart{};
+	D3D12_GPU_DESCRIPTOR_HANDLE mGPUStart{};
+	uint32_t mDescriptorSize = 0;
+	DescriptorFreeList mPersistent;
+	DescriptorLinearAllocator mPerFrame;
+};
@@ -0,0 +1,190 @@
+#include "pch.h"
+#include "DrawSort.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <utility>
+
+namespace
+{
+	constexpr uint32_t RadixBits = 8;
+	constexpr uint32_t RadixSize = 1 << RadixBits;
+	constexpr uint32_t RadixPasses = 64 / RadixBits;
+
+	uint64_t field(uint32_t value, uint32_t bits)
+	{
+		return static_cast<uint64_t>(value) & ((1ull << bits) - 1);
+	}
+}
+
+uint32_t quantizeDrawSortDepth(float viewDepth)
+{
+	if (!(viewDepth > 0.0f))
+	{
+		return 0;
+	}
+
+	// Positive floats order the same as their bit patterns
+	uint32_t bits = 0;
+	std::memcpy(&bits, &viewDepth, sizeof(bits));
+
+	return bits >> (31 - DrawSortDepthBits);
+}
+
+uint64_t makeOpaqueDrawSortKey(uint32_t layer, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth)
+{
+	uint64_t key = field(layer, DrawSortLayerBits);
+	key = (key << DrawSortPipelineBits) | field(pipeline, DrawSortPipelineBits);
+	key = (key << DrawSortMaterialBits) | field(material, DrawSortMaterialBits);
+	key = (key << DrawSortMeshBits) | field(mesh, DrawSortMeshBits);
+	key = (key << DrawSortDepthBits) | field(depth, DrawSortDepthBits);
+
+	return key;
+}
+
+uint64_t makeTransparentDrawSortKey(uint32_t layer, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth)
+{
+	uint64_t key = field(layer, DrawSortLayerBits);
+	key = (key << DrawSortDepthBits) | field(~depth, DrawSortDepthBits);
+	key = (key << DrawSortPipelineBits) | field(pipeline, DrawSortPipelineBits);
+	key = (key << DrawSortMaterialBits) | field(material, DrawSortMaterialBits);
+	key = (key << DrawSortMeshBits) | field(mesh, DrawSortMeshBits);
+
+	return key;
+}
+
+void RadixSorter::reserve(uint32_t count)
+{
+	if (mEntries.size() < count)
+	{
+		mEntries.resize(count);
+		mScratch.resize(count);
+		mOrder.resize(count);
+	}
+}
+
+const uint32_t* RadixSorter::sort(const uint64_t* keys, uint32_t count)
+{
+	reserve(count);
+
+	// One read over the keys builds the histograms of every pass
+	std::array<std::array<uint32_t, RadixSize>, RadixPasses> histograms{};
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		auto key = keys[i];
+		mEntries[i] = { key, i };
+
+		for (uint32_t pass = 0; pass < RadixPasses; pass++)
+		{
+			histograms[pass][(key >> (pass * RadixBits)) & (RadixSize - 1)]++;
+		}
+	}
+
+	auto source = mEntries.data();
+	auto destination = mScratch.data();
+
+	for (uint32_t pass = 0; pass < RadixPasses && count > 0; pass++)
+	{
+		auto& histogram = histograms[pass];
+		auto shift = pass * RadixBits;
+
+		// Every key has the same digit, the pass would not move anything
+		if (histogram[(source[0].key >> shift) & (RadixSize - 1)] == count)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+
+		for (auto& bucket : histogram)
+		{
+			auto size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			destination[histogram[(source[i].key >> shift) & (RadixSize - 1)]++] = source[i];
+		}
+
+		std::swap(source, destination);
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		mOrder[i] = source[i].index;
+	}
+
+	return mOrder.data();
+}
+
+std::vector<DrawSortBenchmarkResult> benchmarkDrawSort(uint32_t maxCount)
+{
+	constexpr uint32_t Runs = 5;
+
+	std::mt19937_64 random(0x5EED);
+
+	// A scene's worth of distinct state: a few pipelines, some hundred materials and meshes
+	std::uniform_int_distribution<uint32_t> layers(0, 6);
+	std::uniform_int_distribution<uint32_t> pipelines(0, 15);
+	std::uniform_int_distribution<uint32_t> materials(0, 511);
+	std::uniform_int_distribution<uint32_t> meshes(0, 2047);
+	std::uniform_real_distribution<float> depths(0.1f, 1000.0f);
+
+	std::vector<uint64_t> keys(maxCount);
+
+	for (auto& key : keys)
+	{
+		auto depth = quantizeDrawSortDepth(depths(random));
+		key = makeOpaqueDrawSortKey(layers(random), pipelines(random), materials(random), meshes(random), depth);
+	}
+
+	RadixSorter sorter;
+	sorter.reserve(maxCount);
+
+	std::vector<std::pair<uint64_t, uint32_t>> pairs;
+	pairs.reserve(maxCount);
+
+	auto milliseconds = [](auto start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	};
+
+	std::vector<DrawSortBenchmarkResult> results;
+
+	for (uint32_t count = 1000; count <= maxCount; count *= 10)
+	{
+		DrawSortBenchmarkResult result;
+		result.count = count;
+		result.radixSortMilliseconds = DBL_MAX;
+		result.stdSortMilliseconds = DBL_MAX;
+
+		for (uint32_t run = 0; run < Runs; run++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			sorter.sort(keys.data(), count);
+			result.radixSortMilliseconds = std::min(result.radixSortMilliseconds, milliseconds(start));
+
+			pairs.clear();
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				pairs.emplace_back(keys[i], i);
+			}
+
+			start = std::chrono::high_resolution_clock::now();
+			std::sort(pairs.begin(), pairs.end());
+			result.stdSortMilliseconds = std::min(result.stdSortMilliseconds, milliseconds(start));
+		}
+
+		results.push_back(result);
+	}
+
+	return results;
+}
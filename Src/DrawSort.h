@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 64 bit draw sort keys, most significant field first:
+//   opaque:      layer 4 | pipeline 10 | material 12 | mesh 14 | depth 24
+//   transparent: layer 4 | ~depth 24  | pipeline 10 | material 12 | mesh 14
+// Sorting opaque keys ascending groups draws by state and goes front to back inside a group,
+// transparent keys go back to front first and only group by state at equal depth.
+// Fields wider than their bits are truncated, so ids should be small and dense.
+constexpr uint32_t DrawSortLayerBits = 4;
+constexpr uint32_t DrawSortPipelineBits = 10;
+constexpr uint32_t DrawSortMaterialBits = 12;
+constexpr uint32_t DrawSortMeshBits = 14;
+constexpr uint32_t DrawSortDepthBits = 24;
+
+// Maps a view space depth (distance along the view direction) to DrawSortDepthBits bits.
+// Uses the top bits of the float, so precision follows the float's: fine near the camera,
+// coarse far away. Depths behind the camera map to 0.
+uint32_t quantizeDrawSortDepth(float viewDepth);
+
+uint64_t makeOpaqueDrawSortKey(uint32_t layer, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth);
+uint64_t makeTransparentDrawSortKey(uint32_t layer, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth);
+
+// Stable LSD radix sort of 64 bit keys, 8 bits per pass. Passes on digits every key shares are
+// skipped, which drops most of them for typical draw keys. Scratch memory is kept between
+// calls, so once it has grown to the largest count sorting allocates nothing.
+class RadixSorter
+{
+public:
+	// Returns the permutation that sorts keys ascending: keys[order[0]] <= keys[order[1]] <= ...
+	// The pointer stays valid until the next call.
+	const uint32_t* sort(const uint64_t* keys, uint32_t count);
+
+	void reserve(uint32_t count);
+
+private:
+	struct Entry
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	std::vector<Entry> mEntries;
+	std::vector<Entry> mScratch;
+	std::vector<uint32_t> mOrder;
+};
+
+struct DrawSortBenchmarkResult
+{
+	uint32_t count = 0;
+	double radixSortMilliseconds = 0.0;
+	double stdSortMilliseconds = 0.0;
+};
+
+// Sorts random draw keys of 1K, 10K, 100K and 1M items (up to maxCount) with RadixSorter and
+// with std::sort on (key, index) pairs, best of a few runs each.
+std::vector<DrawSortBenchmarkResult> benchmarkDrawSort(uint32_t maxCount = 1000000);
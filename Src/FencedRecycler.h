@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+struct FencedRecyclerStatistics
+{
+	// Items ever created, which is also the size the pool has grown to.
+	size_t createdCount = 0;
+
+	// Acquisitions served by a recycled item instead of a new one.
+	size_t recycledCount = 0;
+
+	// Items handed out and not returned yet.
+	size_t inUseCount = 0;
+
+	// Items returned and waiting for (or past) their fence value.
+	size_t retiredCount = 0;
+
+	// Most items ever in use at the same time.
+	size_t highWaterMark = 0;
+
+	// Counts are summed. The peaks of different pools need not have happened at the same time,
+	// so the combined highWaterMark is the largest peak of a single pool, not their sum.
+	void add(const FencedRecyclerStatistics& other)
+	{
+		createdCount += other.createdCount;
+		recycledCount += other.recycledCount;
+		inUseCount += other.inUseCount;
+		retiredCount += other.retiredCount;
+		highWaterMark = std::max(highWaterMark, other.highWaterMark);
+	}
+};
+
+// Pool of items the GPU may still be using after they are returned, such as command allocators.
+// Every returned item is tagged with the fence value signaled after its last use and is only
+// handed out again once the caller reports that fence value as completed; until then acquire()
+// creates a new item. Fence values passed to retire() must not decrease, so the oldest item is
+// always the first one to become free. Like StagingRing it knows nothing about D3D12.
+template <typename T>
+class FencedRecycler
+{
+public:
+	// Returns the oldest retired item if completedFenceValue has reached its fence value,
+	// otherwise the result of create().
+	template <typename Create>
+	T acquire(uint64_t completedFenceValue, Create&& create)
+	{
+		T item;
+
+		if (!mRetired.empty() && mRetired.front().fenceValue <= completedFenceValue)
+		{
+			item = std::move(mRetired.front().item);
+			mRetired.pop_front();
+			mStatistics.recycledCount++;
+		}
+		else
+		{
+			item = create();
+			mStatistics.createdCount++;
+		}
+
+		mStatistics.inUseCount++;
+		mStatistics.highWaterMark = std::max(mStatistics.highWaterMark, mStatistics.inUseCount);
+
+		return item;
+	}
+
+	// Takes back an acquired item, free again once fenceValue is completed.
+	void retire(T item, uint64_t fenceValue)
+	{
+		assert(mStatistics.inUseCount > 0);
+		assert(mRetired.empty() || mRetired.back().fenceValue <= fenceValue);
+
+		mRetired.push_back({ fenceValue, std::move(item) });
+		mStatistics.inUseCount--;
+	}
+
+	FencedRecyclerStatistics statistics() const
+	{
+		auto statistics = mStatistics;
+		statistics.retiredCount = mRetired.size();
+
+		return statistics;
+	}
+
+private:
+	struct RetiredItem
+	{
+		uint64_t fenceValue = 0;
+		T item;
+	};
+
+	std::deque<RetiredItem> mRetired;
+	FencedRecyclerStatistics mStatistics;
+};
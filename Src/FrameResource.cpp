@@ -1,15 +1,103 @@
 #include "pch.h"
 #include "FrameResource.h"
 
-FrameResource::FrameResource(ID3D12Device* device, uint32_t passCount, uint32_t objectCount, uint32_t materialCount, uint32_t waveVertexCount)
+#include <algorithm>
+
+DynamicConstantBuffer::DynamicConstantBuffer(ID3D12Device* device, uint64_t pageSize)
+: mDevice(device), mPageSize(pageSize)
+{
+	addPage(pageSize);
+}
+
+DynamicConstantBuffer::~DynamicConstantBuffer()
+{
+	for (auto& page : mPages)
+	{
+		page.buffer->Unmap(0, nullptr);
+	}
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS DynamicConstantBuffer::allocate(const void* data, uint64_t size)
+{
+	auto allocation = allocate(size);
+	memcpy(allocation.data, data, size);
+
+	return allocation.gpuAddress;
+}
+
+DynamicAllocation DynamicConstantBuffer::allocate(uint64_t size)
+{
+	auto offset = mPages[mCurrentPage].allocator.allocate(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+	while (offset == LinearAllocator::InvalidOffset)
+	{
+		if (++mCurrentPage == mPages.size())
+		{
+			// Larger than a page gets a page of its own
+			addPage(std::max(mPageSize, size));
+		}
+
+		offset = mPages[mCurrentPage].allocator.allocate(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	}
+
+	auto& page = mPages[mCurrentPage];
+
+	DynamicAllocation allocation;
+	allocation.resource = page.buffer.Get();
+	allocation.offset = offset;
+	allocation.data = page.data + offset;
+	allocation.gpuAddress = page.buffer->GetGPUVirtualAddress() + offset;
+
+	return allocation;
+}
+
+void DynamicConstantBuffer::reset()
 {
-    DXCheck(device->CreateCommandAllocator(
-        D3D12_COMMAND_LIST_TYPE_DIRECT,
-		IID_PPV_ARGS(commandListAllocator.GetAddressOf())), L"CreateCommandAllocator failed!");
+	for (auto& page : mPages)
+	{
+		page.allocator.reset();
+	}
+
+	mCurrentPage = 0;
+}
+
+uint64_t DynamicConstantBuffer::usedSize() const
+{
+	uint64_t size = 0;
+
+	for (const auto& page : mPages)
+	{
+		size += page.allocator.usedSize();
+	}
+
+	return size;
+}
 
+void DynamicConstantBuffer::addPage(uint64_t size)
+{
+	Page page;
+	page.allocator = LinearAllocator(size);
+
+	DXCheck(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&page.buffer)), L"CreateCommittedResource failed!");
+
+	page.buffer->SetName(L"DynamicConstantBuffer");
+
+	// Stays mapped, upload heap memory is write-combined so it is only ever written, never read
+	DXCheck(page.buffer->Map(0, nullptr, reinterpret_cast<void**>(&page.data)), L"ID3D12Resource::Map failed!");
+
+	mPages.push_back(std::move(page));
+}
+
+FrameResource::FrameResource(ID3D12Device* device, uint32_t passCount, uint32_t waveVertexCount)
+{
     passConstantBuffer = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
-    objectConstantBuffer = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
-    materialConstantBuffer = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, true);
+    dynamicConstantBuffer = std::make_unique<DynamicConstantBuffer>(device, 256 * 1024);
 
 	wavesVertexBuffer = std::make_unique<UploadBuffer<DXVertex>>(device, waveVertexCount, false);
 }
@@ -5,8 +5,10 @@
 #include "Model.h"
 #include "MathHelper.h"
 #include "UploadBuffer.h"
+#include "LinearAllocator.h"
 
 #include <memory>
+#include <vector>
 
 struct ObjectConstants
 {
@@ -58,26 +60,78 @@ struct PassConstants
 	Light lights[MaxLights];
 };
 
+// Space from DynamicConstantBuffer::allocate(size): data is written through the CPU pointer,
+// the resource and offset feed ExecuteIndirect and the GPU address a root view.
+struct DynamicAllocation
+{
+	ID3D12Resource* resource = nullptr;
+	uint64_t offset = 0;
+	uint8_t* data = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+};
+
+// Transient constants of one frame. Each push() copies the data into a persistently mapped
+// upload buffer and returns its GPU virtual address, ready for SetGraphicsRootConstantBufferView,
+// so neither a fixed object count nor a CBV descriptor per object is needed. When a page is full
+// another one is created; pages are kept and rewound by reset() once the GPU is done with the frame.
+class DynamicConstantBuffer
+{
+public:
+	DynamicConstantBuffer(ID3D12Device* device, uint64_t pageSize);
+	DynamicConstantBuffer(const DynamicConstantBuffer& rhs) = delete;
+	DynamicConstantBuffer& operator=(const DynamicConstantBuffer& rhs) = delete;
+	~DynamicConstantBuffer();
+
+	// Every allocation starts at a 256 byte boundary, as root CBVs require.
+	D3D12_GPU_VIRTUAL_ADDRESS allocate(const void* data, uint64_t size);
+
+	// Uninitialized space for data written in place, e.g. ExecuteIndirect arguments, which need the resource and offset.
+	DynamicAllocation allocate(uint64_t size);
+
+	template <typename T>
+	D3D12_GPU_VIRTUAL_ADDRESS push(const T& data)
+	{
+		return allocate(&data, sizeof(T));
+	}
+
+	void reset();
+
+	uint64_t usedSize() const;
+	uint32_t pageCount() const { return static_cast<uint32_t>(mPages.size()); }
+
+private:
+	struct Page
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+		uint8_t* data = nullptr;
+		LinearAllocator allocator;
+	};
+
+	void addPage(uint64_t size);
+
+	ID3D12Device* mDevice = nullptr;
+	uint64_t mPageSize = 0;
+	std::vector<Page> mPages;
+	size_t mCurrentPage = 0;
+};
+
 // Stores the resources needed for the CPU to build the command lists
 // for a frame.  
 struct FrameResource
 {
 public:
     
-    FrameResource(ID3D12Device* device, uint32_t passCount, uint32_t objectCount, uint32_t materialCount, uint32_t waveVertexCount);
+    FrameResource(ID3D12Device* device, uint32_t passCount, uint32_t waveVertexCount);
     FrameResource(const FrameResource& rhs) = delete;
     FrameResource& operator=(const FrameResource& rhs) = delete;
     ~FrameResource();
 
-    // We cannot reset the allocator until the GPU is done processing the commands.
-    // So each frame needs their own allocator.
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandListAllocator;
-
     // We cannot update a cbuffer until the GPU is done processing the commands
     // that reference it.  So each frame needs their own cbuffers.
     std::unique_ptr<UploadBuffer<PassConstants>> passConstantBuffer = nullptr;
-	std::unique_ptr<UploadBuffer<MaterialConstants>> materialConstantBuffer = nullptr;
-    std::unique_ptr<UploadBuffer<ObjectConstants>> objectConstantBuffer = nullptr;
+
+	// Object and material constants are rewritten every frame, so any number of them fits.
+	std::unique_ptr<DynamicConstantBuffer> dynamicConstantBuffer = nullptr;
 
 	// We cannot update a dynamic vertex buffer until the GPU is done processing
 	// the commands that reference it.  So each frame needs their own.
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "FrameTelemetry.h"
+
+#include <algorithm>
+#include <cassert>
+
+FrameTelemetry::FrameTelemetry(size_t capacity)
+: mSamples(capacity)
+{
+	assert(capacity > 0);
+}
+
+void FrameTelemetry::record(const FrameTelemetrySample& sample)
+{
+	mSamples[mNext] = sample;
+	mNext = (mNext + 1) % mSamples.size();
+	mCount = std::min(mCount + 1, mSamples.size());
+}
+
+void FrameTelemetry::clear()
+{
+	mNext = 0;
+	mCount = 0;
+}
+
+const FrameTelemetrySample& FrameTelemetry::sample(size_t index) const
+{
+	assert(index < mCount);
+
+	return mSamples[(mNext + mSamples.size() - mCount + index) % mSamples.size()];
+}
+
+FrameTelemetrySummary FrameTelemetry::summary() const
+{
+	FrameTelemetrySummary summary;
+	summary.frameCount = mCount;
+
+	if (mCount == 0)
+	{
+		return summary;
+	}
+
+	for (size_t i = 0; i < mCount; i++)
+	{
+		const auto& frame = sample(i);
+
+		summary.averageCpuWaitMilliseconds += frame.cpuWaitMilliseconds;
+		summary.maxCpuWaitMilliseconds = std::max(summary.maxCpuWaitMilliseconds, frame.cpuWaitMilliseconds);
+
+		summary.averageGpuFrameLag += frame.gpuFrameLag;
+		summary.maxGpuFrameLag = std::max(summary.maxGpuFrameLag, frame.gpuFrameLag);
+
+		summary.averageInputToSubmitMilliseconds += frame.inputToSubmitMilliseconds;
+		summary.maxInputToSubmitMilliseconds = std::max(summary.maxInputToSubmitMilliseconds, frame.inputToSubmitMilliseconds);
+	}
+
+	summary.averageCpuWaitMilliseconds /= mCount;
+	summary.averageGpuFrameLag /= mCount;
+	summary.averageInputToSubmitMilliseconds /= mCount;
+
+	return summary;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What one rendered frame cost in latency.
+struct FrameTelemetrySample
+{
+	// Time the CPU spent blocked on the fence waiting for a frame resource to come back.
+	double cpuWaitMilliseconds = 0.0;
+
+	// Frames submitted and not completed by the GPU right after this one was submitted,
+	// this one included. Never more than the number of frames in flight.
+	uint32_t gpuFrameLag = 0;
+
+	// From polling input for the frame to submitting its command lists.
+	double inputToSubmitMilliseconds = 0.0;
+};
+
+struct FrameTelemetrySummary
+{
+	size_t frameCount = 0;
+
+	double averageCpuWaitMilliseconds = 0.0;
+	double maxCpuWaitMilliseconds = 0.0;
+
+	double averageGpuFrameLag = 0.0;
+	uint32_t maxGpuFrameLag = 0;
+
+	double averageInputToSubmitMilliseconds = 0.0;
+	double maxInputToSubmitMilliseconds = 0.0;
+};
+
+// The samples of the last capacity frames, oldest first, for the overlay and for comparing
+// frames in flight settings: more frames in flight usually trade CPU wait for latency.
+class FrameTelemetry
+{
+public:
+	explicit FrameTelemetry(size_t capacity = 240);
+
+	void record(const FrameTelemetrySample& sample);
+
+	void clear();
+
+	size_t size() const { return mCount; }
+	size_t capacity() const { return mSamples.size(); }
+
+	// index 0 is the oldest sample kept.
+	const FrameTelemetrySample& sample(size_t index) const;
+
+	FrameTelemetrySummary summary() const;
+
+private:
+	std::vector<FrameTelemetrySample> mSamples;
+	size_t mNext = 0;
+	size_t mCount = 0;
+};
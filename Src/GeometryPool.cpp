@@ -0,0 +1,302 @@
+#include "pch.h"
+#include "GeometryPool.h"
+
+#include <algorithm>
+
+RangeAllocator::RangeAllocator(uint64_t capacity)
+{
+	reset(capacity);
+}
+
+void RangeAllocator::reset(uint64_t capacity)
+{
+	mFreeRanges.clear();
+	mCapacity = capacity;
+	mUsedSize = 0;
+
+	if (capacity > 0)
+	{
+		mFreeRanges[0] = capacity;
+	}
+}
+
+uint64_t RangeAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0)
+	{
+		return InvalidOffset;
+	}
+
+	alignment = std::max<uint64_t>(alignment, 1);
+
+	for (auto iterator = mFreeRanges.begin(); iterator != mFreeRanges.end(); ++iterator)
+	{
+		auto rangeOffset = iterator->first;
+		auto rangeSize = iterator->second;
+		auto offset = (rangeOffset + alignment - 1) / alignment * alignment;
+
+		if (offset + size > rangeOffset + rangeSize)
+		{
+			continue;
+		}
+
+		mFreeRanges.erase(iterator);
+
+		if (offset > rangeOffset)
+		{
+			mFreeRanges[rangeOffset] = offset - rangeOffset;
+		}
+
+		if (offset + size < rangeOffset + rangeSize)
+		{
+			mFreeRanges[offset + size] = rangeOffset + rangeSize - offset - size;
+		}
+
+		mUsedSize += size;
+
+		return offset;
+	}
+
+	return InvalidOffset;
+}
+
+void RangeAllocator::free(uint64_t offset, uint64_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	mUsedSize -= size;
+
+	auto next = mFreeRanges.lower_bound(offset);
+
+	if (next != mFreeRanges.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = mFreeRanges.erase(next);
+	}
+
+	if (next != mFreeRanges.begin())
+	{
+		auto previous = std::prev(next);
+
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += size;
+			return;
+		}
+	}
+
+	mFreeRanges.emplace_hint(next, offset, size);
+}
+
+uint64_t RangeAllocator::largestFreeRange() const
+{
+	uint64_t largest = 0;
+
+	for (const auto& range : mFreeRanges)
+	{
+		largest = std::max(largest, range.second);
+	}
+
+	return largest;
+}
+
+GeometryPool::GeometryPool(uint64_t vertexPageSize, uint32_t indexPageCount)
+: mVertexPageSize(vertexPageSize), mIndexPageCount(indexPageCount)
+{
+}
+
+GeometryHandle GeometryPool::allocate(uint32_t vertexCount, uint32_t vertexStride, uint32_t indexCount)
+{
+	auto vertexSize = static_cast<uint64_t>(vertexCount) * vertexStride;
+
+	GeometryAllocation allocation;
+
+	for (uint32_t page = 0; page < pageCount() && !allocation.valid(); page++)
+	{
+		allocateInPage(page, vertexSize, vertexStride, indexCount, allocation);
+	}
+
+	if (!allocation.valid())
+	{
+		// Room for the stride alignment padding as well
+		Page page;
+		page.vertices.reset(std::max(mVertexPageSize, vertexSize + vertexStride));
+		page.indices.reset(std::max<uint64_t>(mIndexPageCount, indexCount));
+
+		mPages.push_back(std::move(page));
+
+		if (!allocateInPage(pageCount() - 1, vertexSize, vertexStride, indexCount, allocation))
+		{
+			mPages.pop_back();
+			return InvalidGeometryHandle;
+		}
+	}
+
+	GeometryHandle handle = InvalidGeometryHandle;
+
+	if (!mFreeHandles.empty())
+	{
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+		mAllocations[handle] = allocation;
+	}
+	else
+	{
+		handle = static_cast<GeometryHandle>(mAllocations.size());
+		mAllocations.push_back(allocation);
+	}
+
+	mAllocationCount++;
+
+	return handle;
+}
+
+void GeometryPool::free(GeometryHandle handle)
+{
+	auto& allocation = mAllocations[handle];
+
+	if (!allocation.valid())
+	{
+		return;
+	}
+
+	auto& page = mPages[allocation.page];
+	page.vertices.free(allocation.vertexOffset, allocation.vertexSize);
+	page.indices.free(allocation.startIndexLocation, allocation.indexCount);
+
+	allocation = {};
+	mFreeHandles.push_back(handle);
+	mAllocationCount--;
+}
+
+std::vector<GeometryMove> GeometryPool::defragment(uint32_t page)
+{
+	std::vector<GeometryHandle> handles;
+
+	for (GeometryHandle handle = 0; handle < mAllocations.size(); handle++)
+	{
+		if (mAllocations[handle].page == page)
+		{
+			handles.push_back(handle);
+		}
+	}
+
+	// Reallocating in offset order from an empty page packs everything to the front
+	auto& pageAllocators = mPages[page];
+	pageAllocators.vertices.reset(pageAllocators.vertices.capacity());
+	pageAllocators.indices.reset(pageAllocators.indices.capacity());
+
+	std::vector<GeometryAllocation> before(mAllocations.size());
+
+	for (auto handle : handles)
+	{
+		before[handle] = mAllocations[handle];
+	}
+
+	std::sort(handles.begin(), handles.end(), [this](GeometryHandle a, GeometryHandle b)
+	{
+		return mAllocations[a].vertexOffset < mAllocations[b].vertexOffset;
+	});
+
+	for (auto handle : handles)
+	{
+		auto& allocation = mAllocations[handle];
+
+		if (allocation.vertexSize > 0)
+		{
+			allocation.vertexOffset = pageAllocators.vertices.allocate(allocation.vertexSize, allocation.vertexStride);
+		}
+	}
+
+	std::sort(handles.begin(), handles.end(), [this](GeometryHandle a, GeometryHandle b)
+	{
+		return mAllocations[a].startIndexLocation < mAllocations[b].startIndexLocation;
+	});
+
+	for (auto handle : handles)
+	{
+		auto& allocation = mAllocations[handle];
+
+		if (allocation.indexCount > 0)
+		{
+			allocation.startIndexLocation = static_cast<uint32_t>(pageAllocators.indices.allocate(allocation.indexCount));
+		}
+	}
+
+	std::vector<GeometryMove> moves;
+
+	for (auto handle : handles)
+	{
+		moves.push_back({ handle, before[handle], mAllocations[handle] });
+	}
+
+	return moves;
+}
+
+GeometryPoolStatistics GeometryPool::statistics() const
+{
+	GeometryPoolStatistics statistics;
+	statistics.pageCount = pageCount();
+	statistics.allocationCount = mAllocationCount;
+
+	// Summed per page, a fully packed page counts as unfragmented even if other pages have free space
+	uint64_t largestFreeRanges = 0;
+
+	for (const auto& page : mPages)
+	{
+		statistics.vertexCapacity += page.vertices.capacity();
+		statistics.vertexUsed += page.vertices.usedSize();
+		statistics.indexCapacity += page.indices.capacity();
+		statistics.indexUsed += page.indices.usedSize();
+
+		largestFreeRanges += page.vertices.largestFreeRange();
+	}
+
+	auto vertexFree = statistics.vertexCapacity - statistics.vertexUsed;
+
+	statistics.vertexFragmentation = vertexFree == 0 ? 0.0 : 1.0 - static_cast<double>(largestFreeRanges) / static_cast<double>(vertexFree);
+
+	return statistics;
+}
+
+bool GeometryPool::allocateInPage(uint32_t page, uint64_t vertexSize, uint32_t vertexStride, uint32_t indexCount, GeometryAllocation& allocation)
+{
+	auto& pageAllocators = mPages[page];
+
+	uint64_t vertexOffset = 0;
+
+	if (vertexSize > 0)
+	{
+		vertexOffset = pageAllocators.vertices.allocate(vertexSize, vertexStride);
+
+		if (vertexOffset == RangeAllocator::InvalidOffset)
+		{
+			return false;
+		}
+	}
+
+	uint64_t startIndexLocation = 0;
+
+	if (indexCount > 0)
+	{
+		startIndexLocation = pageAllocators.indices.allocate(indexCount);
+
+		if (startIndexLocation == RangeAllocator::InvalidOffset)
+		{
+			pageAllocators.vertices.free(vertexOffset, vertexSize);
+			return false;
+		}
+	}
+
+	allocation.page = page;
+	allocation.vertexOffset = vertexOffset;
+	allocation.vertexSize = vertexSize;
+	allocation.vertexStride = vertexStride;
+	allocation.startIndexLocation = static_cast<uint32_t>(startIndexLocation);
+	allocation.indexCount = indexCount;
+
+	return true;
+}
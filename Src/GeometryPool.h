@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// First fit allocator over [0, capacity) with any (not only power of two) alignment.
+// Free ranges are kept sorted by offset and merged with their neighbours on free.
+class RangeAllocator
+{
+public:
+	static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+	RangeAllocator() = default;
+	explicit RangeAllocator(uint64_t capacity);
+
+	void reset(uint64_t capacity);
+
+	// The returned offset is a multiple of alignment, InvalidOffset when no free range fits.
+	uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+	void free(uint64_t offset, uint64_t size);
+
+	uint64_t capacity() const { return mCapacity; }
+	uint64_t usedSize() const { return mUsedSize; }
+	uint64_t largestFreeRange() const;
+	size_t freeRangeCount() const { return mFreeRanges.size(); }
+
+private:
+	// Offset -> size.
+	std::map<uint64_t, uint64_t> mFreeRanges;
+	uint64_t mCapacity = 0;
+	uint64_t mUsedSize = 0;
+};
+
+using GeometryHandle = uint32_t;
+
+constexpr GeometryHandle InvalidGeometryHandle = UINT32_MAX;
+
+struct GeometryAllocation
+{
+	static constexpr uint32_t InvalidPage = UINT32_MAX;
+
+	uint32_t page = InvalidPage;
+
+	// Byte range in the page's vertex buffer, the offset is a multiple of the stride.
+	uint64_t vertexOffset = 0;
+	uint64_t vertexSize = 0;
+	uint32_t vertexStride = 0;
+
+	// Range in the page's 32 bit index buffer, in indices.
+	uint32_t startIndexLocation = 0;
+	uint32_t indexCount = 0;
+
+	uint32_t baseVertexLocation() const { return vertexStride == 0 ? 0 : static_cast<uint32_t>(vertexOffset / vertexStride); }
+
+	bool valid() const { return page != InvalidPage; }
+};
+
+// Where defragment() put a live range, copy `before` in the old buffers to `after` in the new ones.
+struct GeometryMove
+{
+	GeometryHandle handle = InvalidGeometryHandle;
+	GeometryAllocation before;
+	GeometryAllocation after;
+};
+
+struct GeometryPoolStatistics
+{
+	uint32_t pageCount = 0;
+	uint32_t allocationCount = 0;
+	uint64_t vertexCapacity = 0;
+	uint64_t vertexUsed = 0;
+	uint64_t indexCapacity = 0;
+	uint64_t indexUsed = 0;
+	// 1 - sum of each page's largest free vertex range / free vertex space.
+	double vertexFragmentation = 0.0;
+};
+
+// Sub-allocates the vertices and indices of many meshes from a few large buffers.
+// Each page is one vertex buffer shared by every vertex layout (meshes are placed at multiples
+// of their stride, so baseVertexLocation addresses them) and one R32 index buffer.
+// The pool only manages ranges; the caller creates a page's buffers once pageCount() grows.
+class GeometryPool
+{
+public:
+	GeometryPool(uint64_t vertexPageSize, uint32_t indexPageCount);
+
+	// vertexCount may be 0 for meshes whose vertices live elsewhere (dynamic buffers).
+	// Meshes larger than a page get a page of their own.
+	GeometryHandle allocate(uint32_t vertexCount, uint32_t vertexStride, uint32_t indexCount);
+
+	void free(GeometryHandle handle);
+
+	const GeometryAllocation& allocation(GeometryHandle handle) const { return mAllocations[handle]; }
+
+	uint32_t pageCount() const { return static_cast<uint32_t>(mPages.size()); }
+	uint64_t vertexPageSize(uint32_t page) const { return mPages[page].vertices.capacity(); }
+	uint32_t indexPageCount(uint32_t page) const { return static_cast<uint32_t>(mPages[page].indices.capacity()); }
+
+	// Packs the live ranges of a page to its start and returns every live range of the page, moved or not.
+	// The caller copies them from the old buffers into fresh ones, so overlapping moves are not a concern.
+	std::vector<GeometryMove> defragment(uint32_t page);
+
+	GeometryPoolStatistics statistics() const;
+
+private:
+	struct Page
+	{
+		RangeAllocator vertices;
+		RangeAllocator indices;
+	};
+
+	bool allocateInPage(uint32_t page, uint64_t vertexSize, uint32_t vertexStride, uint32_t indexCount, GeometryAllocation& allocation);
+
+	std::vector<Page> mPages;
+	std::vector<GeometryAllocation> mAllocations;
+	std::vector<GeometryHandle> mFreeHandles;
+	uint64_t mVertexPageSize = 0;
+	uint32_t mIndexPageCount = 0;
+	uint32_t mAllocationCount = 0;
+};
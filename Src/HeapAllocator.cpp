@@ -0,0 +1,460 @@
+#include "pch.h"
+#include "HeapAllocator.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	uint32_t findLastSet(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index = 0;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+
+	uint32_t findFirstSet(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index = 0;
+		_BitScanForward64(&index, value);
+		return index;
+#else
+		return __builtin_ctzll(value);
+#endif
+	}
+
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+TLSFAllocator::TLSFAllocator(uint64_t size)
+{
+	reset(size);
+}
+
+void TLSFAllocator::reset(uint64_t size)
+{
+	mBlocks.clear();
+	mUnusedBlocks.clear();
+
+	for (auto& heads : mFreeHeads)
+	{
+		std::fill(std::begin(heads), std::end(heads), TLSFAllocation::InvalidBlock);
+	}
+
+	mFirstLevelBitmap = 0;
+	std::fill(std::begin(mSecondLevelBitmaps), std::end(mSecondLevelBitmaps), 0u);
+
+	mSize = size & ~(MinBlockSize - 1);
+	mUsedBytes = 0;
+	mAllocationCount = 0;
+
+	if (mSize > 0)
+	{
+		insertFreeBlock(createBlock(0, mSize));
+	}
+}
+
+TLSFAllocation TLSFAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+	size = alignUp(std::max<uint64_t>(size, 1), MinBlockSize);
+	alignment = std::max(alignment, MinBlockSize);
+
+	if (size > mSize)
+	{
+		return {};
+	}
+
+	auto block = findFreeBlock(size);
+
+	// The first fit might not have room for the alignment padding, search again for the worst case
+	if (block != TLSFAllocation::InvalidBlock && alignUp(mBlocks[block].offset, alignment) + size > mBlocks[block].offset + mBlocks[block].size)
+	{
+		block = findFreeBlock(size + alignment - MinBlockSize);
+	}
+
+	// Rounding up to the next class skips blocks of the request's own class that would fit,
+	// such as the single block of a heap sized for exactly this request
+	if (block == TLSFAllocation::InvalidBlock)
+	{
+		block = searchSizeClass(size, alignment);
+	}
+
+	if (block == TLSFAllocation::InvalidBlock)
+	{
+		return {};
+	}
+
+	removeFreeBlock(block);
+
+	auto padding = alignUp(mBlocks[block].offset, alignment) - mBlocks[block].offset;
+
+	if (padding > 0)
+	{
+		auto alignedBlock = splitBlock(block, padding);
+		insertFreeBlock(block);
+		block = alignedBlock;
+	}
+
+	if (mBlocks[block].size - size >= MinBlockSize)
+	{
+		insertFreeBlock(splitBlock(block, size));
+	}
+
+	mBlocks[block].free = false;
+
+	mUsedBytes += mBlocks[block].size;
+	mAllocationCount++;
+
+	TLSFAllocation allocation;
+	allocation.offset = mBlocks[block].offset;
+	allocation.size = mBlocks[block].size;
+	allocation.block = block;
+
+	return allocation;
+}
+
+void TLSFAllocator::free(const TLSFAllocation& allocation)
+{
+	if (!allocation.valid())
+	{
+		return;
+	}
+
+	auto block = allocation.block;
+
+	mBlocks[block].free = true;
+	mUsedBytes -= mBlocks[block].size;
+	mAllocationCount--;
+
+	auto previous = mBlocks[block].previousPhysical;
+
+	if (previous != TLSFAllocation::InvalidBlock && mBlocks[previous].free)
+	{
+		removeFreeBlock(previous);
+		mergeBlocks(previous, block);
+		block = previous;
+	}
+
+	auto next = mBlocks[block].nextPhysical;
+
+	if (next != TLSFAllocation::InvalidBlock && mBlocks[next].free)
+	{
+		removeFreeBlock(next);
+		mergeBlocks(block, next);
+	}
+
+	insertFreeBlock(block);
+}
+
+HeapStatistics TLSFAllocator::statistics() const
+{
+	HeapStatistics statistics;
+	statistics.totalBytes = mSize;
+	statistics.usedBytes = mUsedBytes;
+	statistics.freeBytes = mSize - mUsedBytes;
+	statistics.allocationCount = mAllocationCount;
+
+	// The block at offset 0 is always the first one created and never merged away
+	for (uint32_t block = mBlocks.empty() ? TLSFAllocation::InvalidBlock : 0; block != TLSFAllocation::InvalidBlock; block = mBlocks[block].nextPhysical)
+	{
+		if (mBlocks[block].free)
+		{
+			statistics.freeBlockCount++;
+			statistics.largestFreeBlock = std::max(statistics.largestFreeBlock, mBlocks[block].size);
+		}
+	}
+
+	return statistics;
+}
+
+void TLSFAllocator::mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+	firstLevel = findLastSet(size);
+	secondLevel = static_cast<uint32_t>(size >> (firstLevel - SecondLevelBits)) & (SecondLevelCount - 1);
+}
+
+uint32_t TLSFAllocator::createBlock(uint64_t offset, uint64_t size)
+{
+	uint32_t block = 0;
+
+	if (!mUnusedBlocks.empty())
+	{
+		block = mUnusedBlocks.back();
+		mUnusedBlocks.pop_back();
+		mBlocks[block] = {};
+	}
+	else
+	{
+		block = static_cast<uint32_t>(mBlocks.size());
+		mBlocks.emplace_back();
+	}
+
+	mBlocks[block].offset = offset;
+	mBlocks[block].size = size;
+
+	return block;
+}
+
+void TLSFAllocator::destroyBlock(uint32_t block)
+{
+	mUnusedBlocks.push_back(block);
+}
+
+void TLSFAllocator::insertFreeBlock(uint32_t block)
+{
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	mapping(mBlocks[block].size, firstLevel, secondLevel);
+
+	auto head = mFreeHeads[firstLevel][secondLevel];
+
+	mBlocks[block].free = true;
+	mBlocks[block].previousFree = TLSFAllocation::InvalidBlock;
+	mBlocks[block].nextFree = head;
+
+	if (head != TLSFAllocation::InvalidBlock)
+	{
+		mBlocks[head].previousFree = block;
+	}
+
+	mFreeHeads[firstLevel][secondLevel] = block;
+	mFirstLevelBitmap |= 1ull << firstLevel;
+	mSecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void TLSFAllocator::removeFreeBlock(uint32_t block)
+{
+	auto previous = mBlocks[block].previousFree;
+	auto next = mBlocks[block].nextFree;
+
+	if (previous != TLSFAllocation::InvalidBlock)
+	{
+		mBlocks[previous].nextFree = next;
+	}
+
+	if (next != TLSFAllocation::InvalidBlock)
+	{
+		mBlocks[next].previousFree = previous;
+	}
+
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	mapping(mBlocks[block].size, firstLevel, secondLevel);
+
+	if (mFreeHeads[firstLevel][secondLevel] == block)
+	{
+		mFreeHeads[firstLevel][secondLevel] = next;
+
+		if (next == TLSFAllocation::InvalidBlock)
+		{
+			mSecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+
+			if (mSecondLevelBitmaps[firstLevel] == 0)
+			{
+				mFirstLevelBitmap &= ~(1ull << firstLevel);
+			}
+		}
+	}
+
+	mBlocks[block].free = false;
+	mBlocks[block].previousFree = TLSFAllocation::InvalidBlock;
+	mBlocks[block].nextFree = TLSFAllocation::InvalidBlock;
+}
+
+uint32_t TLSFAllocator::findFreeBlock(uint64_t size) const
+{
+	// Round up to the next size class so that any block in the class found is large enough
+	auto roundedSize = size + (1ull << (findLastSet(size) - SecondLevelBits)) - 1;
+
+	if (roundedSize < size)
+	{
+		return TLSFAllocation::InvalidBlock;
+	}
+
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	mapping(roundedSize, firstLevel, secondLevel);
+
+	auto secondLevelMap = mSecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+
+	if (secondLevelMap == 0)
+	{
+		auto firstLevelMap = firstLevel + 1 < FirstLevelCount ? mFirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+
+		if (firstLevelMap == 0)
+		{
+			return TLSFAllocation::InvalidBlock;
+		}
+
+		firstLevel = findFirstSet(firstLevelMap);
+		secondLevelMap = mSecondLevelBitmaps[firstLevel];
+	}
+
+	return mFreeHeads[firstLevel][findFirstSet(secondLevelMap)];
+}
+
+uint32_t TLSFAllocator::searchSizeClass(uint64_t size, uint64_t alignment) const
+{
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	mapping(size, firstLevel, secondLevel);
+
+	for (auto block = mFreeHeads[firstLevel][secondLevel]; block != TLSFAllocation::InvalidBlock; block = mBlocks[block].nextFree)
+	{
+		if (alignUp(mBlocks[block].offset, alignment) + size <= mBlocks[block].offset + mBlocks[block].size)
+		{
+			return block;
+		}
+	}
+
+	return TLSFAllocation::InvalidBlock;
+}
+
+uint32_t TLSFAllocator::splitBlock(uint32_t block, uint64_t size)
+{
+	auto remainder = createBlock(mBlocks[block].offset + size, mBlocks[block].size - size);
+
+	auto next = mBlocks[block].nextPhysical;
+
+	mBlocks[remainder].previousPhysical = block;
+	mBlocks[remainder].nextPhysical = next;
+
+	if (next != TLSFAllocation::InvalidBlock)
+	{
+		mBlocks[next].previousPhysical = remainder;
+	}
+
+	mBlocks[block].nextPhysical = remainder;
+	mBlocks[block].size = size;
+
+	return remainder;
+}
+
+void TLSFAllocator::mergeBlocks(uint32_t first, uint32_t second)
+{
+	auto next = mBlocks[second].nextPhysical;
+
+	mBlocks[first].size += mBlocks[second].size;
+	mBlocks[first].nextPhysical = next;
+
+	if (next != TLSFAllocation::InvalidBlock)
+	{
+		mBlocks[next].previousPhysical = first;
+	}
+
+	destroyBlock(second);
+}
+
+HeapAllocator::HeapAllocator(uint64_t heapSize)
+: mHeapSize(heapSize)
+{
+}
+
+HeapAllocation HeapAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+	HeapAllocation allocation;
+
+	for (uint32_t heap = 0; heap < heapCount(); heap++)
+	{
+		// Dedicated heaps belong to their allocation, released ones (size 0) fail to allocate by themselves
+		if (mDedicated[heap])
+		{
+			continue;
+		}
+
+		allocation.allocation = mHeaps[heap].allocate(size, alignment);
+
+		if (allocation.allocation.valid())
+		{
+			allocation.heap = heap;
+			break;
+		}
+	}
+
+	if (!allocation.valid())
+	{
+		auto dedicatedSize = alignUp(size, std::max(alignment, TLSFAllocator::MinBlockSize));
+		auto heapSize = std::max(mHeapSize, dedicatedSize);
+
+		TLSFAllocator heap(heapSize);
+		allocation.allocation = heap.allocate(size, alignment);
+
+		if (!allocation.allocation.valid())
+		{
+			return {};
+		}
+
+		// The index of a released heap is reused before the list grows
+		if (!mReleasedHeaps.empty())
+		{
+			allocation.heap = mReleasedHeaps.back();
+			mReleasedHeaps.pop_back();
+		}
+		else
+		{
+			allocation.heap = heapCount();
+			mHeaps.emplace_back();
+			mDedicated.push_back(false);
+		}
+
+		mHeaps[allocation.heap] = std::move(heap);
+		mDedicated[allocation.heap] = dedicatedSize > mHeapSize;
+	}
+
+	allocation.offset = allocation.allocation.offset;
+	allocation.size = allocation.allocation.size;
+
+	return allocation;
+}
+
+bool HeapAllocator::free(const HeapAllocation& allocation)
+{
+	if (!allocation.valid())
+	{
+		return false;
+	}
+
+	mHeaps[allocation.heap].free(allocation.allocation);
+
+	if (!mDedicated[allocation.heap])
+	{
+		return false;
+	}
+
+	// A dedicated heap only ever holds this one allocation
+	mHeaps[allocation.heap].reset(0);
+	mDedicated[allocation.heap] = false;
+	mReleasedHeaps.push_back(allocation.heap);
+
+	return true;
+}
+
+HeapStatistics HeapAllocator::statistics() const
+{
+	HeapStatistics total;
+
+	for (const auto& heap : mHeaps)
+	{
+		auto statistics = heap.statistics();
+
+		total.totalBytes += statistics.totalBytes;
+		total.usedBytes += statistics.usedBytes;
+		total.freeBytes += statistics.freeBytes;
+		total.allocationCount += statistics.allocationCount;
+		total.freeBlockCount += statistics.freeBlockCount;
+		total.largestFreeBlock = std::max(total.largestFreeBlock, statistics.largestFreeBlock);
+	}
+
+	return total;
+}
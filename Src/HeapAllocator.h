@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TLSFAllocation
+{
+	static constexpr uint32_t InvalidBlock = UINT32_MAX;
+
+	uint64_t offset = 0;
+	uint64_t size = 0;
+	uint32_t block = InvalidBlock;
+
+	bool valid() const { return block != InvalidBlock; }
+};
+
+struct HeapStatistics
+{
+	uint64_t totalBytes = 0;
+	uint64_t usedBytes = 0;
+	uint64_t freeBytes = 0;
+	uint64_t largestFreeBlock = 0;
+	uint32_t allocationCount = 0;
+	uint32_t freeBlockCount = 0;
+
+	// 1 - largestFreeBlock / freeBytes: 0 when all free space is one block, close to 1 when it is scattered.
+	double fragmentation() const
+	{
+		return freeBytes == 0 ? 0.0 : 1.0 - static_cast<double>(largestFreeBlock) / static_cast<double>(freeBytes);
+	}
+};
+
+// Two-level segregated fit allocator over a range of offsets, used to place resources in an ID3D12Heap.
+// Free blocks are binned by size class (power of two, split into 16 linear steps), so allocate and free
+// are O(1) and neighbouring free blocks are merged right away. It only manages offsets, never memory.
+class TLSFAllocator
+{
+public:
+	// Sizes are rounded up to this, it is also the smallest block that is split off.
+	static constexpr uint64_t MinBlockSize = 256;
+
+	TLSFAllocator() = default;
+	explicit TLSFAllocator(uint64_t size);
+
+	void reset(uint64_t size);
+
+	// alignment must be a power of two. Returns an invalid allocation when nothing fits.
+	TLSFAllocation allocate(uint64_t size, uint64_t alignment = MinBlockSize);
+
+	void free(const TLSFAllocation& allocation);
+
+	uint64_t size() const { return mSize; }
+
+	HeapStatistics statistics() const;
+
+private:
+	static constexpr uint32_t SecondLevelBits = 4;
+	static constexpr uint32_t SecondLevelCount = 1 << SecondLevelBits;
+	static constexpr uint32_t FirstLevelCount = 64;
+
+	struct Block
+	{
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		uint32_t previousPhysical = TLSFAllocation::InvalidBlock;
+		uint32_t nextPhysical = TLSFAllocation::InvalidBlock;
+		uint32_t previousFree = TLSFAllocation::InvalidBlock;
+		uint32_t nextFree = TLSFAllocation::InvalidBlock;
+		bool free = false;
+	};
+
+	static void mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+	uint32_t createBlock(uint64_t offset, uint64_t size);
+	void destroyBlock(uint32_t block);
+	void insertFreeBlock(uint32_t block);
+	void removeFreeBlock(uint32_t block);
+	uint32_t findFreeBlock(uint64_t size) const;
+	uint32_t searchSizeClass(uint64_t size, uint64_t alignment) const;
+	uint32_t splitBlock(uint32_t block, uint64_t size);
+	void mergeBlocks(uint32_t first, uint32_t second);
+
+	std::vector<Block> mBlocks;
+	std::vector<uint32_t> mUnusedBlocks;
+
+	uint32_t mFreeHeads[FirstLevelCount][SecondLevelCount];
+	uint64_t mFirstLevelBitmap = 0;
+	uint32_t mSecondLevelBitmaps[FirstLevelCount] = {};
+
+	uint64_t mSize = 0;
+	uint64_t mUsedBytes = 0;
+	uint32_t mAllocationCount = 0;
+};
+
+struct HeapAllocation
+{
+	static constexpr uint32_t InvalidHeap = UINT32_MAX;
+
+	uint32_t heap = InvalidHeap;
+	uint64_t offset = 0;
+	uint64_t size = 0;
+	TLSFAllocation allocation;
+
+	bool valid() const { return heap != InvalidHeap; }
+};
+
+// Sub-allocates from a growing list of fixed size heaps, one TLSFAllocator per heap.
+// The allocator does not create the GPU heaps itself: after allocate() the caller creates a heap
+// of heapSize(index) bytes for every index below heapCount() that has a size but no GPU heap yet.
+// Released heaps keep their index with a size of 0 until a later allocate() reuses it.
+class HeapAllocator
+{
+public:
+	// heapSize should be a multiple of the largest placement alignment that will be requested (64KB or 4MB).
+	explicit HeapAllocator(uint64_t heapSize);
+
+	// Requests larger than the heap size get a dedicated heap of their own, nothing else is placed in it.
+	HeapAllocation allocate(uint64_t size, uint64_t alignment);
+
+	// Returns true when the allocation had a dedicated heap, which is released with it:
+	// the caller destroys the GPU heap at allocation.heap once the GPU no longer uses it.
+	bool free(const HeapAllocation& allocation);
+
+	uint32_t heapCount() const { return static_cast<uint32_t>(mHeaps.size()); }
+	uint64_t heapSize(uint32_t heap) const { return mHeaps[heap].size(); }
+
+	HeapStatistics statistics(uint32_t heap) const { return mHeaps[heap].statistics(); }
+
+	// Totals over every heap, largestFreeBlock is the largest in any single heap.
+	HeapStatistics statistics() const;
+
+private:
+	std::vector<TLSFAllocator> mHeaps;
+	std::vector<bool> mDedicated;
+	std::vector<uint32_t> mReleasedHeaps;
+	uint64_t mHeapSize = 0;
+};
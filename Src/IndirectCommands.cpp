@@ -0,0 +1,189 @@
+#include "pch.h"
+#include "IndirectCommands.h"
+
+#include <cassert>
+#include <cstring>
+
+uint32_t IndirectCommandLayout::addConstants(uint32_t rootParameterIndex, uint32_t count, uint32_t destinationOffset)
+{
+	D3D12_INDIRECT_ARGUMENT_DESC argument{};
+	argument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+	argument.Constant.RootParameterIndex = rootParameterIndex;
+	argument.Constant.DestOffsetIn32BitValues = destinationOffset;
+	argument.Constant.Num32BitValuesToSet = count;
+
+	return add(argument, count * sizeof(uint32_t));
+}
+
+uint32_t IndirectCommandLayout::addConstantBufferView(uint32_t rootParameterIndex)
+{
+	D3D12_INDIRECT_ARGUMENT_DESC argument{};
+	argument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW;
+	argument.ConstantBufferView.RootParameterIndex = rootParameterIndex;
+
+	return add(argument, sizeof(D3D12_GPU_VIRTUAL_ADDRESS));
+}
+
+uint32_t IndirectCommandLayout::addShaderResourceView(uint32_t rootParameterIndex)
+{
+	D3D12_INDIRECT_ARGUMENT_DESC argument{};
+	argument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW;
+	argument.ShaderResourceView.RootParameterIndex = rootParameterIndex;
+
+	return add(argument, sizeof(D3D12_GPU_VIRTUAL_ADDRESS));
+}
+
+uint32_t IndirectCommandLayout::addVertexBufferView(uint32_t slot)
+{
+	D3D12_INDIRECT_ARGUMENT_DESC argument{};
+	argument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+	argument.VertexBuffer.Slot = slot;
+
+	return add(argument, sizeof(D3D12_VERTEX_BUFFER_VIEW));
+}
+
+uint32_t IndirectCommandLayout::addIndexBufferView()
+{
+	D3D12_INDIRECT_ARGUMENT_DESC argument{};
+	argument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+
+	return add(argument, sizeof(D3D12_INDEX_BUFFER_VIEW));
+}
+
+uint32_t IndirectCommandLayout::addDrawIndexed()
+{
+	D3D12_INDIRECT_ARGUMENT_DESC argument{};
+	argument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+	return add(argument, sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+}
+
+uint32_t IndirectCommandLayout::addDraw()
+{
+	D3D12_INDIRECT_ARGUMENT_DESC argument{};
+	argument.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+	return add(argument, sizeof(D3D12_DRAW_ARGUMENTS));
+}
+
+uint32_t IndirectCommandLayout::argumentSize(uint32_t argument) const
+{
+	auto end = argument + 1 < mOffsets.size() ? mOffsets[argument + 1] : mByteStride;
+	return end - mOffsets[argument];
+}
+
+D3D12_COMMAND_SIGNATURE_DESC IndirectCommandLayout::commandSignatureDesc() const
+{
+	D3D12_COMMAND_SIGNATURE_DESC desc{};
+	desc.ByteStride = mByteStride;
+	desc.NumArgumentDescs = static_cast<uint32_t>(mArguments.size());
+	desc.pArgumentDescs = mArguments.data();
+	desc.NodeMask = 0;
+
+	return desc;
+}
+
+bool IndirectCommandLayout::changesRootArguments() const
+{
+	for (const auto& argument : mArguments)
+	{
+		switch (argument.Type)
+		{
+		case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT:
+		case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW:
+		case D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW:
+		case D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW:
+			return true;
+		default:
+			break;
+		}
+	}
+
+	return false;
+}
+
+uint32_t IndirectCommandLayout::add(const D3D12_INDIRECT_ARGUMENT_DESC& argument, uint32_t size)
+{
+	// The draw (or dispatch) has to be the last argument of a command
+	assert(mArguments.empty() || (mArguments.back().Type != D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED &&
+								  mArguments.back().Type != D3D12_INDIRECT_ARGUMENT_TYPE_DRAW));
+
+	mArguments.push_back(argument);
+	mOffsets.push_back(mByteStride);
+	mByteStride += size;
+
+	return static_cast<uint32_t>(mArguments.size() - 1);
+}
+
+IndirectCommandWriter::IndirectCommandWriter(const IndirectCommandLayout* layout, void* destination, uint32_t maxCommandCount)
+: mLayout(layout), mDestination(static_cast<uint8_t*>(destination)), mMaxCommandCount(maxCommandCount)
+{
+}
+
+bool IndirectCommandWriter::beginCommand()
+{
+	if (mCommandCount == mMaxCommandCount)
+	{
+		return false;
+	}
+
+	mCommandCount++;
+
+	return true;
+}
+
+void IndirectCommandWriter::setConstants(uint32_t argument, const void* data, uint32_t count)
+{
+	write(argument, data, count * sizeof(uint32_t));
+}
+
+void IndirectCommandWriter::setConstantBufferView(uint32_t argument, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+	write(argument, &address, sizeof(address));
+}
+
+void IndirectCommandWriter::setShaderResourceView(uint32_t argument, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+	write(argument, &address, sizeof(address));
+}
+
+void IndirectCommandWriter::setVertexBufferView(uint32_t argument, const D3D12_VERTEX_BUFFER_VIEW& view)
+{
+	write(argument, &view, sizeof(view));
+}
+
+void IndirectCommandWriter::setIndexBufferView(uint32_t argument, const D3D12_INDEX_BUFFER_VIEW& view)
+{
+	write(argument, &view, sizeof(view));
+}
+
+void IndirectCommandWriter::setDrawIndexed(uint32_t argument, uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+{
+	D3D12_DRAW_INDEXED_ARGUMENTS arguments{};
+	arguments.IndexCountPerInstance = indexCountPerInstance;
+	arguments.InstanceCount = instanceCount;
+	arguments.StartIndexLocation = startIndexLocation;
+	arguments.BaseVertexLocation = baseVertexLocation;
+	arguments.StartInstanceLocation = startInstanceLocation;
+
+	write(argument, &arguments, sizeof(arguments));
+}
+
+void IndirectCommandWriter::setDraw(uint32_t argument, uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+{
+	D3D12_DRAW_ARGUMENTS arguments{};
+	arguments.VertexCountPerInstance = vertexCountPerInstance;
+	arguments.InstanceCount = instanceCount;
+	arguments.StartVertexLocation = startVertexLocation;
+	arguments.StartInstanceLocation = startInstanceLocation;
+
+	write(argument, &arguments, sizeof(arguments));
+}
+
+void IndirectCommandWriter::write(uint32_t argument, const void* data, uint32_t size)
+{
+	assert(mCommandCount > 0 && size == mLayout->argumentSize(argument));
+
+	auto command = mDestination + static_cast<uint64_t>(mCommandCount - 1) * mLayout->byteStride();
+	std::memcpy(command + mLayout->argumentOffset(argument), data, size);
+}
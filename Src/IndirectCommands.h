@@ -0,0 +1,74 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <vector>
+
+// Byte layout of one ExecuteIndirect command: the arguments are packed tightly in the order they
+// are added, the draw comes last. The same layout describes the command signature and tells the
+// CPU writer (or a compute shader writing the buffer on the GPU) where each argument lives.
+class IndirectCommandLayout
+{
+public:
+	// Each returns the index of the argument, used to address it in IndirectCommandWriter.
+	uint32_t addConstants(uint32_t rootParameterIndex, uint32_t count, uint32_t destinationOffset = 0);
+	uint32_t addConstantBufferView(uint32_t rootParameterIndex);
+	uint32_t addShaderResourceView(uint32_t rootParameterIndex);
+	uint32_t addVertexBufferView(uint32_t slot);
+	uint32_t addIndexBufferView();
+	uint32_t addDrawIndexed();
+	uint32_t addDraw();
+
+	uint32_t argumentCount() const { return static_cast<uint32_t>(mArguments.size()); }
+	uint32_t argumentOffset(uint32_t argument) const { return mOffsets[argument]; }
+	uint32_t argumentSize(uint32_t argument) const;
+	const D3D12_INDIRECT_ARGUMENT_DESC& argument(uint32_t argument) const { return mArguments[argument]; }
+
+	uint32_t byteStride() const { return mByteStride; }
+
+	// Points into this layout, which has to outlive the CreateCommandSignature call.
+	D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc() const;
+
+	// Root signature arguments can only be changed with a root signature given to CreateCommandSignature.
+	bool changesRootArguments() const;
+
+private:
+	uint32_t add(const D3D12_INDIRECT_ARGUMENT_DESC& argument, uint32_t size);
+
+	std::vector<D3D12_INDIRECT_ARGUMENT_DESC> mArguments;
+	std::vector<uint32_t> mOffsets;
+	uint32_t mByteStride = 0;
+};
+
+// Packs commands of an IndirectCommandLayout into mapped memory, one command after the other.
+// Every argument of a command must be set; the writer does not clear what it skips.
+// Writes are sequential, which suits write-combined upload memory.
+class IndirectCommandWriter
+{
+public:
+	IndirectCommandWriter() = default;
+	IndirectCommandWriter(const IndirectCommandLayout* layout, void* destination, uint32_t maxCommandCount);
+
+	// Starts the next command, returns false when the destination is full.
+	bool beginCommand();
+
+	void setConstants(uint32_t argument, const void* data, uint32_t count);
+	void setConstantBufferView(uint32_t argument, D3D12_GPU_VIRTUAL_ADDRESS address);
+	void setShaderResourceView(uint32_t argument, D3D12_GPU_VIRTUAL_ADDRESS address);
+	void setVertexBufferView(uint32_t argument, const D3D12_VERTEX_BUFFER_VIEW& view);
+	void setIndexBufferView(uint32_t argument, const D3D12_INDEX_BUFFER_VIEW& view);
+	void setDrawIndexed(uint32_t argument, uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation);
+	void setDraw(uint32_t argument, uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation);
+
+	uint32_t commandCount() const { return mCommandCount; }
+	uint64_t byteSize() const { return static_cast<uint64_t>(mCommandCount) * mLayout->byteStride(); }
+
+private:
+	void write(uint32_t argument, const void* data, uint32_t size);
+
+	const IndirectCommandLayout* mLayout = nullptr;
+	uint8_t* mDestination = nullptr;
+	uint32_t mMaxCommandCount = 0;
+	uint32_t mCommandCount = 0;
+};
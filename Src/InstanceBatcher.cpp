@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "InstanceBatcher.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+	size_t combine(size_t hash, uint64_t value)
+	{
+		return hash ^ (std::hash<uint64_t>()(value) + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2));
+	}
+}
+
+size_t InstanceBatcher::hash(const InstanceKey& key)
+{
+	size_t hash = std::hash<uint64_t>()(key.mesh);
+	hash = combine(hash, key.material);
+	hash = combine(hash, key.pipeline);
+	hash = combine(hash, (static_cast<uint64_t>(key.indexCount) << 32) | key.startIndexLocation);
+	hash = combine(hash, static_cast<uint32_t>(key.baseVertexLocation));
+
+	return hash;
+}
+
+void InstanceBatcher::clear()
+{
+	std::fill(mSlots.begin(), mSlots.end(), 0u);
+	mItems.clear();
+	mBatches.clear();
+	mInstances.clear();
+}
+
+void InstanceBatcher::add(const InstanceKey& key, uint32_t item)
+{
+	if ((mBatches.size() + 1) * 2 > mSlots.size())
+	{
+		grow();
+	}
+
+	auto mask = mSlots.size() - 1;
+	auto slot = hash(key) & mask;
+
+	while (mSlots[slot] != 0 && !(mBatches[mSlots[slot] - 1].key == key))
+	{
+		slot = (slot + 1) & mask;
+	}
+
+	if (mSlots[slot] == 0)
+	{
+		InstanceBatch newBatch;
+		newBatch.key = key;
+		mBatches.push_back(newBatch);
+
+		mSlots[slot] = static_cast<uint32_t>(mBatches.size());
+	}
+
+	auto batch = mSlots[slot] - 1;
+
+	mBatches[batch].instanceCount++;
+	mItems.push_back({ item, batch });
+}
+
+void InstanceBatcher::grow()
+{
+	mSlots.assign(std::max<size_t>(mSlots.size() * 2, 64), 0u);
+
+	auto mask = mSlots.size() - 1;
+
+	for (uint32_t batch = 0; batch < mBatches.size(); batch++)
+	{
+		auto slot = hash(mBatches[batch].key) & mask;
+
+		while (mSlots[slot] != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		mSlots[slot] = batch + 1;
+	}
+}
+
+void InstanceBatcher::build()
+{
+	uint32_t offset = 0;
+
+	for (auto& batch : mBatches)
+	{
+		batch.firstInstance = offset;
+		offset += batch.instanceCount;
+
+		// Counts again while scattering
+		batch.instanceCount = 0;
+	}
+
+	mInstances.resize(mItems.size());
+
+	for (const auto& item : mItems)
+	{
+		auto& batch = mBatches[item.batch];
+		mInstances[batch.firstInstance + batch.instanceCount++] = item.id;
+	}
+}
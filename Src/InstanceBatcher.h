@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What has to match for two items to be drawn by one instanced draw. mesh, material and pipeline
+// are opaque identities (pointers in the app), the rest selects the submesh.
+struct InstanceKey
+{
+	uint64_t mesh = 0;
+	uint64_t material = 0;
+	uint64_t pipeline = 0;
+	uint32_t indexCount = 0;
+	uint32_t startIndexLocation = 0;
+	int32_t baseVertexLocation = 0;
+
+	bool operator==(const InstanceKey& other) const
+	{
+		return mesh == other.mesh && material == other.material && pipeline == other.pipeline && indexCount == other.indexCount &&
+			   startIndexLocation == other.startIndexLocation && baseVertexLocation == other.baseVertexLocation;
+	}
+};
+
+struct InstanceBatch
+{
+	InstanceKey key;
+
+	// Range in InstanceBatcher::instances().
+	uint32_t firstInstance = 0;
+	uint32_t instanceCount = 0;
+};
+
+// Groups draw items by InstanceKey. Batches come out in the order of their first item and the
+// items of a batch in the order they were added, so a front to back item order mostly survives.
+// Containers are cleared, not freed, between frames: batches are found through an open addressing
+// table of batch indices rather than a node based map.
+class InstanceBatcher
+{
+public:
+	void clear();
+
+	void add(const InstanceKey& key, uint32_t item);
+
+	void build();
+
+	const std::vector<InstanceBatch>& batches() const { return mBatches; }
+
+	// Item ids ordered batch by batch.
+	const std::vector<uint32_t>& instances() const { return mInstances; }
+
+	uint32_t itemCount() const { return static_cast<uint32_t>(mItems.size()); }
+
+private:
+	static size_t hash(const InstanceKey& key);
+
+	// Rebuilds mSlots with twice the slots, keeping it at most half full.
+	void grow();
+
+	struct Item
+	{
+		uint32_t id;
+		uint32_t batch;
+	};
+
+	// Batch index + 1 per slot, 0 for an empty slot. The size is a power of two.
+	std::vector<uint32_t> mSlots;
+	std::vector<Item> mItems;
+	std::vector<InstanceBatch> mBatches;
+	std::vector<uint32_t> mInstances;
+};
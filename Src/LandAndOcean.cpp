@@ -14,14 +14,21 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 	auto result = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
 
 	UNREFERENCED_PARAMETER(hPrevInstance);
-	UNREFERENCED_PARAMETER(lpCmdLine);
+
+	// Frames in flight can be chosen on the command line, e.g. -frames 2
+	uint32_t frameResourceCount = D3DApp::DefaultFrameResourceCount;
+
+	if (auto option = wcsstr(lpCmdLine, L"-frames"); option != nullptr)
+	{
+		frameResourceCount = static_cast<uint32_t>(wcstoul(option + wcslen(L"-frames"), nullptr, 10));
+	}
 
 	Console console;
 	console.outputDebugStringCapture();
 
 	try
 	{
-		D3DApp app;
+		D3DApp app(frameResourceCount);
 		if (!app.initialize(hInstance, nCmdShow))
 			return 0;
 
@@ -0,0 +1,16 @@
+#include "pch.h"
+#include "LinearAllocator.h"
+
+uint64_t LinearAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+	auto offset = (mOffset + alignment - 1) & ~(alignment - 1);
+
+	if (offset > mCapacity || size > mCapacity - offset)
+	{
+		return InvalidOffset;
+	}
+
+	mOffset = offset + size;
+
+	return offset;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+// Bump allocator over [0, capacity). Allocations are never freed one by one, reset() releases
+// all of them at once, which fits data that is rewritten every frame.
+class LinearAllocator
+{
+public:
+	static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+	LinearAllocator() = default;
+	explicit LinearAllocator(uint64_t capacity) : mCapacity(capacity) {}
+
+	// alignment must be a power of two. Returns InvalidOffset when the rest of the range is too small.
+	uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+	void reset() { mOffset = 0; }
+
+	uint64_t capacity() const { return mCapacity; }
+	uint64_t usedSize() const { return mOffset; }
+
+private:
+	uint64_t mCapacity = 0;
+	uint64_t mOffset = 0;
+};
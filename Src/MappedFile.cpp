@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+
+		std::swap(mFile, other.mFile);
+#ifdef _WIN32
+		std::swap(mMapping, other.mMapping);
+#endif
+		std::swap(mData, other.mData);
+		std::swap(mSize, other.mSize);
+	}
+
+	return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::filesystem::path& path)
+{
+	close();
+
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	mFile = file;
+
+	LARGE_INTEGER fileSize{};
+
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mMapping == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (mData == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData != nullptr)
+	{
+		UnmapViewOfFile(mData);
+	}
+
+	if (mMapping != nullptr)
+	{
+		CloseHandle(mMapping);
+	}
+
+	if (mFile != nullptr)
+	{
+		CloseHandle(mFile);
+	}
+
+	mFile = nullptr;
+	mMapping = nullptr;
+	mData = nullptr;
+	mSize = 0;
+}
+
+void MappedFile::prefetch(const void* data, size_t size) const
+{
+	if (mData == nullptr || size == 0)
+	{
+		return;
+	}
+
+	WIN32_MEMORY_RANGE_ENTRY range{ const_cast<void*>(data), size };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#else
+bool MappedFile::open(const std::filesystem::path& path)
+{
+	close();
+
+	mFile = ::open(path.c_str(), O_RDONLY);
+
+	if (mFile < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat {};
+
+	if (fstat(mFile, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	mData = static_cast<const uint8_t*>(data);
+	mSize = static_cast<size_t>(fileStat.st_size);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(mData), mSize);
+	}
+
+	if (mFile >= 0)
+	{
+		::close(mFile);
+	}
+
+	mFile = -1;
+	mData = nullptr;
+	mSize = 0;
+}
+
+void MappedFile::prefetch(const void* data, size_t size) const
+{
+	if (mData == nullptr || size == 0)
+	{
+		return;
+	}
+
+	// madvise wants a page aligned start
+	auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+	auto begin = reinterpret_cast<uintptr_t>(data) & ~(pageSize - 1);
+	auto end = reinterpret_cast<uintptr_t>(data) + size;
+
+	madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Read-only memory mapping of a whole file (MapViewOfFile on Windows, mmap elsewhere).
+// Pages are only read from disk when first touched, and they are backed by the file
+// rather than private memory, so pointers into the mapping can be handed out without copying.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// Fails for an empty file, there is nothing to map. The OS error (GetLastError, errno) is
+	// only meaningful when the file could not be opened or mapped, not in that case.
+	bool open(const std::filesystem::path& path);
+	void close();
+
+	bool isOpen() const { return mData != nullptr; }
+	const uint8_t* data() const { return mData; }
+	size_t size() const { return mSize; }
+
+	// Asks the OS to start reading [data, data + size) ahead of use. The range must lie inside the mapping.
+	void prefetch(const void* data, size_t size) const;
+
+private:
+#ifdef _WIN32
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#else
+	int mFile = -1;
+#endif
+	const uint8_t* mData = nullptr;
+	size_t mSize = 0;
+};
@@ -0,0 +1,441 @@
+#include "pch.h"
+#include "MipGenerator.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIP_GENERATOR_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t LinearTableSize = 1 << 14;
+
+	// Rows below this are not worth a thread.
+	constexpr uint32_t MinRowsPerThread = 16;
+
+	float srgbToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float linearToSrgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	struct ColorTables
+	{
+		ColorTables()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				unorm[i] = i / 255.0f;
+				toLinear[i] = srgbToLinear(unorm[i]);
+			}
+
+			for (uint32_t i = 0; i < LinearTableSize; i++)
+			{
+				auto value = linearToSrgb(static_cast<float>(i) / (LinearTableSize - 1));
+				fromLinear[i] = static_cast<uint8_t>(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f));
+			}
+		}
+
+		float unorm[256];
+		float toLinear[256];
+		uint8_t fromLinear[LinearTableSize];
+	};
+
+	const ColorTables& colorTables()
+	{
+		static const ColorTables tables;
+		return tables;
+	}
+
+	struct FilterTap
+	{
+		uint32_t index;
+		float weight;
+	};
+
+	// Per destination texel list of weighted source texels along one axis.
+	struct FilterKernel
+	{
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> counts;
+		std::vector<FilterTap> taps;
+	};
+
+	void addTap(std::vector<FilterTap>& taps, size_t first, uint32_t index, float weight)
+	{
+		// Taps clamped to the border collapse into one.
+		for (size_t i = first; i < taps.size(); i++)
+		{
+			if (taps[i].index == index)
+			{
+				taps[i].weight += weight;
+				return;
+			}
+		}
+
+		taps.push_back({ index, weight });
+	}
+
+	void normalizeTaps(std::vector<FilterTap>& taps, size_t first)
+	{
+		float sum = 0.0f;
+
+		for (size_t i = first; i < taps.size(); i++)
+		{
+			sum += taps[i].weight;
+		}
+
+		for (size_t i = first; i < taps.size(); i++)
+		{
+			taps[i].weight /= sum;
+		}
+	}
+
+	float besselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		float halfX = x * 0.5f;
+
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (halfX / k) * (halfX / k);
+			sum += term;
+
+			if (term < sum * 1e-8f)
+			{
+				break;
+			}
+		}
+
+		return sum;
+	}
+
+	float kaiser(float t, float width, float alpha)
+	{
+		auto x = t / width;
+
+		if (std::abs(x) >= 1.0f)
+		{
+			return 0.0f;
+		}
+
+		auto sinc = t == 0.0f ? 1.0f : std::sin(3.14159265f * t) / (3.14159265f * t);
+
+		return sinc * besselI0(alpha * std::sqrt(1.0f - x * x)) / besselI0(alpha);
+	}
+
+	FilterKernel createFilterKernel(uint32_t sourceSize, uint32_t destinationSize, const MipGenerationOptions& options)
+	{
+		FilterKernel kernel;
+		kernel.offsets.resize(destinationSize);
+		kernel.counts.resize(destinationSize);
+
+		auto scale = static_cast<float>(sourceSize) / destinationSize;
+
+		for (uint32_t x = 0; x < destinationSize; x++)
+		{
+			auto first = kernel.taps.size();
+
+			if (options.filter == MipFilter::Box)
+			{
+				// Weight every source texel by how much of it the destination footprint covers
+				auto low = x * scale;
+				auto high = (x + 1) * scale;
+
+				for (auto i = static_cast<uint32_t>(low); i < sourceSize && i < high; i++)
+				{
+					auto coverage = std::min(high, i + 1.0f) - std::max(low, static_cast<float>(i));
+
+					if (coverage > 0.0f)
+					{
+						addTap(kernel.taps, first, i, coverage);
+					}
+				}
+			}
+			else
+			{
+				auto center = (x + 0.5f) * scale;
+				auto radius = options.kaiserWidth * scale;
+				auto begin = static_cast<int32_t>(std::floor(center - radius));
+				auto end = static_cast<int32_t>(std::ceil(center + radius));
+
+				for (auto i = begin; i <= end; i++)
+				{
+					auto weight = kaiser((i + 0.5f - center) / scale, options.kaiserWidth, options.kaiserAlpha);
+
+					if (weight != 0.0f)
+					{
+						auto index = static_cast<uint32_t>(std::clamp(i, 0, static_cast<int32_t>(sourceSize) - 1));
+						addTap(kernel.taps, first, index, weight);
+					}
+				}
+			}
+
+			normalizeTaps(kernel.taps, first);
+
+			kernel.offsets[x] = static_cast<uint32_t>(first);
+			kernel.counts[x] = static_cast<uint32_t>(kernel.taps.size() - first);
+		}
+
+		return kernel;
+	}
+
+	// destination += source * weight for count RGBA float texels
+	void accumulate(float* destination, const float* source, float weight, uint32_t count)
+	{
+#if MIP_GENERATOR_SSE
+		auto w = _mm_set1_ps(weight);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			auto sum = _mm_add_ps(_mm_loadu_ps(destination + i * 4), _mm_mul_ps(_mm_loadu_ps(source + i * 4), w));
+			_mm_storeu_ps(destination + i * 4, sum);
+		}
+#else
+		for (uint32_t i = 0; i < count * 4; i++)
+		{
+			destination[i] += source[i] * weight;
+		}
+#endif
+	}
+
+	void filterRow(float* destination, const float* source, const FilterKernel& kernel, uint32_t width)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const auto* tap = kernel.taps.data() + kernel.offsets[x];
+			auto tapCount = kernel.counts[x];
+
+#if MIP_GENERATOR_SSE
+			auto sum = _mm_setzero_ps();
+
+			for (uint32_t i = 0; i < tapCount; i++)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + tap[i].index * 4), _mm_set1_ps(tap[i].weight)));
+			}
+
+			_mm_storeu_ps(destination + x * 4, sum);
+#else
+			float sum[4] = {};
+
+			for (uint32_t i = 0; i < tapCount; i++)
+			{
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					sum[c] += source[tap[i].index * 4 + c] * tap[i].weight;
+				}
+			}
+
+			memcpy(destination + x * 4, sum, sizeof(sum));
+#endif
+		}
+	}
+
+	// Grey and grey + alpha texels are filtered as (grey, 0, 0, alpha) so every
+	// format shares the RGBA float filter.
+	void decodeRows(float* destination, const uint8_t* pixels, uint32_t width, size_t rowPitch, uint32_t channels, uint32_t begin, uint32_t end, bool sRGB)
+	{
+		const auto& tables = colorTables();
+		const auto* colorTable = sRGB ? tables.toLinear : tables.unorm;
+
+		for (auto y = begin; y < end; y++)
+		{
+			const auto* source = pixels + y * rowPitch;
+			auto* row = destination + static_cast<size_t>(y) * width * 4;
+
+			for (uint32_t x = 0; x < width; x++, source += channels)
+			{
+				auto* texel = row + x * 4;
+
+				if (channels == 4)
+				{
+					texel[0] = colorTable[source[0]];
+					texel[1] = colorTable[source[1]];
+					texel[2] = colorTable[source[2]];
+					texel[3] = tables.unorm[source[3]];
+				}
+				else
+				{
+					texel[0] = colorTable[source[0]];
+					texel[1] = 0.0f;
+					texel[2] = 0.0f;
+					texel[3] = channels == 2 ? tables.unorm[source[1]] : 1.0f;
+				}
+			}
+		}
+	}
+
+	uint8_t encodeUnorm(float value)
+	{
+		return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	uint8_t encodeSrgb(float value)
+	{
+		return colorTables().fromLinear[static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * (LinearTableSize - 1) + 0.5f)];
+	}
+
+	void encodeRows(uint8_t* pixels, const float* source, uint32_t width, size_t rowPitch, uint32_t channels, uint32_t begin, uint32_t end, bool sRGB)
+	{
+		// Color channels of a texel, alpha is last and always linear.
+		auto colorChannels = channels == 4 ? 3u : 1u;
+
+		for (auto y = begin; y < end; y++)
+		{
+			const auto* row = source + static_cast<size_t>(y) * width * 4;
+			auto* destination = pixels + y * rowPitch;
+
+			for (uint32_t x = 0; x < width; x++, destination += channels)
+			{
+				const auto* texel = row + x * 4;
+
+				for (uint32_t c = 0; c < colorChannels; c++)
+				{
+					destination[c] = sRGB ? encodeSrgb(texel[c]) : encodeUnorm(texel[c]);
+				}
+
+				if (channels != 1)
+				{
+					destination[channels - 1] = encodeUnorm(texel[3]);
+				}
+			}
+		}
+	}
+}
+
+uint32_t calculateMipLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levelCount = 1;
+
+	while (width > 1 || height > 1)
+	{
+		width = std::max(1u, width >> 1);
+		height = std::max(1u, height >> 1);
+		levelCount++;
+	}
+
+	return levelCount;
+}
+
+MipChain createMipChain(uint32_t width, uint32_t height, uint32_t maxLevels, uint32_t channels)
+{
+	assert(channels == 1 || channels == 2 || channels == 4);
+
+	MipChain chain;
+	chain.channels = channels;
+
+	auto levelCount = calculateMipLevelCount(width, height);
+
+	if (maxLevels > 0)
+	{
+		levelCount = std::min(levelCount, maxLevels);
+	}
+
+	size_t dataSize = 0;
+
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		MipLevel mipLevel;
+		mipLevel.width = std::max(1u, width >> level);
+		mipLevel.height = std::max(1u, height >> level);
+		mipLevel.rowPitch = static_cast<size_t>(mipLevel.width) * channels;
+		mipLevel.offset = dataSize;
+
+		dataSize += mipLevel.rowPitch * mipLevel.height;
+
+		chain.levels.push_back(mipLevel);
+	}
+
+	chain.data.resize(dataSize);
+
+	return chain;
+}
+
+void generateMips(MipChain& chain, const MipGenerationOptions& options)
+{
+	if (chain.levels.size() <= 1)
+	{
+		return;
+	}
+
+	auto threadCount = resolveThreadCount(options.threadCount);
+
+	const auto& base = chain.levels[0];
+
+	std::vector<float> source(static_cast<size_t>(base.width) * base.height * 4);
+	std::vector<float> horizontal;
+	std::vector<float> destination;
+
+	parallelFor(base.height, threadCount, MinRowsPerThread, [&](uint32_t begin, uint32_t end)
+	{
+		decodeRows(source.data(), chain.levelData(0), base.width, base.rowPitch, chain.channels, begin, end, options.sRGB);
+	});
+
+	for (uint32_t level = 1; level < chain.levels.size(); level++)
+	{
+		const auto& previous = chain.levels[level - 1];
+		const auto& current = chain.levels[level];
+
+		auto horizontalKernel = createFilterKernel(previous.width, current.width, options);
+		auto verticalKernel = createFilterKernel(previous.height, current.height, options);
+
+		// Horizontal pass: previous.height rows of current.width texels
+		horizontal.assign(static_cast<size_t>(current.width) * previous.height * 4, 0.0f);
+
+		parallelFor(previous.height, threadCount, MinRowsPerThread, [&](uint32_t begin, uint32_t end)
+		{
+			for (auto y = begin; y < end; y++)
+			{
+				filterRow(horizontal.data() + static_cast<size_t>(y) * current.width * 4,
+						  source.data() + static_cast<size_t>(y) * previous.width * 4,
+						  horizontalKernel, current.width);
+			}
+		});
+
+		// Vertical pass: blend whole rows of the horizontal result
+		destination.assign(static_cast<size_t>(current.width) * current.height * 4, 0.0f);
+
+		parallelFor(current.height, threadCount, MinRowsPerThread, [&](uint32_t begin, uint32_t end)
+		{
+			for (auto y = begin; y < end; y++)
+			{
+				auto* row = destination.data() + static_cast<size_t>(y) * current.width * 4;
+
+				for (uint32_t i = 0; i < verticalKernel.counts[y]; i++)
+				{
+					const auto& tap = verticalKernel.taps[verticalKernel.offsets[y] + i];
+					accumulate(row, horizontal.data() + static_cast<size_t>(tap.index) * current.width * 4, tap.weight, current.width);
+				}
+			}
+
+			encodeRows(chain.levelData(level), destination.data(), current.width, current.rowPitch, chain.channels, begin, end, options.sRGB);
+		});
+
+		std::swap(source, destination);
+	}
+}
+
+MipChain generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, uint32_t maxLevels, const MipGenerationOptions& options)
+{
+	auto chain = createMipChain(width, height, maxLevels);
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		memcpy(chain.data.data() + y * chain.levels[0].rowPitch, pixels + y * rowPitch, chain.levels[0].rowPitch);
+	}
+
+	generateMips(chain, options);
+
+	return chain;
+}
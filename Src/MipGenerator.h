@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class MipFilter
+{
+	// Area-weighted box filter, exact for odd (non power of two) sizes.
+	Box,
+	// Kaiser-windowed sinc, sharper than box with little ringing.
+	Kaiser
+};
+
+struct MipGenerationOptions
+{
+	MipFilter filter = MipFilter::Box;
+
+	// Treat RGB as sRGB encoded: linearize before filtering and re-encode afterwards.
+	// Alpha is always filtered linearly.
+	bool sRGB = true;
+
+	// 0 uses std::thread::hardware_concurrency().
+	uint32_t threadCount = 0;
+
+	// Kaiser window parameters, the width is in destination texels.
+	float kaiserAlpha = 4.0f;
+	float kaiserWidth = 3.0f;
+};
+
+struct MipLevel
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	size_t rowPitch = 0;
+	size_t offset = 0;
+};
+
+// All levels of an 8 bit per channel image packed back to back in one allocation,
+// level 0 included, so it can be handed to UpdateSubresources as is.
+struct MipChain
+{
+	std::vector<MipLevel> levels;
+	std::vector<uint8_t> data;
+
+	// 1 (grey), 2 (grey + alpha) or 4 (RGBA). The last channel of 2 and 4 is alpha.
+	uint32_t channels = 4;
+
+	uint8_t* levelData(uint32_t level) { return data.data() + levels[level].offset; }
+	const uint8_t* levelData(uint32_t level) const { return data.data() + levels[level].offset; }
+};
+
+uint32_t calculateMipLevelCount(uint32_t width, uint32_t height);
+
+// Lays out an uninitialized chain, maxLevels = 0 means the full chain down to 1x1.
+// Level 0 can then be written (or decoded) in place before calling generateMips.
+MipChain createMipChain(uint32_t width, uint32_t height, uint32_t maxLevels = 0, uint32_t channels = 4);
+
+// Filters levels 1..n from level 0. Each level is filtered from the previous one,
+// the rows of a level are split across worker threads and the inner loops use SSE when available.
+void generateMips(MipChain& chain, const MipGenerationOptions& options = {});
+
+// Convenience wrapper: copies a RGBA8 image into a new chain and generates its mips.
+MipChain generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, uint32_t maxLevels = 0, const MipGenerationOptions& options = {});
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Resolves a requested worker count, 0 meaning one per hardware thread.
+inline uint32_t resolveThreadCount(uint32_t threadCount)
+{
+	return threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Splits [0, count) into at most threadCount contiguous chunks of at least minChunkSize items
+// and runs function(begin, end) on each. The calling thread processes the first chunk.
+template<typename Function>
+void parallelFor(uint32_t count, uint32_t threadCount, uint32_t minChunkSize, const Function& function)
+{
+	auto chunkCount = std::min(resolveThreadCount(threadCount), std::max(1u, count / std::max(1u, minChunkSize)));
+
+	if (chunkCount <= 1)
+	{
+		function(0u, count);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(chunkCount - 1);
+
+	auto chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	for (uint32_t chunk = 1; chunk < chunkCount; chunk++)
+	{
+		auto begin = std::min(count, chunk * chunkSize);
+		auto end = std::min(count, begin + chunkSize);
+		workers.emplace_back([&function, begin, end]() { function(begin, end); });
+	}
+
+	function(0u, std::min(count, chunkSize));
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
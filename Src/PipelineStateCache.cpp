@@ -0,0 +1,481 @@
+#include "pch.h"
+#include "PipelineStateCache.h"
+#include "AssetCache.h"
+#include "MappedFile.h"
+#include "TaskScheduler.h"
+#include "DXException.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unordered_set>
+
+namespace
+{
+	struct PipelineLibraryFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+
+	constexpr uint32_t PipelineLibraryMagic = 0x4C4F5350;	// "PSOL"
+	constexpr uint32_t PipelineLibraryVersion = 1;
+
+	// Collects the fields of a description as bytes, the key is the hash of them
+	class KeyWriter
+	{
+	public:
+		template <typename T>
+		void write(const T& value)
+		{
+			static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Write fields one by one so no padding gets in");
+
+			auto bytes = reinterpret_cast<const uint8_t*>(&value);
+			mBytes.insert(mBytes.end(), bytes, bytes + sizeof(T));
+		}
+
+		// Semantics are case insensitive
+		void writeSemantic(const char* semantic)
+		{
+			auto length = semantic != nullptr ? std::strlen(semantic) : 0;
+			write(static_cast<uint32_t>(length));
+
+			for (size_t i = 0; i < length; i++)
+			{
+				auto character = semantic[i];
+				write(static_cast<char>(character >= 'a' && character <= 'z' ? character - 'a' + 'A' : character));
+			}
+		}
+
+		void writeBytecode(const D3D12_SHADER_BYTECODE& bytecode)
+		{
+			write(static_cast<uint64_t>(bytecode.BytecodeLength));
+			write(bytecode.BytecodeLength > 0 ? hashAssetContent(bytecode.pShaderBytecode, bytecode.BytecodeLength) : 0ull);
+		}
+
+		uint64_t hash() const { return hashAssetContent(mBytes.data(), mBytes.size()); }
+
+	private:
+		std::vector<uint8_t> mBytes;
+	};
+
+	void writeBlendState(KeyWriter& writer, const D3D12_BLEND_DESC& blendState)
+	{
+		writer.write(blendState.AlphaToCoverageEnable);
+		writer.write(blendState.IndependentBlendEnable);
+
+		// Without independent blending only the first render target's state is used
+		uint32_t renderTargetCount = blendState.IndependentBlendEnable ? D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT : 1;
+
+		for (uint32_t i = 0; i < renderTargetCount; i++)
+		{
+			const auto& renderTarget = blendState.RenderTarget[i];
+			writer.write(renderTarget.BlendEnable);
+			writer.write(renderTarget.LogicOpEnable);
+			writer.write(renderTarget.SrcBlend);
+			writer.write(renderTarget.DestBlend);
+			writer.write(renderTarget.BlendOp);
+			writer.write(renderTarget.SrcBlendAlpha);
+			writer.write(renderTarget.DestBlendAlpha);
+			writer.write(renderTarget.BlendOpAlpha);
+			writer.write(renderTarget.LogicOp);
+			writer.write(renderTarget.RenderTargetWriteMask);
+		}
+	}
+
+	void writeRasterizerState(KeyWriter& writer, const D3D12_RASTERIZER_DESC& rasterizerState)
+	{
+		writer.write(rasterizerState.FillMode);
+		writer.write(rasterizerState.CullMode);
+		writer.write(rasterizerState.FrontCounterClockwise);
+		writer.write(rasterizerState.DepthBias);
+		writer.write(rasterizerState.DepthBiasClamp);
+		writer.write(rasterizerState.SlopeScaledDepthBias);
+		writer.write(rasterizerState.DepthClipEnable);
+		writer.write(rasterizerState.MultisampleEnable);
+		writer.write(rasterizerState.AntialiasedLineEnable);
+		writer.write(rasterizerState.ForcedSampleCount);
+		writer.write(rasterizerState.ConservativeRaster);
+	}
+
+	void writeStencilOp(KeyWriter& writer, const D3D12_DEPTH_STENCILOP_DESC& stencilOp)
+	{
+		writer.write(stencilOp.StencilFailOp);
+		writer.write(stencilOp.StencilDepthFailOp);
+		writer.write(stencilOp.StencilPassOp);
+		writer.write(stencilOp.StencilFunc);
+	}
+
+	void writeDepthStencilState(KeyWriter& writer, const D3D12_DEPTH_STENCIL_DESC& depthStencilState)
+	{
+		writer.write(depthStencilState.DepthEnable);
+		writer.write(depthStencilState.DepthWriteMask);
+		writer.write(depthStencilState.DepthFunc);
+		writer.write(depthStencilState.StencilEnable);
+		writer.write(depthStencilState.StencilReadMask);
+		writer.write(depthStencilState.StencilWriteMask);
+		writeStencilOp(writer, depthStencilState.FrontFace);
+		writeStencilOp(writer, depthStencilState.BackFace);
+	}
+
+	void writeStreamOutput(KeyWriter& writer, const D3D12_STREAM_OUTPUT_DESC& streamOutput)
+	{
+		writer.write(streamOutput.NumEntries);
+
+		for (uint32_t i = 0; i < streamOutput.NumEntries; i++)
+		{
+			const auto& entry = streamOutput.pSODeclaration[i];
+			writer.write(entry.Stream);
+			writer.writeSemantic(entry.SemanticName);
+			writer.write(entry.SemanticIndex);
+			writer.write(entry.StartComponent);
+			writer.write(entry.ComponentCount);
+			writer.write(entry.OutputSlot);
+		}
+
+		writer.write(streamOutput.NumStrides);
+
+		for (uint32_t i = 0; i < streamOutput.NumStrides; i++)
+		{
+			writer.write(streamOutput.pBufferStrides[i]);
+		}
+
+		writer.write(streamOutput.RasterizedStream);
+	}
+
+	void writeInputLayout(KeyWriter& writer, const D3D12_INPUT_LAYOUT_DESC& inputLayout)
+	{
+		writer.write(inputLayout.NumElements);
+
+		for (uint32_t i = 0; i < inputLayout.NumElements; i++)
+		{
+			const auto& element = inputLayout.pInputElementDescs[i];
+			writer.writeSemantic(element.SemanticName);
+			writer.write(element.SemanticIndex);
+			writer.write(element.Format);
+			writer.write(element.InputSlot);
+			writer.write(element.AlignedByteOffset);
+			writer.write(element.InputSlotClass);
+			writer.write(element.InstanceDataStepRate);
+		}
+	}
+}
+
+uint64_t hashGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+	KeyWriter writer;
+
+	writer.write(rootSignatureHash);
+
+	writer.writeBytecode(desc.VS);
+	writer.writeBytecode(desc.PS);
+	writer.writeBytecode(desc.DS);
+	writer.writeBytecode(desc.HS);
+	writer.writeBytecode(desc.GS);
+
+	writeStreamOutput(writer, desc.StreamOutput);
+	writeBlendState(writer, desc.BlendState);
+	writer.write(desc.SampleMask);
+	writeRasterizerState(writer, desc.RasterizerState);
+	writeDepthStencilState(writer, desc.DepthStencilState);
+	writeInputLayout(writer, desc.InputLayout);
+
+	writer.write(desc.IBStripCutValue);
+	writer.write(desc.PrimitiveTopologyType);
+
+	// Formats of unused render targets do not matter
+	writer.write(desc.NumRenderTargets);
+
+	for (uint32_t i = 0; i < desc.NumRenderTargets && i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+	{
+		writer.write(desc.RTVFormats[i]);
+	}
+
+	writer.write(desc.DSVFormat);
+	writer.write(desc.SampleDesc.Count);
+	writer.write(desc.SampleDesc.Quality);
+	writer.write(desc.NodeMask);
+	writer.write(desc.Flags);
+
+	return writer.hash();
+}
+
+std::wstring pipelineLibraryName(uint64_t pipelineStateHash)
+{
+	std::wstring name(16, L'0');
+
+	for (int i = 15; i >= 0; i--)
+	{
+		name[i] = L"0123456789ABCDEF"[pipelineStateHash & 0xF];
+		pipelineStateHash >>= 4;
+	}
+
+	return name;
+}
+
+std::vector<uint8_t> packPipelineLibrary(const void* data, size_t size)
+{
+	PipelineLibraryFileHeader header{};
+	header.magic = PipelineLibraryMagic;
+	header.version = PipelineLibraryVersion;
+	header.dataSize = size;
+	header.dataHash = hashAssetContent(data, size);
+
+	std::vector<uint8_t> file(sizeof(header) + size);
+	std::memcpy(file.data(), &header, sizeof(header));
+
+	if (size > 0)
+	{
+		std::memcpy(file.data() + sizeof(header), data, size);
+	}
+
+	return file;
+}
+
+bool unpackPipelineLibrary(const uint8_t* file, size_t fileSize, const uint8_t*& data, size_t& size)
+{
+	if (file == nullptr || fileSize < sizeof(PipelineLibraryFileHeader))
+	{
+		return false;
+	}
+
+	PipelineLibraryFileHeader header{};
+	std::memcpy(&header, file, sizeof(header));
+
+	if (header.magic != PipelineLibraryMagic || header.version != PipelineLibraryVersion ||
+		header.dataSize != fileSize - sizeof(header) || header.dataSize == 0)
+	{
+		return false;
+	}
+
+	if (hashAssetContent(file + sizeof(header), static_cast<size_t>(header.dataSize)) != header.dataHash)
+	{
+		return false;
+	}
+
+	data = file + sizeof(header);
+	size = static_cast<size_t>(header.dataSize);
+
+	return true;
+}
+
+PipelineStateCache::PipelineStateCache(ID3D12Device* device, const std::filesystem::path& libraryPath)
+: mDevice(device), mLibraryPath(libraryPath)
+{
+	if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&mDevice1))))
+	{
+		createLibrary();
+	}
+}
+
+void PipelineStateCache::createLibrary()
+{
+	MappedFile file;
+
+	if (file.open(mLibraryPath))
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+
+		if (unpackPipelineLibrary(file.data(), file.size(), data, size))
+		{
+			mLibraryData.assign(data, data + size);
+		}
+
+		// Closed before save() replaces the file
+		file.close();
+	}
+
+	// A library made by another adapter or driver version is refused, then start over with an empty one
+	if (!mLibraryData.empty() && SUCCEEDED(mDevice1->CreatePipelineLibrary(mLibraryData.data(), mLibraryData.size(), IID_PPV_ARGS(&mLibrary))))
+	{
+		mStatistics.libraryLoaded = true;
+		return;
+	}
+
+	mLibraryData.clear();
+
+	if (FAILED(mDevice1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&mLibrary))))
+	{
+		mLibrary.Reset();
+	}
+}
+
+void PipelineStateCache::request(const std::string& name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+	mStatistics.requested++;
+
+	auto hash = hashGraphicsPipelineState(desc, rootSignatureHash);
+
+	// Only the first request of a name since createPending() has something to go back to
+	auto previous = mNames.find(name);
+	mPreviousNames.emplace(name, previous != mNames.end() ? std::optional<uint64_t>(previous->second) : std::nullopt);
+
+	mNames[name] = hash;
+
+	if (mEntries.count(hash) > 0)
+	{
+		return;
+	}
+
+	Entry entry;
+	entry.desc = desc;
+	entry.desc.CachedPSO = {};
+
+	mEntries.emplace(hash, std::move(entry));
+	mPending.push_back(hash);
+	mStatistics.unique++;
+}
+
+void PipelineStateCache::createPending(TaskScheduler& scheduler)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	try
+	{
+		createPendingEntries(scheduler);
+	}
+	catch (...)
+	{
+		// Undo the requests, whoever asks for a name gets the PSO it had before
+		for (auto hash : mPending)
+		{
+			mEntries.erase(hash);
+		}
+
+		for (const auto& previous : mPreviousNames)
+		{
+			if (previous.second && mEntries.count(*previous.second) > 0)
+			{
+				mNames[previous.first] = *previous.second;
+			}
+			else
+			{
+				mNames.erase(previous.first);
+			}
+		}
+
+		mPending.clear();
+		mPreviousNames.clear();
+		mStatistics.unique = static_cast<uint32_t>(mEntries.size());
+
+		throw;
+	}
+
+	mPending.clear();
+	mPreviousNames.clear();
+
+	mStatistics.createMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PipelineStateCache::createPendingEntries(TaskScheduler& scheduler)
+{
+	scheduler.run(static_cast<uint32_t>(mPending.size()), [this](uint32_t taskIndex, uint32_t /*threadIndex*/)
+	{
+		auto hash = mPending[taskIndex];
+		auto& entry = mEntries.at(hash);
+		auto name = pipelineLibraryName(hash);
+
+		// Loading is free threaded, the lookups of all workers run at the same time
+		if (mLibrary && SUCCEEDED(mLibrary->LoadGraphicsPipeline(name.c_str(), &entry.desc, IID_PPV_ARGS(&entry.pipelineState))))
+		{
+			std::lock_guard<std::mutex> lock(mLibraryMutex);
+			mStatistics.libraryHits++;
+			return;
+		}
+
+		// The expensive part, so outside the lock
+		DXCheck(mDevice->CreateGraphicsPipelineState(&entry.desc, IID_PPV_ARGS(&entry.pipelineState)),
+			L"ID3D12Device::CreateGraphicsPipelineState failed!");
+
+		std::lock_guard<std::mutex> lock(mLibraryMutex);
+
+		mStatistics.compiled++;
+
+		if (mLibrary && SUCCEEDED(mLibrary->StorePipeline(name.c_str(), entry.pipelineState.Get())))
+		{
+			mLibraryDirty = true;
+		}
+	});
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineStateCache::get(const std::string& name) const
+{
+	auto hash = mNames.find(name);
+	assert(hash != mNames.end());
+
+	auto& entry = mEntries.at(hash->second);
+	assert(entry.pipelineState);
+
+	return entry.pipelineState;
+}
+
+void PipelineStateCache::releaseUnreferenced()
+{
+	std::unordered_set<uint64_t> referenced;
+
+	for (const auto& name : mNames)
+	{
+		referenced.insert(name.second);
+	}
+
+	for (auto entry = mEntries.begin(); entry != mEntries.end();)
+	{
+		entry = referenced.count(entry->first) > 0 ? std::next(entry) : mEntries.erase(entry);
+	}
+
+	mStatistics.unique = static_cast<uint32_t>(mEntries.size());
+}
+
+bool PipelineStateCache::save()
+{
+	if (!mLibrary || !mLibraryDirty)
+	{
+		return true;
+	}
+
+	std::vector<uint8_t> data(mLibrary->GetSerializedSize());
+
+	if (data.empty() || FAILED(mLibrary->Serialize(data.data(), data.size())))
+	{
+		return false;
+	}
+
+	auto file = packPipelineLibrary(data.data(), data.size());
+
+	std::error_code error;
+
+	if (mLibraryPath.has_parent_path())
+	{
+		std::filesystem::create_directories(mLibraryPath.parent_path(), error);
+	}
+
+	// A crash while writing leaves the previous library intact
+	auto temporaryPath = mLibraryPath;
+	temporaryPath += ".tmp";
+
+	{
+		std::ofstream output(temporaryPath, std::ios::binary);
+
+		if (!output || !output.write(reinterpret_cast<const char*>(file.data()), file.size()))
+		{
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, mLibraryPath, error);
+
+	if (error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	mLibraryDirty = false;
+
+	return true;
+}
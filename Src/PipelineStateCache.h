@@ -0,0 +1,113 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TaskScheduler;
+
+// Canonical 64 bit key of a graphics PSO description: shader bytecode by content, every fixed
+// function state by value field by field (so padding never matters), input layout semantics by
+// name. Pointers never go into the key; the root signature is identified by rootSignatureHash,
+// the hash of the blob it was created from. CachedPSO is ignored.
+uint64_t hashGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+// Name a PSO is stored under in the pipeline library, the key as 16 hex digits.
+std::wstring pipelineLibraryName(uint64_t pipelineStateHash);
+
+// The pipeline library file is a small header followed by what ID3D12PipelineLibrary::Serialize wrote.
+// The driver checks that the blob fits the adapter and driver version, the header catches files of
+// another format version and truncated or damaged ones before the blob is handed to it.
+std::vector<uint8_t> packPipelineLibrary(const void* data, size_t size);
+
+// Points data at the serialized library inside file, false when the header does not check out.
+bool unpackPipelineLibrary(const uint8_t* file, size_t fileSize, const uint8_t*& data, size_t& size);
+
+struct PipelineStateCacheStatistics
+{
+	// request() calls, and the distinct descriptions among them
+	uint32_t requested = 0;
+	uint32_t unique = 0;
+
+	// Distinct descriptions loaded from the pipeline library, and compiled by the driver
+	uint32_t libraryHits = 0;
+	uint32_t compiled = 0;
+
+	// A library from an earlier run was accepted by the driver
+	bool libraryLoaded = false;
+
+	// Wall time of the last createPending()
+	double createMilliseconds = 0.0;
+};
+
+// Graphics PSOs keyed by hashGraphicsPipelineState(). request() only queues a description, names
+// whose descriptions hash the same share one PSO; createPending() then creates the new ones on the
+// worker threads, loading each from the ID3D12PipelineLibrary read from libraryPath when it is there
+// and compiling and storing it otherwise. save() writes the library back when something was added.
+// Without ID3D12Device1, or when the driver refuses libraries, PSOs are just created.
+class PipelineStateCache
+{
+public:
+	PipelineStateCache(ID3D12Device* device, const std::filesystem::path& libraryPath);
+	PipelineStateCache(const PipelineStateCache& rhs) = delete;
+	PipelineStateCache& operator=(const PipelineStateCache& rhs) = delete;
+
+	// Everything desc points to (shader bytecode, input layout, root signature) must stay alive
+	// until createPending() returns. Requesting a name again replaces its description.
+	void request(const std::string& name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+	// Throws if the driver fails to create a PSO. The requests since the last createPending() are
+	// undone then: their new PSOs are dropped and every name refers to the PSO it had before.
+	void createPending(TaskScheduler& scheduler);
+
+	// The PSO of a requested name, once created.
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> get(const std::string& name) const;
+
+	// Drops the PSOs no name refers to any more, such as the ones a shader reload replaced.
+	// Whoever still draws with one keeps its own reference until the GPU is done with it.
+	void releaseUnreferenced();
+
+	// Writes the library to libraryPath through a temporary file, false if that failed.
+	bool save();
+
+	const PipelineStateCacheStatistics& statistics() const { return mStatistics; }
+
+private:
+	struct Entry
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc{};
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+	};
+
+	void createLibrary();
+	void createPendingEntries(TaskScheduler& scheduler);
+
+	ID3D12Device* mDevice = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12Device1> mDevice1;
+	Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> mLibrary;
+
+	// The library reads from this blob for as long as it lives
+	std::vector<uint8_t> mLibraryData;
+	std::filesystem::path mLibraryPath;
+	bool mLibraryDirty = false;
+
+	// Taken by the workers of createPending() around StorePipeline() and the statistics they update
+	std::mutex mLibraryMutex;
+
+	std::unordered_map<uint64_t, Entry> mEntries;
+	std::unordered_map<std::string, uint64_t> mNames;
+	std::vector<uint64_t> mPending;
+
+	// What each name requested since the last createPending() referred to before, nothing for new names
+	std::unordered_map<std::string, std::optional<uint64_t>> mPreviousNames;
+
+	PipelineStateCacheStatistics mStatistics;
+};
@@ -0,0 +1,660 @@
+#include "pch.h"
+#include "RenderGraph.h"
+#include "DXException.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <queue>
+
+namespace
+{
+	constexpr D3D12_RESOURCE_STATES WriteStates = D3D12_RESOURCE_STATE_RENDER_TARGET | D3D12_RESOURCE_STATE_UNORDERED_ACCESS | D3D12_RESOURCE_STATE_DEPTH_WRITE |
+												  D3D12_RESOURCE_STATE_STREAM_OUT | D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_RESOLVE_DEST;
+
+	// A resource in a combined read state can be read in any of those states without a barrier
+	bool satisfies(D3D12_RESOURCE_STATES current, D3D12_RESOURCE_STATES required)
+	{
+		if (current == required)
+		{
+			return true;
+		}
+
+		return required != D3D12_RESOURCE_STATE_COMMON && (current & WriteStates) == 0 && (current & required) == required;
+	}
+
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool sameDesc(const D3D12_RESOURCE_DESC& a, const D3D12_RESOURCE_DESC& b)
+	{
+		return a.Dimension == b.Dimension && a.Alignment == b.Alignment && a.Width == b.Width && a.Height == b.Height &&
+			   a.DepthOrArraySize == b.DepthOrArraySize && a.MipLevels == b.MipLevels && a.Format == b.Format &&
+			   a.SampleDesc.Count == b.SampleDesc.Count && a.SampleDesc.Quality == b.SampleDesc.Quality && a.Layout == b.Layout && a.Flags == b.Flags;
+	}
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::read(RenderGraphResource resource, D3D12_RESOURCE_STATES state)
+{
+	mGraph->addAccess(mPass, resource, state, false);
+	return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::write(RenderGraphResource resource, D3D12_RESOURCE_STATES state)
+{
+	mGraph->addAccess(mPass, resource, state, true);
+	return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::sideEffects()
+{
+	mGraph->mPasses[mPass].sideEffects = true;
+	return *this;
+}
+
+RenderGraph::RenderGraph(D3D12_HEAP_FLAGS heapFlags)
+: mHeapFlags(heapFlags)
+{
+}
+
+void RenderGraph::reset()
+{
+	mPasses.clear();
+	mResources.clear();
+	mOrder.clear();
+	mCompiledPasses.clear();
+	mFinalBarriers.clear();
+	mTransientHeapSize = 0;
+}
+
+RenderGraphResource RenderGraph::importResource(const std::string& name, ID3D12Resource* resource, D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_STATES finalState)
+{
+	Resource newResource;
+	newResource.name = name;
+	newResource.resource = resource;
+	newResource.imported = true;
+	newResource.initialState = initialState;
+	newResource.finalState = finalState;
+
+	mResources.push_back(newResource);
+
+	return static_cast<RenderGraphResource>(mResources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::importResource(const std::string& name, ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	return importResource(name, resource, state, state);
+}
+
+RenderGraphResource RenderGraph::createTransient(const std::string& name, const D3D12_RESOURCE_DESC& desc, const D3D12_RESOURCE_ALLOCATION_INFO& allocation, const D3D12_CLEAR_VALUE* clearValue)
+{
+	Resource newResource;
+	newResource.name = name;
+	newResource.desc = desc;
+	newResource.allocation = allocation;
+
+	if (clearValue != nullptr)
+	{
+		newResource.hasClearValue = true;
+		newResource.clearValue = *clearValue;
+	}
+
+	mResources.push_back(newResource);
+
+	return static_cast<RenderGraphResource>(mResources.size() - 1);
+}
+
+RenderGraphPassBuilder RenderGraph::addPass(const std::string& name, Execute execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = std::move(execute);
+
+	mPasses.push_back(std::move(pass));
+
+	return RenderGraphPassBuilder(this, static_cast<uint32_t>(mPasses.size() - 1));
+}
+
+void RenderGraph::addAccess(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state, bool write)
+{
+	assert(resource < mResources.size());
+
+#ifndef NDEBUG
+	// Reading and writing one resource in a pass would need a read and a write state at once
+	for (const auto& other : mPasses[pass].accesses)
+	{
+		assert(other.resource != resource || (!other.write && !write) || (other.write && write && other.state == state));
+	}
+#endif
+
+	Access access;
+	access.resource = resource;
+	access.state = state;
+	access.write = write;
+
+	mPasses[pass].accesses.push_back(access);
+}
+
+void RenderGraph::compile()
+{
+	mCompiledPasses.clear();
+	mFinalBarriers.clear();
+	mTransientHeapSize = 0;
+
+	sortPasses();
+	cullPasses();
+	computeLifetimes();
+	placeTransients();
+	computeBarriers();
+}
+
+void RenderGraph::sortPasses()
+{
+	auto passCount = static_cast<uint32_t>(mPasses.size());
+
+	std::vector<std::vector<uint32_t>> successors(passCount);
+	std::vector<uint32_t> predecessorCounts(passCount, 0);
+
+	auto addEdge = [&](uint32_t before, uint32_t after)
+	{
+		if (before != after)
+		{
+			successors[before].push_back(after);
+			predecessorCounts[after]++;
+		}
+	};
+
+	// Per resource, in the order the passes were added: the last writer and the readers since
+	std::vector<uint32_t> lastWriter(mResources.size(), UINT32_MAX);
+	std::vector<std::vector<uint32_t>> readersSinceWrite(mResources.size());
+	std::vector<std::vector<uint32_t>> unwrittenTransientReaders(mResources.size());
+
+	for (uint32_t pass = 0; pass < passCount; pass++)
+	{
+		for (const auto& access : mPasses[pass].accesses)
+		{
+			auto resource = access.resource;
+
+			if (access.write)
+			{
+				if (lastWriter[resource] != UINT32_MAX)
+				{
+					addEdge(lastWriter[resource], pass);
+				}
+
+				for (auto reader : readersSinceWrite[resource])
+				{
+					addEdge(reader, pass);
+				}
+
+				readersSinceWrite[resource].clear();
+				lastWriter[resource] = pass;
+			}
+			else
+			{
+				if (lastWriter[resource] != UINT32_MAX)
+				{
+					addEdge(lastWriter[resource], pass);
+					readersSinceWrite[resource].push_back(pass);
+				}
+				else if (mResources[resource].imported)
+				{
+					// Reads the content from before the graph, ahead of every write
+					readersSinceWrite[resource].push_back(pass);
+				}
+				else
+				{
+					unwrittenTransientReaders[resource].push_back(pass);
+				}
+			}
+		}
+	}
+
+	for (RenderGraphResource resource = 0; resource < mResources.size(); resource++)
+	{
+		if (lastWriter[resource] != UINT32_MAX)
+		{
+			for (auto reader : unwrittenTransientReaders[resource])
+			{
+				addEdge(lastWriter[resource], reader);
+			}
+		}
+	}
+
+	// Kahn's algorithm, the earliest added pass first among the ready ones
+	std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+
+	for (uint32_t pass = 0; pass < passCount; pass++)
+	{
+		if (predecessorCounts[pass] == 0)
+		{
+			ready.push(pass);
+		}
+	}
+
+	mOrder.clear();
+
+	while (!ready.empty())
+	{
+		auto pass = ready.top();
+		ready.pop();
+
+		mOrder.push_back(pass);
+
+		for (auto successor : successors[pass])
+		{
+			if (--predecessorCounts[successor] == 0)
+			{
+				ready.push(successor);
+			}
+		}
+	}
+
+	// A cycle: some pass both needs and feeds another one
+	assert(mOrder.size() == passCount);
+}
+
+void RenderGraph::cullPasses()
+{
+	// Walking backwards, a pass is needed when it writes something a needed pass reads later
+	std::vector<bool> read(mResources.size(), false);
+
+	for (auto index = mOrder.rbegin(); index != mOrder.rend(); ++index)
+	{
+		auto pass = &mPasses[*index];
+		auto needed = pass->sideEffects;
+
+		for (const auto& access : pass->accesses)
+		{
+			if (access.write && (mResources[access.resource].imported || read[access.resource]))
+			{
+				needed = true;
+			}
+		}
+
+		pass->culled = !needed;
+
+		if (needed)
+		{
+			for (const auto& access : pass->accesses)
+			{
+				if (!access.write)
+				{
+					read[access.resource] = true;
+				}
+			}
+		}
+	}
+}
+
+void RenderGraph::computeLifetimes()
+{
+	for (auto& resource : mResources)
+	{
+		resource.firstUse = UINT32_MAX;
+		resource.lastUse = UINT32_MAX;
+	}
+
+	for (auto pass : mOrder)
+	{
+		if (mPasses[pass].culled)
+		{
+			continue;
+		}
+
+		auto compiledPass = static_cast<uint32_t>(mCompiledPasses.size());
+
+		for (const auto& access : mPasses[pass].accesses)
+		{
+			auto& resource = mResources[access.resource];
+
+			if (resource.firstUse == UINT32_MAX)
+			{
+				// Nothing defines the content of a transient before its first write
+				assert(resource.imported || access.write);
+
+				resource.firstUse = compiledPass;
+			}
+
+			resource.lastUse = compiledPass;
+		}
+
+		RenderGraphCompiledPass newPass;
+		newPass.pass = pass;
+		mCompiledPasses.push_back(newPass);
+	}
+}
+
+void RenderGraph::placeTransients()
+{
+	std::vector<RenderGraphResource> transients;
+
+	for (RenderGraphResource resource = 0; resource < mResources.size(); resource++)
+	{
+		if (!mResources[resource].imported && mResources[resource].firstUse != UINT32_MAX)
+		{
+			transients.push_back(resource);
+		}
+	}
+
+	// Largest first, each one goes to the lowest offset not used by a resource alive at the same time
+	std::stable_sort(transients.begin(), transients.end(), [this](RenderGraphResource a, RenderGraphResource b)
+	{
+		return mResources[a].allocation.SizeInBytes > mResources[b].allocation.SizeInBytes;
+	});
+
+	std::vector<RenderGraphResource> placed;
+	std::vector<std::pair<uint64_t, uint64_t>> taken;
+
+	for (auto transient : transients)
+	{
+		auto& resource = mResources[transient];
+
+		taken.clear();
+
+		for (auto other : placed)
+		{
+			const auto& otherResource = mResources[other];
+
+			if (resource.firstUse <= otherResource.lastUse && otherResource.firstUse <= resource.lastUse)
+			{
+				taken.emplace_back(otherResource.heapOffset, otherResource.heapOffset + otherResource.allocation.SizeInBytes);
+			}
+		}
+
+		std::sort(taken.begin(), taken.end());
+
+		auto size = resource.allocation.SizeInBytes;
+		auto alignment = std::max<uint64_t>(resource.allocation.Alignment, 1);
+		uint64_t offset = 0;
+
+		for (const auto& range : taken)
+		{
+			if (offset + size <= range.first)
+			{
+				break;
+			}
+
+			offset = std::max(offset, alignUp(range.second, alignment));
+		}
+
+		resource.heapOffset = offset;
+		mTransientHeapSize = std::max(mTransientHeapSize, offset + size);
+
+		placed.push_back(transient);
+	}
+}
+
+void RenderGraph::computeBarriers()
+{
+	std::vector<D3D12_RESOURCE_STATES> states(mResources.size());
+
+	for (RenderGraphResource resource = 0; resource < mResources.size(); resource++)
+	{
+		states[resource] = mResources[resource].initialState;
+	}
+
+	// Transients are created in the state of their first use and go back to it after their last use,
+	// so every frame finds them in the same state
+	for (auto& compiledPass : mCompiledPasses)
+	{
+		auto compiledIndex = static_cast<uint32_t>(&compiledPass - mCompiledPasses.data());
+
+		for (const auto& access : mPasses[compiledPass.pass].accesses)
+		{
+			auto& resource = mResources[access.resource];
+
+			if (!resource.imported && resource.firstUse == compiledIndex)
+			{
+				resource.initialState = resource.initialState == D3D12_RESOURCE_STATE_COMMON ? access.state : resource.initialState | access.state;
+				resource.finalState = resource.initialState;
+				states[access.resource] = resource.initialState;
+			}
+		}
+	}
+
+	std::vector<RenderGraphBarrier> restores;
+	std::vector<RenderGraphResource> order;
+	std::vector<D3D12_RESOURCE_STATES> required(mResources.size(), D3D12_RESOURCE_STATE_COMMON);
+
+	for (uint32_t compiledIndex = 0; compiledIndex < mCompiledPasses.size(); compiledIndex++)
+	{
+		auto& compiledPass = mCompiledPasses[compiledIndex];
+		auto& barriers = compiledPass.barriers;
+
+		barriers = std::move(restores);
+		restores.clear();
+
+		// Transients starting here take over memory another transient may have used
+		for (RenderGraphResource resource = 0; resource < mResources.size(); resource++)
+		{
+			const auto& transient = mResources[resource];
+
+			if (transient.imported || transient.firstUse != compiledIndex)
+			{
+				continue;
+			}
+
+			auto aliased = false;
+			auto aliasedBefore = InvalidRenderGraphResource;
+
+			for (RenderGraphResource other = 0; other < mResources.size(); other++)
+			{
+				const auto& otherResource = mResources[other];
+
+				if (other == resource || otherResource.imported || otherResource.firstUse == UINT32_MAX || !overlaps(transient, otherResource))
+				{
+					continue;
+				}
+
+				aliased = true;
+
+				// The most recent earlier user of the memory, otherwise it was last used in the previous frame
+				if (otherResource.lastUse < compiledIndex &&
+					(aliasedBefore == InvalidRenderGraphResource || mResources[aliasedBefore].lastUse < otherResource.lastUse))
+				{
+					aliasedBefore = other;
+				}
+			}
+
+			if (aliased)
+			{
+				RenderGraphBarrier barrier;
+				barrier.type = RenderGraphBarrier::Type::Aliasing;
+				barrier.resource = resource;
+				barrier.aliasedBefore = aliasedBefore;
+				barriers.push_back(barrier);
+			}
+		}
+
+		// A resource used several times by the pass needs all those states at once
+		order.clear();
+
+		for (const auto& access : mPasses[compiledPass.pass].accesses)
+		{
+			if (required[access.resource] == D3D12_RESOURCE_STATE_COMMON)
+			{
+				order.push_back(access.resource);
+			}
+
+			required[access.resource] |= access.state;
+		}
+
+		for (auto resource : order)
+		{
+			if (!satisfies(states[resource], required[resource]))
+			{
+				RenderGraphBarrier barrier;
+				barrier.resource = resource;
+				barrier.stateBefore = states[resource];
+				barrier.stateAfter = required[resource];
+				barriers.push_back(barrier);
+
+				states[resource] = required[resource];
+			}
+
+			required[resource] = D3D12_RESOURCE_STATE_COMMON;
+
+			const auto& transient = mResources[resource];
+
+			if (!transient.imported && transient.lastUse == compiledIndex && states[resource] != transient.finalState)
+			{
+				RenderGraphBarrier barrier;
+				barrier.resource = resource;
+				barrier.stateBefore = states[resource];
+				barrier.stateAfter = transient.finalState;
+				restores.push_back(barrier);
+
+				states[resource] = transient.finalState;
+			}
+		}
+	}
+
+	mFinalBarriers = std::move(restores);
+
+	for (RenderGraphResource resource = 0; resource < mResources.size(); resource++)
+	{
+		if (mResources[resource].imported && states[resource] != mResources[resource].finalState)
+		{
+			RenderGraphBarrier barrier;
+			barrier.resource = resource;
+			barrier.stateBefore = states[resource];
+			barrier.stateAfter = mResources[resource].finalState;
+			mFinalBarriers.push_back(barrier);
+		}
+	}
+}
+
+bool RenderGraph::overlaps(const Resource& a, const Resource& b) const
+{
+	return a.heapOffset < b.heapOffset + b.allocation.SizeInBytes && b.heapOffset < a.heapOffset + a.allocation.SizeInBytes;
+}
+
+void RenderGraph::realizeTransientResources(ID3D12Device* device, DeferredReleaseQueue& releases, uint64_t fenceValue)
+{
+	std::vector<RenderGraphResource> transients;
+	uint64_t alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+	for (RenderGraphResource resource = 0; resource < mResources.size(); resource++)
+	{
+		if (!mResources[resource].imported && mResources[resource].firstUse != UINT32_MAX)
+		{
+			transients.push_back(resource);
+			alignment = std::max(alignment, mResources[resource].allocation.Alignment);
+		}
+	}
+
+	auto unchanged = mTransientHeap != nullptr && mTransientHeap->GetDesc().SizeInBytes >= mTransientHeapSize && mRealizedTransients.size() == transients.size();
+
+	for (size_t i = 0; unchanged && i < transients.size(); i++)
+	{
+		const auto& resource = mResources[transients[i]];
+		const auto& realized = mRealizedTransients[i];
+
+		unchanged = sameDesc(resource.desc, realized.desc) && resource.heapOffset == realized.heapOffset && resource.initialState == realized.initialState;
+	}
+
+	if (!unchanged)
+	{
+		for (auto& realized : mRealizedTransients)
+		{
+			releases.retire(std::move(realized.resource), fenceValue);
+		}
+
+		mRealizedTransients.clear();
+
+		if (mTransientHeapSize > 0 && (mTransientHeap == nullptr || mTransientHeap->GetDesc().SizeInBytes < mTransientHeapSize))
+		{
+			if (mTransientHeap != nullptr)
+			{
+				releases.retire(std::move(mTransientHeap), fenceValue);
+			}
+
+			D3D12_HEAP_DESC heapDesc{};
+			heapDesc.SizeInBytes = alignUp(mTransientHeapSize, alignment);
+			heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+			heapDesc.Alignment = alignment;
+			heapDesc.Flags = mHeapFlags;
+
+			DXCheck(device->CreateHeap(&heapDesc, IID_PPV_ARGS(&mTransientHeap)), L"ID3D12Device::CreateHeap failed!");
+			setD3D12DebugName(mTransientHeap.Get(), L"RenderGraphTransientHeap");
+		}
+
+		for (auto transient : transients)
+		{
+			const auto& resource = mResources[transient];
+
+			RealizedTransient realized;
+			realized.desc = resource.desc;
+			realized.heapOffset = resource.heapOffset;
+			realized.initialState = resource.initialState;
+
+			DXCheck(device->CreatePlacedResource(mTransientHeap.Get(), resource.heapOffset, &resource.desc, resource.initialState,
+												 resource.hasClearValue ? &resource.clearValue : nullptr, IID_PPV_ARGS(&realized.resource)),
+					L"ID3D12Device::CreatePlacedResource failed!");
+
+			std::wstring name(resource.name.begin(), resource.name.end());
+			setD3D12DebugName(realized.resource.Get(), name);
+
+			mRealizedTransients.push_back(std::move(realized));
+		}
+	}
+
+	for (size_t i = 0; i < transients.size(); i++)
+	{
+		mResources[transients[i]].resource = mRealizedTransients[i].resource.Get();
+	}
+}
+
+ID3D12Resource* RenderGraph::resource(RenderGraphResource resource) const
+{
+	return mResources[resource].resource;
+}
+
+void RenderGraph::execute(const CommandListProvider& commandList)
+{
+	for (const auto& compiledPass : mCompiledPasses)
+	{
+		auto passCommandList = commandList();
+
+		recordBarriers(passCommandList, compiledPass.barriers, mResources);
+		mPasses[compiledPass.pass].execute(passCommandList);
+	}
+
+	recordBarriers(commandList(), mFinalBarriers, mResources);
+}
+
+void RenderGraph::recordBarriers(ID3D12GraphicsCommandList* commandList, const std::vector<RenderGraphBarrier>& barriers, const std::vector<Resource>& resources)
+{
+	if (barriers.empty())
+	{
+		return;
+	}
+
+	std::vector<D3D12_RESOURCE_BARRIER> resourceBarriers(barriers.size());
+
+	for (size_t i = 0; i < barriers.size(); i++)
+	{
+		const auto& barrier = barriers[i];
+		auto& resourceBarrier = resourceBarriers[i];
+
+		if (barrier.type == RenderGraphBarrier::Type::Aliasing)
+		{
+			resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+			resourceBarrier.Aliasing.pResourceBefore = barrier.aliasedBefore != InvalidRenderGraphResource ? resources[barrier.aliasedBefore].resource : nullptr;
+			resourceBarrier.Aliasing.pResourceAfter = resources[barrier.resource].resource;
+		}
+		else
+		{
+			resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+			resourceBarrier.Transition.pResource = resources[barrier.resource].resource;
+			resourceBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+			resourceBarrier.Transition.StateBefore = barrier.stateBefore;
+			resourceBarrier.Transition.StateAfter = barrier.stateAfter;
+		}
+	}
+
+	commandList->ResourceBarrier(static_cast<uint32_t>(resourceBarriers.size()), resourceBarriers.data());
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "DeferredReleaseQueue.h"
+
+using RenderGraphResource = uint32_t;
+
+constexpr RenderGraphResource InvalidRenderGraphResource = UINT32_MAX;
+
+// A barrier computed by RenderGraph::compile(), in terms of graph resources so it can be
+// inspected without a device.
+struct RenderGraphBarrier
+{
+	enum class Type
+	{
+		Transition,
+		Aliasing
+	};
+
+	Type type = Type::Transition;
+	RenderGraphResource resource = InvalidRenderGraphResource;
+
+	// Transition
+	D3D12_RESOURCE_STATES stateBefore = D3D12_RESOURCE_STATE_COMMON;
+	D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_COMMON;
+
+	// Aliasing: the resource that used the memory last, InvalidRenderGraphResource if unknown
+	RenderGraphResource aliasedBefore = InvalidRenderGraphResource;
+};
+
+struct RenderGraphCompiledPass
+{
+	uint32_t pass = 0;
+
+	// Recorded with a single ResourceBarrier call right before the pass
+	std::vector<RenderGraphBarrier> barriers;
+};
+
+class RenderGraph;
+
+class RenderGraphPassBuilder
+{
+public:
+	RenderGraphPassBuilder(RenderGraph* graph, uint32_t pass) : mGraph(graph), mPass(pass) {}
+
+	RenderGraphPassBuilder& read(RenderGraphResource resource, D3D12_RESOURCE_STATES state);
+	RenderGraphPassBuilder& write(RenderGraphResource resource, D3D12_RESOURCE_STATES state);
+
+	// The pass is kept even if nothing reads what it writes.
+	RenderGraphPassBuilder& sideEffects();
+
+	uint32_t pass() const { return mPass; }
+
+private:
+	RenderGraph* mGraph = nullptr;
+	uint32_t mPass = 0;
+};
+
+// Frame graph rebuilt every frame: passes declare the resources they read and write and the state
+// they need them in, compile() then
+//   - orders the passes by their read/write dependencies,
+//   - culls passes whose results nobody uses (writing an imported resource or sideEffects() keeps a pass),
+//   - computes the transitions between the declared states, batched into one call per pass,
+//   - places transient resources whose lifetimes do not overlap at the same offset of one heap.
+// The writers of a resource run in the order they were added. A read sees the last write added
+// before it and runs before the next one; a transient read added before any write of it sees the
+// last write. Otherwise the order the passes were added in is kept, so a graph built in a valid
+// order runs unchanged. A pass may read a resource in several states or write it in one state,
+// not both read and write it.
+// compile() only needs the descriptions, so it runs without a device. realizeTransientResources()
+// and execute() then do the D3D12 work.
+class RenderGraph
+{
+public:
+	using Execute = std::function<void(ID3D12GraphicsCommandList* commandList)>;
+	using CommandListProvider = std::function<ID3D12GraphicsCommandList*()>;
+
+	// Transient resources are placed in a heap created with heapFlags. Mixing buffers, textures and
+	// render targets in one heap needs resource heap tier 2, so the default only takes render targets.
+	explicit RenderGraph(D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+
+	// Drops passes and resources but keeps the transient heap and resources for the next frame.
+	void reset();
+
+	// A resource that lives outside the graph. It is in initialState when the graph starts and is
+	// transitioned to finalState after the last pass.
+	RenderGraphResource importResource(const std::string& name, ID3D12Resource* resource, D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_STATES finalState);
+	RenderGraphResource importResource(const std::string& name, ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+	// A resource that only lives during the frame. allocation is what
+	// ID3D12Device::GetResourceAllocationInfo returns for desc. The content is undefined at the first
+	// write, render targets and depth buffers have to be cleared or discarded there.
+	RenderGraphResource createTransient(const std::string& name, const D3D12_RESOURCE_DESC& desc, const D3D12_RESOURCE_ALLOCATION_INFO& allocation,
+										const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+	RenderGraphPassBuilder addPass(const std::string& name, Execute execute);
+
+	void compile();
+
+	// Valid after compile(), compiled passes are in execution order
+	const std::vector<RenderGraphCompiledPass>& compiledPasses() const { return mCompiledPasses; }
+	const std::vector<RenderGraphBarrier>& finalBarriers() const { return mFinalBarriers; }
+	bool isCulled(uint32_t pass) const { return mPasses[pass].culled; }
+	uint64_t transientHeapSize() const { return mTransientHeapSize; }
+	uint64_t transientHeapOffset(RenderGraphResource resource) const { return mResources[resource].heapOffset; }
+
+	const std::string& passName(uint32_t pass) const { return mPasses[pass].name; }
+	const std::string& resourceName(RenderGraphResource resource) const { return mResources[resource].name; }
+
+	// Creates the transient heap and placed resources when the compiled layout differs from the last
+	// realized one. The previous ones may still be in use by submitted frames, they are retired to
+	// releases with fenceValue, which has to be signaled after the last frame that used them.
+	void realizeTransientResources(ID3D12Device* device, DeferredReleaseQueue& releases, uint64_t fenceValue);
+
+	ID3D12Resource* resource(RenderGraphResource resource) const;
+
+	// Records every compiled pass. commandList is asked again before each pass, a pass may submit
+	// its list and start a new one.
+	void execute(const CommandListProvider& commandList);
+
+private:
+	friend class RenderGraphPassBuilder;
+
+	struct Access
+	{
+		RenderGraphResource resource = InvalidRenderGraphResource;
+		D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
+		bool write = false;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		Execute execute;
+		std::vector<Access> accesses;
+		bool sideEffects = false;
+		bool culled = false;
+	};
+
+	struct Resource
+	{
+		std::string name;
+		ID3D12Resource* resource = nullptr;
+		bool imported = false;
+
+		D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON;
+		D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_COMMON;
+
+		// Transient only
+		D3D12_RESOURCE_DESC desc{};
+		D3D12_RESOURCE_ALLOCATION_INFO allocation{};
+		bool hasClearValue = false;
+		D3D12_CLEAR_VALUE clearValue{};
+		uint64_t heapOffset = 0;
+
+		// Compiled pass indices of the first and last use, UINT32_MAX when unused
+		uint32_t firstUse = UINT32_MAX;
+		uint32_t lastUse = UINT32_MAX;
+	};
+
+	// A placed resource kept across frames, matched again by description, offset and initial state.
+	struct RealizedTransient
+	{
+		D3D12_RESOURCE_DESC desc{};
+		uint64_t heapOffset = 0;
+		D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON;
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+	};
+
+	void addAccess(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state, bool write);
+
+	void sortPasses();
+	void cullPasses();
+	void computeLifetimes();
+	void placeTransients();
+	void computeBarriers();
+
+	bool overlaps(const Resource& a, const Resource& b) const;
+	static void recordBarriers(ID3D12GraphicsCommandList* commandList, const std::vector<RenderGraphBarrier>& barriers, const std::vector<Resource>& resources);
+
+	D3D12_HEAP_FLAGS mHeapFlags;
+
+	std::vector<Pass> mPasses;
+	std::vector<Resource> mResources;
+
+	// Pass indices in execution order, culled ones included
+	std::vector<uint32_t> mOrder;
+
+	std::vector<RenderGraphCompiledPass> mCompiledPasses;
+	std::vector<RenderGraphBarrier> mFinalBarriers;
+	uint64_t mTransientHeapSize = 0;
+
+	Microsoft::WRL::ComPtr<ID3D12Heap> mTransientHeap;
+	std::vector<RealizedTransient> mRealizedTransients;
+};
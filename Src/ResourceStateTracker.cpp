@@ -0,0 +1,312 @@
+#include "pch.h"
+#include "ResourceStateTracker.h"
+
+#include <cassert>
+
+namespace
+{
+	constexpr D3D12_RESOURCE_STATES WriteStates = D3D12_RESOURCE_STATE_RENDER_TARGET | D3D12_RESOURCE_STATE_UNORDERED_ACCESS | D3D12_RESOURCE_STATE_DEPTH_WRITE |
+												  D3D12_RESOURCE_STATE_STREAM_OUT | D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_RESOLVE_DEST;
+
+	bool satisfies(D3D12_RESOURCE_STATES current, D3D12_RESOURCE_STATES required)
+	{
+		if (current == required)
+		{
+			return true;
+		}
+
+		return required != D3D12_RESOURCE_STATE_COMMON && (current & WriteStates) == 0 && (current & required) == required;
+	}
+
+	D3D12_RESOURCE_BARRIER makeTransition(ID3D12Resource* resource, uint32_t subresource, D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter, D3D12_RESOURCE_BARRIER_FLAGS flags)
+	{
+		D3D12_RESOURCE_BARRIER barrier{};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Flags = flags;
+		barrier.Transition.pResource = resource;
+		barrier.Transition.Subresource = subresource;
+		barrier.Transition.StateBefore = stateBefore;
+		barrier.Transition.StateAfter = stateAfter;
+
+		return barrier;
+	}
+}
+
+uint32_t ResourceStateTracker::subresourceCount(const D3D12_RESOURCE_DESC& desc)
+{
+	switch (desc.Dimension)
+	{
+	case D3D12_RESOURCE_DIMENSION_BUFFER:
+		return 1;
+	case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+		return desc.MipLevels;
+	default:
+		return static_cast<uint32_t>(desc.MipLevels) * desc.DepthOrArraySize;
+	}
+}
+
+void ResourceStateTracker::track(ID3D12Resource* resource, uint32_t subresourceCount, D3D12_RESOURCE_STATES state)
+{
+	// A new resource can get the address of one released without untrack()
+	untrack(resource);
+
+	TrackedResource tracked;
+	tracked.subresourceCount = subresourceCount;
+	tracked.state = state;
+
+	mResources[resource] = std::move(tracked);
+}
+
+void ResourceStateTracker::untrack(ID3D12Resource* resource)
+{
+	mResources.erase(resource);
+
+	// Barriers still queued would reach the command list after the resource is gone
+	for (size_t index = mPendingBarriers.size(); index > 0; index--)
+	{
+		if (mPendingBarriers[index - 1].Transition.pResource == resource)
+		{
+			erasePendingBarrier(index - 1);
+		}
+	}
+
+	for (auto split = mSplitTransitions.begin(); split != mSplitTransitions.end();)
+	{
+		split = split->resource == resource ? mSplitTransitions.erase(split) : split + 1;
+	}
+}
+
+D3D12_RESOURCE_STATES ResourceStateTracker::state(ID3D12Resource* resource, uint32_t subresource) const
+{
+	auto tracked = mResources.find(resource);
+	assert(tracked != mResources.end());
+
+	if (tracked->second.subresourceStates.empty())
+	{
+		return tracked->second.state;
+	}
+
+	return tracked->second.subresourceStates[subresource];
+}
+
+void ResourceStateTracker::transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter, uint32_t subresource)
+{
+	mStatistics.requested++;
+
+	auto& tracked = find(resource);
+
+	endSplitTransitions(resource, subresource);
+
+	auto queuedBefore = mPendingBarriers.size();
+	auto mergedBefore = mStatistics.merged;
+
+	if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && tracked.subresourceStates.empty())
+	{
+		transitionSubresource(tracked, resource, subresource, stateAfter);
+	}
+	else if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+	{
+		for (uint32_t i = 0; i < tracked.subresourceCount; i++)
+		{
+			transitionSubresource(tracked, resource, i, stateAfter);
+		}
+
+		collapse(tracked);
+	}
+	else if (!satisfies(tracked.subresourceStates.empty() ? tracked.state : tracked.subresourceStates[subresource], stateAfter))
+	{
+		if (tracked.subresourceStates.empty())
+		{
+			tracked.subresourceStates.assign(tracked.subresourceCount, tracked.state);
+		}
+
+		transitionSubresource(tracked, resource, subresource, stateAfter);
+		collapse(tracked);
+	}
+
+	if (mPendingBarriers.size() == queuedBefore && mStatistics.merged == mergedBefore)
+	{
+		mStatistics.elided++;
+	}
+}
+
+void ResourceStateTracker::beginTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter, uint32_t subresource)
+{
+	auto& tracked = find(resource);
+
+	endSplitTransitions(resource, subresource);
+
+	// Subresources in different states need a barrier each, those are not split
+	if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && !tracked.subresourceStates.empty())
+	{
+		transition(resource, stateAfter, subresource);
+		return;
+	}
+
+	mStatistics.requested++;
+
+	auto stateBefore = tracked.subresourceStates.empty() ? tracked.state : tracked.subresourceStates[subresource];
+
+	if (satisfies(stateBefore, stateAfter))
+	{
+		mStatistics.elided++;
+		return;
+	}
+
+	mPendingBarriers.push_back(makeTransition(resource, subresource, stateBefore, stateAfter, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+
+	SplitTransition split;
+	split.resource = resource;
+	split.subresource = subresource;
+	split.stateBefore = stateBefore;
+	split.stateAfter = stateAfter;
+	split.pendingIndex = mPendingBarriers.size() - 1;
+
+	mSplitTransitions.push_back(split);
+}
+
+void ResourceStateTracker::flushed()
+{
+	for (auto& split : mSplitTransitions)
+	{
+		split.pendingIndex = SIZE_MAX;
+	}
+
+	if (mPendingBarriers.empty())
+	{
+		return;
+	}
+
+	mStatistics.issued += static_cast<uint32_t>(mPendingBarriers.size());
+	mStatistics.batches++;
+
+	mPendingBarriers.clear();
+}
+
+ResourceStateTracker::TrackedResource& ResourceStateTracker::find(ID3D12Resource* resource)
+{
+	auto tracked = mResources.find(resource);
+	assert(tracked != mResources.end());
+
+	return tracked->second;
+}
+
+void ResourceStateTracker::endSplitTransitions(ID3D12Resource* resource, uint32_t subresource)
+{
+	for (auto split = mSplitTransitions.begin(); split != mSplitTransitions.end();)
+	{
+		if (split->resource != resource || (subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES &&
+			split->subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && split->subresource != subresource))
+		{
+			++split;
+			continue;
+		}
+
+		if (split->pendingIndex != SIZE_MAX)
+		{
+			// Begin and end would land in the same batch, one ordinary barrier does the same
+			mPendingBarriers[split->pendingIndex].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		}
+		else
+		{
+			mPendingBarriers.push_back(makeTransition(resource, split->subresource, split->stateBefore, split->stateAfter, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+		}
+
+		auto& tracked = find(resource);
+
+		if (split->subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+		{
+			tracked.state = split->stateAfter;
+			tracked.subresourceStates.clear();
+		}
+		else
+		{
+			if (tracked.subresourceStates.empty())
+			{
+				tracked.subresourceStates.assign(tracked.subresourceCount, tracked.state);
+			}
+
+			tracked.subresourceStates[split->subresource] = split->stateAfter;
+			collapse(tracked);
+		}
+
+		split = mSplitTransitions.erase(split);
+	}
+}
+
+void ResourceStateTracker::transitionSubresource(TrackedResource& tracked, ID3D12Resource* resource, uint32_t subresource, D3D12_RESOURCE_STATES stateAfter)
+{
+	auto& state = subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ? tracked.state : tracked.subresourceStates[subresource];
+
+	if (satisfies(state, stateAfter))
+	{
+		return;
+	}
+
+	queue(resource, subresource, state, stateAfter);
+	state = stateAfter;
+}
+
+void ResourceStateTracker::queue(ID3D12Resource* resource, uint32_t subresource, D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter)
+{
+	// The last queued barrier of the resource may already go to the same subresource, then that one
+	// goes straight to the new state, or disappears if the new state is where it started
+	for (auto barrier = mPendingBarriers.rbegin(); barrier != mPendingBarriers.rend(); ++barrier)
+	{
+		if (barrier->Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION || barrier->Transition.pResource != resource)
+		{
+			continue;
+		}
+
+		if (barrier->Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE && barrier->Transition.Subresource == subresource)
+		{
+			mStatistics.merged++;
+
+			if (barrier->Transition.StateBefore == stateAfter)
+			{
+				erasePendingBarrier(static_cast<size_t>(mPendingBarriers.rend() - barrier) - 1);
+			}
+			else
+			{
+				barrier->Transition.StateAfter = stateAfter;
+			}
+
+			return;
+		}
+
+		break;
+	}
+
+	mPendingBarriers.push_back(makeTransition(resource, subresource, stateBefore, stateAfter, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+}
+
+void ResourceStateTracker::erasePendingBarrier(size_t index)
+{
+	mPendingBarriers.erase(mPendingBarriers.begin() + index);
+
+	// Split transitions point at their begin barrier by index
+	for (auto& split : mSplitTransitions)
+	{
+		if (split.pendingIndex != SIZE_MAX && split.pendingIndex > index)
+		{
+			split.pendingIndex--;
+		}
+	}
+}
+
+void ResourceStateTracker::collapse(TrackedResource& tracked)
+{
+	for (auto state : tracked.subresourceStates)
+	{
+		if (state != tracked.subresourceStates.front())
+		{
+			return;
+		}
+	}
+
+	if (!tracked.subresourceStates.empty())
+	{
+		tracked.state = tracked.subresourceStates.front();
+		tracked.subresourceStates.clear();
+	}
+}
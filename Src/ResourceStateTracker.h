@@ -0,0 +1,102 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct ResourceStateTrackerStatistics
+{
+	// transition() and beginTransition() calls
+	uint32_t requested = 0;
+
+	// Requests the resource already satisfied, so nothing was queued
+	uint32_t elided = 0;
+
+	// Barriers folded into one still queued for the same subresource, including those that cancelled it
+	uint32_t merged = 0;
+
+	// Barriers recorded by flush(), and the ResourceBarrier calls that recorded them
+	uint32_t issued = 0;
+	uint32_t batches = 0;
+};
+
+// Knows the state of every registered resource (or of each of its subresources) as of the end of
+// the commands recorded so far, so callers only name the state they need next. transition() works
+// out the barrier, drops it when nothing changes and merges it with one still queued for the same
+// subresource; flush() records everything queued with a single ResourceBarrier call. A read state
+// that is part of the current combined read state needs no barrier.
+// The tracker is global, which assumes the command lists run in the order they were recorded, on
+// one queue. Resources whose states are handled elsewhere (the render graph) stay unregistered.
+class ResourceStateTracker
+{
+public:
+	static uint32_t subresourceCount(const D3D12_RESOURCE_DESC& desc);
+
+	void track(ID3D12Resource* resource, uint32_t subresourceCount, D3D12_RESOURCE_STATES state);
+	void untrack(ID3D12Resource* resource);
+	bool isTracked(ID3D12Resource* resource) const { return mResources.count(resource) > 0; }
+
+	// The state after everything queued so far. A split transition only counts once it has ended.
+	D3D12_RESOURCE_STATES state(ID3D12Resource* resource, uint32_t subresource = 0) const;
+
+	void transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter, uint32_t subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+	// Starts a split barrier so the GPU can do the transition while other work runs. The next
+	// transition() of the same subresource ends it; if the begin was not flushed yet it becomes
+	// an ordinary barrier instead.
+	void beginTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter, uint32_t subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+	const std::vector<D3D12_RESOURCE_BARRIER>& pendingBarriers() const { return mPendingBarriers; }
+
+	// Takes anything with ResourceBarrier(count, barriers), the tests record the batches with it
+	template <typename CommandList>
+	void flush(CommandList* commandList)
+	{
+		if (!mPendingBarriers.empty())
+		{
+			commandList->ResourceBarrier(static_cast<uint32_t>(mPendingBarriers.size()), mPendingBarriers.data());
+		}
+
+		flushed();
+	}
+
+	const ResourceStateTrackerStatistics& statistics() const { return mStatistics; }
+
+private:
+	struct TrackedResource
+	{
+		uint32_t subresourceCount = 1;
+
+		// Used while every subresource is in the same state
+		D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
+
+		// One state per subresource, empty while they all share one
+		std::vector<D3D12_RESOURCE_STATES> subresourceStates;
+	};
+
+	struct SplitTransition
+	{
+		ID3D12Resource* resource = nullptr;
+		uint32_t subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+		D3D12_RESOURCE_STATES stateBefore = D3D12_RESOURCE_STATE_COMMON;
+		D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_COMMON;
+
+		// Index of the begin barrier in mPendingBarriers until it is flushed
+		size_t pendingIndex = SIZE_MAX;
+	};
+
+	TrackedResource& find(ID3D12Resource* resource);
+	void endSplitTransitions(ID3D12Resource* resource, uint32_t subresource);
+	void transitionSubresource(TrackedResource& tracked, ID3D12Resource* resource, uint32_t subresource, D3D12_RESOURCE_STATES stateAfter);
+	void queue(ID3D12Resource* resource, uint32_t subresource, D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter);
+	void erasePendingBarrier(size_t index);
+	void flushed();
+	static void collapse(TrackedResource& tracked);
+
+	std::unordered_map<ID3D12Resource*, TrackedResource> mResources;
+	std::vector<SplitTransition> mSplitTransitions;
+	std::vector<D3D12_RESOURCE_BARRIER> mPendingBarriers;
+	ResourceStateTrackerStatistics mStatistics;
+};
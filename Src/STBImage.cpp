@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "STBImage.h"
+
+#include <cstring>
+#include <fstream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_NO_STDIO
+#include "stb_image.h"
+
+uint32_t imageFormatBytesPerPixel(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::R8:
+		return 1;
+	case ImageFormat::RG8:
+		return 2;
+	case ImageFormat::RGBA8:
+	case ImageFormat::BGRA8:
+		return 4;
+	}
+
+	return 0;
+}
+
+ImageFormat imageFormatFromChannels(uint32_t channels)
+{
+	switch (channels)
+	{
+	case 1:
+		return ImageFormat::R8;
+	case 2:
+		return ImageFormat::RG8;
+	default:
+		// There is no 3 byte texel format on the GPU, RGB gets an opaque alpha.
+		return ImageFormat::RGBA8;
+	}
+}
+
+bool STBImage::open(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file)
+	{
+		mError = "Failed to open " + path.string();
+		return false;
+	}
+
+	auto size = static_cast<size_t>(file.tellg());
+	file.seekg(0, std::ios::beg);
+
+	mFileData.resize(size);
+
+	if (!file.read(reinterpret_cast<char*>(mFileData.data()), size))
+	{
+		mError = "Failed to read " + path.string();
+		return false;
+	}
+
+	return open(mFileData.data(), mFileData.size());
+}
+
+bool STBImage::open(const void* encoded, size_t size)
+{
+	mEncoded = reinterpret_cast<const uint8_t*>(encoded);
+	mEncodedSize = size;
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+
+	if (!stbi_info_from_memory(mEncoded, static_cast<int>(mEncodedSize), &width, &height, &channels))
+	{
+		mError = stbi_failure_reason();
+		return false;
+	}
+
+	mWidth = static_cast<uint32_t>(width);
+	mHeight = static_cast<uint32_t>(height);
+	mChannels = static_cast<uint32_t>(channels);
+
+	return true;
+}
+
+bool STBImage::decode(void* dest, size_t destRowPitch, ImageFormat format)
+{
+	auto bytesPerPixel = imageFormatBytesPerPixel(format);
+	auto rowSize = static_cast<size_t>(mWidth) * bytesPerPixel;
+
+	if (mEncoded == nullptr || dest == nullptr || destRowPitch < rowSize)
+	{
+		mError = "Invalid decode destination";
+		return false;
+	}
+
+	// stb_image performs the channel expansion/reduction itself (grey -> RGB, RGB -> luma, alpha fill)
+	// and writes tightly packed rows into its own buffer. The decoders read back what they have written
+	// (PNG unfiltering reads the previous row, JPEG upsamples from its planes), so that buffer is normal
+	// cached memory and the destination, which may be write-combined, is only ever written, once, in order.
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* pixels = stbi_load_from_memory(mEncoded, static_cast<int>(mEncodedSize), &width, &height, &channels, static_cast<int>(bytesPerPixel));
+
+	if (pixels == nullptr)
+	{
+		mError = stbi_failure_reason();
+		return false;
+	}
+
+	auto destData = reinterpret_cast<uint8_t*>(dest);
+
+	// The one copy to the destination, the swizzle happens on the way.
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		const auto* source = pixels + y * rowSize;
+		auto* row = destData + y * destRowPitch;
+
+		if (format == ImageFormat::BGRA8)
+		{
+			for (uint32_t x = 0; x < mWidth; x++)
+			{
+				row[x * 4 + 0] = source[x * 4 + 2];
+				row[x * 4 + 1] = source[x * 4 + 1];
+				row[x * 4 + 2] = source[x * 4 + 0];
+				row[x * 4 + 3] = source[x * 4 + 3];
+			}
+		}
+		else
+		{
+			memcpy(row, source, rowSize);
+		}
+	}
+
+	stbi_image_free(pixels);
+
+	// The encoded bytes are no longer needed once the texels have been written.
+	mFileData.clear();
+	mFileData.shrink_to_fit();
+	mEncoded = nullptr;
+	mEncodedSize = 0;
+
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Pixel layouts the decoder can write. Kept independent of DXGI so the
+// decoder builds and runs without any Windows headers.
+enum class ImageFormat
+{
+	R8,
+	RG8,
+	RGBA8,
+	BGRA8
+};
+
+uint32_t imageFormatBytesPerPixel(ImageFormat format);
+
+// Smallest format that holds every channel of a file: grey stays one channel,
+// grey + alpha two, RGB and RGBA become RGBA8.
+ImageFormat imageFormatFromChannels(uint32_t channels);
+
+// Portable image decoder built on stb_image (PNG, JPG, BMP, TGA, PSD, GIF, HDR, PIC, PNM).
+// open() only parses the header so the caller can size and map its destination first,
+// decode() then converts the texels in a buffer of its own and copies them to that destination
+// at any row pitch. The destination is written once, in order, and never read.
+class STBImage
+{
+public:
+	bool open(const std::filesystem::path& path);
+	bool open(const void* encoded, size_t size);
+
+	// Decodes the image into dest, writing row y at dest + y * destRowPitch.
+	// destRowPitch must be at least width * imageFormatBytesPerPixel(format).
+	bool decode(void* dest, size_t destRowPitch, ImageFormat format);
+
+	uint32_t width() const { return mWidth; }
+	uint32_t height() const { return mHeight; }
+
+	// Channel count stored in the file (1 = grey, 2 = grey + alpha, 3 = RGB, 4 = RGBA).
+	uint32_t channels() const { return mChannels; }
+
+	// The format to decode to when the texels should keep the file's channels.
+	ImageFormat nativeFormat() const { return imageFormatFromChannels(mChannels); }
+
+	const std::string& error() const { return mError; }
+
+private:
+	std::vector<uint8_t> mFileData;
+	const uint8_t* mEncoded = nullptr;
+	size_t mEncodedSize = 0;
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mChannels = 0;
+	std::string mError;
+};
@@ -0,0 +1,451 @@
+#include "pch.h"
+#include "ShaderCache.h"
+#include "AssetCache.h"
+#include "MappedFile.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	struct ShaderBlobHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+
+	constexpr uint32_t ShaderBlobMagic = 0x43495844;	// "DXIC"
+
+	// Bump when the key or the blob layout changes, old blobs then simply miss
+	constexpr uint32_t ShaderCacheVersion = 2;
+
+	class KeyWriter
+	{
+	public:
+		void write(uint64_t value)
+		{
+			auto bytes = reinterpret_cast<const uint8_t*>(&value);
+			mBytes.insert(mBytes.end(), bytes, bytes + sizeof(value));
+		}
+
+		// Characters one by one, so the key does not depend on the size of wchar_t
+		void write(const std::wstring& text)
+		{
+			write(static_cast<uint64_t>(text.size()));
+
+			for (auto character : text)
+			{
+				auto value = static_cast<uint32_t>(character);
+				auto bytes = reinterpret_cast<const uint8_t*>(&value);
+				mBytes.insert(mBytes.end(), bytes, bytes + sizeof(value));
+			}
+		}
+
+		uint64_t hash() const { return hashAssetContent(mBytes.data(), mBytes.size()); }
+
+	private:
+		std::vector<uint8_t> mBytes;
+	};
+
+	bool readFile(const std::filesystem::path& path, std::string& content)
+	{
+		MappedFile file;
+
+		if (!file.open(path))
+		{
+			return false;
+		}
+
+		content.assign(reinterpret_cast<const char*>(file.data()), file.size());
+
+		return true;
+	}
+
+	size_t skipSpaces(const std::string& source, size_t position)
+	{
+		while (position < source.size() && (source[position] == ' ' || source[position] == '\t'))
+		{
+			position++;
+		}
+
+		return position;
+	}
+}
+
+std::vector<std::wstring> shaderCompileArguments(const ShaderCompileParameters& parameters)
+{
+	std::vector<std::wstring> arguments;
+
+	// -E for the entry point(eg. PSMain)
+	arguments.push_back(L"-E");
+	arguments.push_back(parameters.entryPoint);
+
+	// -T for the target profile(eg. ps_6_2)
+	arguments.push_back(L"-T");
+	arguments.push_back(parameters.targetProfile);
+
+	// -I for include directory
+	arguments.push_back(L"-I");
+	arguments.push_back(L"Assets/Shaders");
+
+	// Strip reflection data and pdbs(see later)
+	arguments.push_back(L"-Qstrip_debug");
+	arguments.push_back(L"-Qstrip_reflect");
+
+	arguments.push_back(L"-WX");			// DXC_ARG_WARNINGS_ARE_ERRORS
+
+#if defined(_DEBUG)
+	arguments.push_back(L"-Zi");			// DXC_ARG_DEBUG
+#endif
+	//arguments.push_back(L"-Zpr");			// DXC_ARG_PACK_MATRIX_ROW_MAJOR
+
+	for (const auto& define : parameters.defines)
+	{
+		arguments.push_back(L"-D");
+		arguments.push_back(define);
+	}
+
+	return arguments;
+}
+
+std::vector<std::string> scanShaderIncludes(const std::string& source)
+{
+	std::vector<std::string> includes;
+
+	bool lineStart = true;
+
+	for (size_t position = 0; position < source.size();)
+	{
+		auto character = source[position];
+
+		if (character == '/' && position + 1 < source.size() && source[position + 1] == '/')
+		{
+			position = source.find('\n', position);
+			position = position == std::string::npos ? source.size() : position;
+			continue;
+		}
+
+		if (character == '/' && position + 1 < source.size() && source[position + 1] == '*')
+		{
+			position = source.find("*/", position + 2);
+			position = position == std::string::npos ? source.size() : position + 2;
+			continue;
+		}
+
+		if (character == '\n')
+		{
+			lineStart = true;
+			position++;
+			continue;
+		}
+
+		if (character == ' ' || character == '\t' || character == '\r')
+		{
+			position++;
+			continue;
+		}
+
+		if (character == '#' && lineStart)
+		{
+			auto directive = skipSpaces(source, position + 1);
+
+			if (source.compare(directive, 7, "include") == 0)
+			{
+				auto open = skipSpaces(source, directive + 7);
+
+				if (open < source.size() && (source[open] == '"' || source[open] == '<'))
+				{
+					auto close = source.find(source[open] == '"' ? '"' : '>', open + 1);
+					auto lineEnd = source.find('\n', open);
+
+					if (close != std::string::npos && close < lineEnd)
+					{
+						includes.push_back(source.substr(open + 1, close - open - 1));
+					}
+				}
+			}
+		}
+
+		lineStart = false;
+		position++;
+	}
+
+	return includes;
+}
+
+std::filesystem::path resolveShaderInclude(const std::string& name, const std::filesystem::path& includer,
+										   const std::vector<std::filesystem::path>& includeDirectories)
+{
+	std::error_code error;
+
+	auto local = (includer.parent_path() / name).lexically_normal();
+
+	if (std::filesystem::is_regular_file(local, error))
+	{
+		return local;
+	}
+
+	for (const auto& directory : includeDirectories)
+	{
+		auto candidate = (directory / name).lexically_normal();
+
+		if (std::filesystem::is_regular_file(candidate, error))
+		{
+			return candidate;
+		}
+	}
+
+	return {};
+}
+
+std::vector<std::filesystem::path> collectShaderFiles(const std::filesystem::path& path, const std::vector<std::filesystem::path>& includeDirectories)
+{
+	std::vector<std::filesystem::path> files = { path.lexically_normal() };
+	std::unordered_set<std::string> visited = { normalizeAssetPath(path) };
+
+	// files doubles as the work list, includes are appended behind the file that names them
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		std::string source;
+
+		if (!readFile(files[i], source))
+		{
+			continue;
+		}
+
+		for (const auto& name : scanShaderIncludes(source))
+		{
+			auto include = resolveShaderInclude(name, files[i], includeDirectories);
+
+			if (!include.empty() && visited.insert(normalizeAssetPath(include)).second)
+			{
+				files.push_back(include);
+			}
+		}
+	}
+
+	return files;
+}
+
+ShaderCache::ShaderCache(const std::filesystem::path& directory, std::vector<std::filesystem::path> includeDirectories, const std::wstring& compilerVersion)
+: mDirectory(directory), mIncludeDirectories(std::move(includeDirectories)), mCompilerVersion(compilerVersion)
+{
+}
+
+uint64_t ShaderCache::key(const ShaderCompileParameters& parameters) const
+{
+	KeyWriter writer;
+
+	writer.write(ShaderCacheVersion);
+	writer.write(mCompilerVersion);
+
+	auto files = collectShaderFiles(parameters.path, mIncludeDirectories);
+
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		MappedFile file;
+
+		if (!file.open(files[i]))
+		{
+			if (i == 0)
+			{
+				return 0;
+			}
+
+			continue;
+		}
+
+		writer.write(static_cast<uint64_t>(file.size()));
+		writer.write(hashAssetContent(file.data(), file.size()));
+	}
+
+	// Entry point, profile and defines are part of the arguments
+	for (const auto& argument : shaderCompileArguments(parameters))
+	{
+		writer.write(argument);
+	}
+
+	// 0 is kept for unreadable sources
+	auto key = writer.hash();
+
+	return key != 0 ? key : 1;
+}
+
+std::filesystem::path ShaderCache::blobPath(uint64_t key) const
+{
+	std::string name(16, '0');
+
+	for (int i = 15; i >= 0; i--)
+	{
+		name[i] = "0123456789abcdef"[key & 0xF];
+		key >>= 4;
+	}
+
+	return mDirectory / (name + ".dxil");
+}
+
+bool ShaderCache::load(uint64_t key, std::vector<uint8_t>& dxil) const
+{
+	MappedFile file;
+
+	if (!file.open(blobPath(key)) || file.size() < sizeof(ShaderBlobHeader))
+	{
+		return false;
+	}
+
+	ShaderBlobHeader header{};
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	if (header.magic != ShaderBlobMagic || header.version != ShaderCacheVersion || header.key != key ||
+		header.dataSize != file.size() - sizeof(header) || header.dataSize == 0)
+	{
+		return false;
+	}
+
+	auto data = file.data() + sizeof(header);
+
+	if (hashAssetContent(data, static_cast<size_t>(header.dataSize)) != header.dataHash)
+	{
+		return false;
+	}
+
+	dxil.assign(data, data + header.dataSize);
+
+	return true;
+}
+
+bool ShaderCache::store(uint64_t key, const std::vector<uint8_t>& dxil) const
+{
+	if (dxil.empty())
+	{
+		return false;
+	}
+
+	ShaderBlobHeader header{};
+	header.magic = ShaderBlobMagic;
+	header.version = ShaderCacheVersion;
+	header.key = key;
+	header.dataSize = dxil.size();
+	header.dataHash = hashAssetContent(dxil.data(), dxil.size());
+
+	std::error_code error;
+	std::filesystem::create_directories(mDirectory, error);
+
+	auto path = blobPath(key);
+	auto temporaryPath = path;
+	temporaryPath += ".tmp";
+
+	{
+		std::ofstream output(temporaryPath, std::ios::binary);
+
+		if (!output)
+		{
+			return false;
+		}
+
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		output.write(reinterpret_cast<const char*>(dxil.data()), dxil.size());
+
+		if (!output)
+		{
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+
+	if (error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	return true;
+}
+
+std::vector<std::vector<uint8_t>> ShaderCache::compile(const std::vector<ShaderCompileParameters>& requests, TaskScheduler& scheduler, const Compiler& compiler)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	auto requestCount = static_cast<uint32_t>(requests.size());
+
+	std::vector<uint64_t> keys(requestCount);
+
+	scheduler.run(requestCount, [&](uint32_t requestIndex, uint32_t /*threadIndex*/)
+	{
+		keys[requestIndex] = key(requests[requestIndex]);
+	});
+
+	// One job per distinct key, the first request with the key stands for all of them
+	std::vector<uint32_t> jobs;
+	std::vector<uint32_t> requestJobs(requestCount);
+	std::unordered_map<uint64_t, uint32_t> keyJobs;
+
+	for (uint32_t i = 0; i < requestCount; i++)
+	{
+		auto job = keyJobs.emplace(keys[i], static_cast<uint32_t>(jobs.size()));
+
+		if (job.second)
+		{
+			jobs.push_back(i);
+		}
+
+		requestJobs[i] = job.first->second;
+	}
+
+	std::vector<std::vector<uint8_t>> jobResults(jobs.size());
+	std::atomic<uint32_t> hits{ 0 };
+	std::atomic<uint32_t> misses{ 0 };
+	std::atomic<uint32_t> failures{ 0 };
+
+	scheduler.run(static_cast<uint32_t>(jobs.size()), [&](uint32_t jobIndex, uint32_t /*threadIndex*/)
+	{
+		auto requestIndex = jobs[jobIndex];
+		auto jobKey = keys[requestIndex];
+		auto& dxil = jobResults[jobIndex];
+
+		// Unreadable sources are never cached, the compiler reports them
+		if (jobKey != 0 && load(jobKey, dxil))
+		{
+			hits++;
+			return;
+		}
+
+		misses++;
+
+		dxil = compiler(requests[requestIndex]);
+
+		if (dxil.empty())
+		{
+			failures++;
+		}
+		else if (jobKey != 0)
+		{
+			store(jobKey, dxil);
+		}
+	});
+
+	mStatistics.hits = hits;
+	mStatistics.misses = misses;
+	mStatistics.failures = failures;
+
+	std::vector<std::vector<uint8_t>> results(requestCount);
+
+	for (uint32_t i = 0; i < requestCount; i++)
+	{
+		results[i] = jobResults[requestJobs[i]];
+	}
+
+	mStatistics.compileMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	return results;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+class TaskScheduler;
+
+struct ShaderCompileParameters
+{
+	std::wstring path;
+	std::wstring entryPoint;
+	std::wstring targetProfile;
+	std::vector<std::wstring> defines;
+};
+
+// Every argument Utils::compileShader passes to DXC besides the source.
+std::vector<std::wstring> shaderCompileArguments(const ShaderCompileParameters& parameters);
+
+// Names in the #include directives of source, in order. Comments are skipped but conditional blocks
+// are not evaluated, so this may name more files than a compilation reads, never fewer.
+std::vector<std::string> scanShaderIncludes(const std::string& source);
+
+// The file DXC's default include handler opens for name included from includer: next to includer
+// first, then in each include directory. Empty when there is none.
+std::filesystem::path resolveShaderInclude(const std::string& name, const std::filesystem::path& includer,
+										   const std::vector<std::filesystem::path>& includeDirectories);
+
+// path followed by every file it includes directly or indirectly, each once. Includes that do not
+// resolve are left out, the compilation reports them.
+std::vector<std::filesystem::path> collectShaderFiles(const std::filesystem::path& path, const std::vector<std::filesystem::path>& includeDirectories);
+
+struct ShaderCacheStatistics
+{
+	// Distinct compilations read from disk, and the ones handed to the compiler
+	uint32_t hits = 0;
+	uint32_t misses = 0;
+
+	// Misses the compiler returned nothing for, they are not stored
+	uint32_t failures = 0;
+
+	// Wall time of the last compile()
+	double compileMilliseconds = 0.0;
+};
+
+// DXIL blobs on disk named by a key that hashes the content of the source and of everything it
+// includes, the entry point, the profile, the defines, the DXC arguments and the compiler version,
+// so any edit or compiler update that could change the output misses and nothing else does. compile() resolves a batch: requests with equal
+// keys are done once, hits are read back, misses go to the compiler on the worker threads and are
+// stored for the next run. The cache never talks to DXC itself.
+class ShaderCache
+{
+public:
+	// Returns the DXIL, or nothing when compilation failed. Called on several threads at once.
+	using Compiler = std::function<std::vector<uint8_t>(const ShaderCompileParameters& parameters)>;
+
+	// compilerVersion names the compiler build, such as DXC's version and commit hash.
+	ShaderCache(const std::filesystem::path& directory, std::vector<std::filesystem::path> includeDirectories, const std::wstring& compilerVersion);
+
+	// 0 when the source file can not be read.
+	uint64_t key(const ShaderCompileParameters& parameters) const;
+
+	// False when the blob is missing or damaged.
+	bool load(uint64_t key, std::vector<uint8_t>& dxil) const;
+
+	// Writes through a temporary file, so a reader never sees half a blob.
+	bool store(uint64_t key, const std::vector<uint8_t>& dxil) const;
+
+	// DXIL for each request in order, empty for the ones that failed.
+	std::vector<std::vector<uint8_t>> compile(const std::vector<ShaderCompileParameters>& requests, TaskScheduler& scheduler, const Compiler& compiler);
+
+	const std::vector<std::filesystem::path>& includeDirectories() const { return mIncludeDirectories; }
+
+	const ShaderCacheStatistics& statistics() const { return mStatistics; }
+
+private:
+	std::filesystem::path blobPath(uint64_t key) const;
+
+	std::filesystem::path mDirectory;
+	std::vector<std::filesystem::path> mIncludeDirectories;
+	std::wstring mCompilerVersion;
+	ShaderCacheStatistics mStatistics;
+};
@@ -0,0 +1,208 @@
+#include "pch.h"
+#include "ShaderHotReload.h"
+#include "AssetCache.h"
+#include "MappedFile.h"
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+ShaderDependencyGraph::ShaderDependencyGraph(std::vector<std::filesystem::path> includeDirectories)
+: mIncludeDirectories(std::move(includeDirectories))
+{
+}
+
+void ShaderDependencyGraph::addProgram(const std::string& program, const std::filesystem::path& source)
+{
+	auto key = normalizeAssetPath(source);
+
+	if (mFiles.count(key) == 0)
+	{
+		mFiles[key].path = source.lexically_normal();
+		scan(key);
+	}
+
+	mPrograms.push_back({ program, key });
+}
+
+void ShaderDependencyGraph::scan(const std::string& key)
+{
+	std::vector<std::string> pending = { key };
+
+	while (!pending.empty())
+	{
+		auto current = pending.back();
+		pending.pop_back();
+
+		auto& node = mFiles[current];
+		node.includes.clear();
+
+		MappedFile file;
+
+		if (!file.open(node.path))
+		{
+			continue;
+		}
+
+		std::string source(reinterpret_cast<const char*>(file.data()), file.size());
+		file.close();
+
+		for (const auto& name : scanShaderIncludes(source))
+		{
+			auto include = resolveShaderInclude(name, node.path, mIncludeDirectories);
+
+			if (include.empty())
+			{
+				continue;
+			}
+
+			auto includeKey = normalizeAssetPath(include);
+
+			// Inserting into mFiles keeps references to its elements valid
+			node.includes.push_back(includeKey);
+
+			if (mFiles.count(includeKey) == 0)
+			{
+				mFiles[includeKey].path = include;
+				pending.push_back(includeKey);
+			}
+		}
+	}
+}
+
+std::vector<std::string> ShaderDependencyGraph::invalidate(const std::vector<std::filesystem::path>& changedFiles)
+{
+	std::vector<std::string> keys;
+
+	for (const auto& changedFile : changedFiles)
+	{
+		auto key = normalizeAssetPath(changedFile);
+
+		if (mFiles.count(key) > 0)
+		{
+			scan(key);
+			keys.push_back(key);
+		}
+	}
+
+	return dependents(keys);
+}
+
+std::vector<std::string> ShaderDependencyGraph::dependents(const std::filesystem::path& file) const
+{
+	return dependents(std::vector<std::string>{ normalizeAssetPath(file) });
+}
+
+std::vector<std::string> ShaderDependencyGraph::dependents(const std::vector<std::string>& keys) const
+{
+	// Walk the include edges backwards from the given files
+	std::unordered_map<std::string, std::vector<std::string>> includers;
+
+	for (const auto& file : mFiles)
+	{
+		for (const auto& include : file.second.includes)
+		{
+			includers[include].push_back(file.first);
+		}
+	}
+
+	std::unordered_set<std::string> reached;
+	std::vector<std::string> pending;
+
+	for (const auto& key : keys)
+	{
+		if (mFiles.count(key) > 0 && reached.insert(key).second)
+		{
+			pending.push_back(key);
+		}
+	}
+
+	while (!pending.empty())
+	{
+		auto current = pending.back();
+		pending.pop_back();
+
+		auto includer = includers.find(current);
+
+		if (includer == includers.end())
+		{
+			continue;
+		}
+
+		for (const auto& key : includer->second)
+		{
+			if (reached.insert(key).second)
+			{
+				pending.push_back(key);
+			}
+		}
+	}
+
+	std::vector<std::string> programs;
+
+	for (const auto& program : mPrograms)
+	{
+		if (reached.count(program.source) > 0)
+		{
+			programs.push_back(program.name);
+		}
+	}
+
+	return programs;
+}
+
+std::vector<std::filesystem::path> ShaderDependencyGraph::files() const
+{
+	std::vector<std::filesystem::path> files;
+
+	for (const auto& file : mFiles)
+	{
+		files.push_back(file.second.path);
+	}
+
+	std::sort(files.begin(), files.end());
+
+	return files;
+}
+
+FileWatcher::WatchedFile FileWatcher::stat(const std::filesystem::path& path)
+{
+	WatchedFile file;
+	file.path = path;
+
+	std::error_code error;
+	file.writeTime = std::filesystem::last_write_time(path, error);
+	file.exists = !error;
+
+	return file;
+}
+
+void FileWatcher::watch(const std::filesystem::path& path)
+{
+	auto key = normalizeAssetPath(path);
+
+	if (mFiles.count(key) == 0)
+	{
+		mFiles.emplace(key, stat(path));
+	}
+}
+
+std::vector<std::filesystem::path> FileWatcher::poll()
+{
+	std::vector<std::filesystem::path> changed;
+
+	for (auto& file : mFiles)
+	{
+		auto current = stat(file.second.path);
+
+		if (current.exists != file.second.exists || (current.exists && current.writeTime != file.second.writeTime))
+		{
+			changed.push_back(file.second.path);
+			file.second = current;
+		}
+	}
+
+	std::sort(changed.begin(), changed.end());
+
+	return changed;
+}
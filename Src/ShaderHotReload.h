@@ -0,0 +1,80 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Which shader programs read which files. Every program names its source file, every file the
+// files it #includes (scanned with scanShaderIncludes, resolved like DXC does), so an edit to a
+// shared header such as LightingUtil.hlsl maps to exactly the programs that have to be compiled
+// again. Files are keyed by normalizeAssetPath, so differently spelled paths meet.
+class ShaderDependencyGraph
+{
+public:
+	explicit ShaderDependencyGraph(std::vector<std::filesystem::path> includeDirectories = {});
+
+	// program is compiled from source. Scans source and the files it includes that are new to the graph.
+	void addProgram(const std::string& program, const std::filesystem::path& source);
+
+	// Scans changedFiles again, as their #includes may have changed as well, and returns the programs
+	// that read any of them directly or through includes, in the order they were added.
+	std::vector<std::string> invalidate(const std::vector<std::filesystem::path>& changedFiles);
+
+	// Programs that read file, in the order they were added.
+	std::vector<std::string> dependents(const std::filesystem::path& file) const;
+
+	// Every file in the graph, for the file watcher.
+	std::vector<std::filesystem::path> files() const;
+
+	size_t programCount() const { return mPrograms.size(); }
+
+private:
+	struct FileNode
+	{
+		std::filesystem::path path;
+
+		// Keys of the files included, unresolved names are left out
+		std::vector<std::string> includes;
+	};
+
+	struct Program
+	{
+		std::string name;
+		std::string source;
+	};
+
+	// Reads the file and adds the files it includes that are not in the graph yet.
+	void scan(const std::string& key);
+	std::vector<std::string> dependents(const std::vector<std::string>& keys) const;
+
+	std::vector<std::filesystem::path> mIncludeDirectories;
+	std::unordered_map<std::string, FileNode> mFiles;
+	std::vector<Program> mPrograms;
+};
+
+// Reports files whose modification time changed, by polling. Cheap enough for the few dozen files
+// of the shader folder every few hundred milliseconds, and the same on every platform.
+class FileWatcher
+{
+public:
+	// Remembers the current modification time of path, watching a path again does nothing.
+	void watch(const std::filesystem::path& path);
+
+	// The watched files that were modified, created or deleted since the last poll().
+	std::vector<std::filesystem::path> poll();
+
+	size_t watchedCount() const { return mFiles.size(); }
+
+private:
+	struct WatchedFile
+	{
+		std::filesystem::path path;
+		std::filesystem::file_time_type writeTime;
+		bool exists = false;
+	};
+
+	static WatchedFile stat(const std::filesystem::path& path);
+
+	std::unordered_map<std::string, WatchedFile> mFiles;
+};
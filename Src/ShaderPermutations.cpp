@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "ShaderPermutations.h"
+
+#include <cassert>
+#include <cctype>
+
+ShaderPermutations::ShaderPermutations(std::vector<ShaderFeatureDesc> features)
+: mFeatures(std::move(features))
+{
+	assert(mFeatures.size() <= 32);
+}
+
+uint32_t ShaderPermutations::addProgram(ShaderProgramDesc program)
+{
+	assert(mFeatures.size() == 32 || (program.features >> mFeatures.size()) == 0);
+
+	mPrograms.push_back(std::move(program));
+
+	return static_cast<uint32_t>(mPrograms.size() - 1);
+}
+
+bool ShaderPermutations::isValid(ShaderPermutationKey key) const
+{
+	auto program = shaderPermutationProgram(key);
+
+	return program < mPrograms.size() && (shaderPermutationFeatures(key) & ~mPrograms[program].features) == 0;
+}
+
+ShaderCompileParameters ShaderPermutations::parameters(ShaderPermutationKey key) const
+{
+	assert(isValid(key));
+
+	const auto& program = mPrograms[shaderPermutationProgram(key)];
+	auto features = shaderPermutationFeatures(key);
+
+	ShaderCompileParameters parameters;
+	parameters.path = program.path;
+	parameters.entryPoint = program.entryPoint;
+	parameters.targetProfile = program.targetProfile;
+
+	for (size_t i = 0; i < mFeatures.size(); i++)
+	{
+		if (features & (1u << i))
+		{
+			parameters.defines.push_back(mFeatures[i].define);
+		}
+	}
+
+	return parameters;
+}
+
+std::string ShaderPermutations::name(ShaderPermutationKey key) const
+{
+	assert(isValid(key));
+
+	const auto& program = mPrograms[shaderPermutationProgram(key)];
+	auto features = shaderPermutationFeatures(key);
+
+	auto name = program.name;
+
+	for (size_t i = 0; i < mFeatures.size(); i++)
+	{
+		if (features & (1u << i))
+		{
+			name += mFeatures[i].name;
+		}
+	}
+
+	// "ps_6_0" -> "PS"
+	for (size_t i = 0; i < program.targetProfile.size() && program.targetProfile[i] != L'_'; i++)
+	{
+		name += static_cast<char>(std::toupper(static_cast<int>(program.targetProfile[i])));
+	}
+
+	return name;
+}
+
+bool ShaderPermutations::request(ShaderPermutationKey key)
+{
+	assert(isValid(key));
+
+	return mRequested.insert(key).second;
+}
+
+uint64_t ShaderPermutations::permutationCount() const
+{
+	uint64_t count = 0;
+
+	for (const auto& program : mPrograms)
+	{
+		uint32_t featureCount = 0;
+
+		for (auto features = program.features; features != 0; features &= features - 1)
+		{
+			featureCount++;
+		}
+
+		count += 1ull << featureCount;
+	}
+
+	return count;
+}
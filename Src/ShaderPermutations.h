@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "ShaderCache.h"
+
+using ShaderFeatureMask = uint32_t;
+using ShaderPermutationKey = uint64_t;
+
+// Program index in the upper half, feature bits in the lower half, so the permutations the code
+// draws with are compile time constants.
+template <typename Program>
+constexpr ShaderPermutationKey shaderPermutationKey(Program program, ShaderFeatureMask features = 0)
+{
+	return (static_cast<ShaderPermutationKey>(program) << 32) | features;
+}
+
+constexpr uint32_t shaderPermutationProgram(ShaderPermutationKey key)
+{
+	return static_cast<uint32_t>(key >> 32);
+}
+
+constexpr ShaderFeatureMask shaderPermutationFeatures(ShaderPermutationKey key)
+{
+	return static_cast<ShaderFeatureMask>(key);
+}
+
+struct ShaderFeatureDesc
+{
+	// Defined for the compilation when the feature's bit is set
+	std::wstring define;
+
+	// Part of permutation names, such as "AlphaTest"
+	std::string name;
+};
+
+struct ShaderProgramDesc
+{
+	// Permutation names start with this and end with the stage of the profile: "LandAndOcean" + "Fog" + "PS"
+	std::string name;
+
+	std::wstring path;
+	std::wstring entryPoint;
+	std::wstring targetProfile;
+
+	// The feature bits the program reacts to, no others may be requested
+	ShaderFeatureMask features = 0;
+};
+
+// Every shader program described once: its source, entry point and profile, and the feature bits
+// it supports, each of which turns on one define. A permutation is a program plus a subset of its
+// features and is named and compiled from that alone, so nothing is spent on the ones never asked
+// for. Knows nothing about DXC; compiling is up to the caller.
+class ShaderPermutations
+{
+public:
+	// Bit i of a feature mask stands for features[i].
+	explicit ShaderPermutations(std::vector<ShaderFeatureDesc> features);
+
+	// Returns the program's index, the value shaderPermutationKey expects for it.
+	uint32_t addProgram(ShaderProgramDesc program);
+
+	bool isValid(ShaderPermutationKey key) const;
+
+	// Defines follow the order of the feature bits, so one key always gives the same compilation.
+	ShaderCompileParameters parameters(ShaderPermutationKey key) const;
+
+	// Such as "LandAndOceanAlphaTestFogPS", also the name of the precompiled .dxil file.
+	std::string name(ShaderPermutationKey key) const;
+
+	// Marks key as used, true the first time.
+	bool request(ShaderPermutationKey key);
+
+	bool isRequested(ShaderPermutationKey key) const { return mRequested.count(key) != 0; }
+
+	size_t requestedCount() const { return mRequested.size(); }
+
+	// Permutations of all programs together, 2^n for a program with n features.
+	uint64_t permutationCount() const;
+
+	size_t programCount() const { return mPrograms.size(); }
+
+private:
+	std::vector<ShaderFeatureDesc> mFeatures;
+	std::vector<ShaderProgramDesc> mPrograms;
+	std::unordered_set<ShaderPermutationKey> mRequested;
+};
@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "StagingRing.h"
+
+StagingRing::StagingRing(uint64_t capacity)
+{
+	reset(capacity);
+}
+
+void StagingRing::reset(uint64_t capacity)
+{
+	mRegions.clear();
+	mCapacity = capacity;
+	mHead = 0;
+	mTail = 0;
+	mRetiredHead = 0;
+}
+
+uint64_t StagingRing::allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || size > mCapacity)
+	{
+		return InvalidOffset;
+	}
+
+	auto position = mHead % mCapacity;
+	auto offset = (position + alignment - 1) & ~(alignment - 1);
+
+	// Not enough room before the end of the buffer, skip the rest and start again at 0
+	if (offset + size > mCapacity)
+	{
+		offset = 0;
+	}
+
+	auto padding = offset >= position ? offset - position : mCapacity - position;
+
+	if (mHead + padding + size - mTail > mCapacity)
+	{
+		return InvalidOffset;
+	}
+
+	mHead += padding + size;
+
+	return offset;
+}
+
+void StagingRing::retire(uint64_t fenceValue)
+{
+	if (mHead == mRetiredHead)
+	{
+		return;
+	}
+
+	mRegions.push_back({ mHead, fenceValue });
+	mRetiredHead = mHead;
+}
+
+void StagingRing::reclaim(uint64_t completedFenceValue)
+{
+	while (!mRegions.empty() && mRegions.front().fenceValue <= completedFenceValue)
+	{
+		mTail = mRegions.front().end;
+		mRegions.pop_front();
+	}
+
+	// Once the ring is idle start over at offset 0, large uploads then do not have to wrap
+	if (mTail == mHead)
+	{
+		mHead = 0;
+		mTail = 0;
+		mRetiredHead = 0;
+	}
+}
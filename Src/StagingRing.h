@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Ring allocator over a persistently mapped upload buffer.
+// Allocations are handed out front to back and wrap around at the end of the buffer. Everything
+// allocated since the previous retire() is tagged with the fence value passed to retire(), and the
+// space is only handed out again once reclaim() sees that fence value completed. The class knows
+// nothing about D3D12, the caller supplies the fence values.
+class StagingRing
+{
+public:
+	static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+	StagingRing() = default;
+	explicit StagingRing(uint64_t capacity);
+
+	// Drops every region, only valid once the GPU no longer reads the buffer.
+	void reset(uint64_t capacity);
+
+	// Returns the offset of size bytes aligned to alignment (a power of two),
+	// or InvalidOffset when the ring has no room until a region is reclaimed.
+	uint64_t allocate(uint64_t size, uint64_t alignment);
+
+	// Tags the allocations made since the previous retire() with fenceValue.
+	void retire(uint64_t fenceValue);
+
+	// Frees every region whose fence value is <= completedFenceValue.
+	void reclaim(uint64_t completedFenceValue);
+
+	uint64_t capacity() const { return mCapacity; }
+
+	// Bytes between the oldest live region and the head, including wrap padding.
+	uint64_t usedBytes() const { return mHead - mTail; }
+
+	// Bytes allocated but not yet retired.
+	uint64_t openBytes() const { return mHead - mRetiredHead; }
+
+	size_t regionCount() const { return mRegions.size(); }
+
+private:
+	struct Region
+	{
+		// Head position (monotonic, not wrapped) when the region was retired.
+		uint64_t end = 0;
+		uint64_t fenceValue = 0;
+	};
+
+	std::deque<Region> mRegions;
+	uint64_t mCapacity = 0;
+
+	// Monotonic byte positions, the offset into the buffer is position % capacity.
+	uint64_t mHead = 0;
+	uint64_t mTail = 0;
+	uint64_t mRetiredHead = 0;
+};
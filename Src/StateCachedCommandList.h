@@ -0,0 +1,303 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+enum class CommandListState : uint32_t
+{
+	PipelineState,
+	RootSignature,
+	DescriptorHeaps,
+	PrimitiveTopology,
+	VertexBuffers,
+	IndexBuffer,
+	RootDescriptorTable,
+	RootConstantBufferView,
+	RootShaderResourceView,
+	StencilRef,
+	Count
+};
+
+struct CommandListStateStatistics
+{
+	std::array<uint32_t, static_cast<size_t>(CommandListState::Count)> issued{};
+	std::array<uint32_t, static_cast<size_t>(CommandListState::Count)> elided{};
+
+	uint32_t issuedCount(CommandListState state) const { return issued[static_cast<size_t>(state)]; }
+	uint32_t elidedCount(CommandListState state) const { return elided[static_cast<size_t>(state)]; }
+
+	uint32_t totalIssued() const { return sum(issued); }
+	uint32_t totalElided() const { return sum(elided); }
+
+	void add(const CommandListStateStatistics& other)
+	{
+		for (size_t i = 0; i < issued.size(); i++)
+		{
+			issued[i] += other.issued[i];
+			elided[i] += other.elided[i];
+		}
+	}
+
+private:
+	static uint32_t sum(const std::array<uint32_t, static_cast<size_t>(CommandListState::Count)>& counts)
+	{
+		uint32_t total = 0;
+
+		for (auto count : counts)
+		{
+			total += count;
+		}
+
+		return total;
+	}
+};
+
+// Thin wrapper that forwards state setting calls to a graphics command list only when the value
+// differs from what the list already has bound, and counts the calls it issued and dropped.
+// CommandList is ID3D12GraphicsCommandList in the app; any type with the same methods works,
+// which lets the filtering be checked against a recording fake without a device.
+// State set on the list directly (through get()) bypasses the cache, call invalidate() afterwards.
+template <typename CommandList>
+class StateCachedCommandList
+{
+public:
+	static constexpr uint32_t MaxRootParameters = 64;
+	static constexpr uint32_t MaxVertexBuffers = D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+
+	explicit StateCachedCommandList(CommandList* commandList = nullptr)
+	: mCommandList(commandList)
+	{
+	}
+
+	// Starts over with a list that was just reset, nothing is known to be bound.
+	void reset(CommandList* commandList)
+	{
+		mCommandList = commandList;
+		invalidate();
+	}
+
+	void invalidate()
+	{
+		mPipelineState = nullptr;
+		mRootSignature = nullptr;
+		mDescriptorHeaps = {};
+		mDescriptorHeapCount = 0;
+		mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+		mVertexBufferValid = {};
+		mIndexBufferValid = false;
+		mStencilRefValid = false;
+		invalidateRootArguments();
+	}
+
+	CommandList* get() const { return mCommandList; }
+	CommandList* operator->() const { return mCommandList; }
+
+	void setPipelineState(ID3D12PipelineState* pipelineState)
+	{
+		if (filter(CommandListState::PipelineState, pipelineState == mPipelineState))
+		{
+			mCommandList->SetPipelineState(pipelineState);
+			mPipelineState = pipelineState;
+		}
+	}
+
+	void setGraphicsRootSignature(ID3D12RootSignature* rootSignature)
+	{
+		if (filter(CommandListState::RootSignature, rootSignature == mRootSignature))
+		{
+			mCommandList->SetGraphicsRootSignature(rootSignature);
+			mRootSignature = rootSignature;
+
+			// A different root signature leaves every root argument undefined
+			invalidateRootArguments();
+		}
+	}
+
+	void setDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* descriptorHeaps)
+	{
+		bool same = count == mDescriptorHeapCount && std::equal(descriptorHeaps, descriptorHeaps + count, mDescriptorHeaps.begin());
+
+		if (filter(CommandListState::DescriptorHeaps, same))
+		{
+			mCommandList->SetDescriptorHeaps(count, descriptorHeaps);
+			std::copy(descriptorHeaps, descriptorHeaps + count, mDescriptorHeaps.begin());
+			mDescriptorHeapCount = count;
+
+			// Descriptor tables point into the previous heaps
+			for (auto& argument : mRootArguments)
+			{
+				if (argument.type == RootArgumentType::DescriptorTable)
+				{
+					argument.type = RootArgumentType::None;
+				}
+			}
+		}
+	}
+
+	void setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology)
+	{
+		if (filter(CommandListState::PrimitiveTopology, primitiveTopology == mPrimitiveTopology))
+		{
+			mCommandList->IASetPrimitiveTopology(primitiveTopology);
+			mPrimitiveTopology = primitiveTopology;
+		}
+	}
+
+	void setVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* views)
+	{
+		bool same = true;
+
+		for (uint32_t i = 0; i < count && same; i++)
+		{
+			same = mVertexBufferValid[startSlot + i] && std::memcmp(&views[i], &mVertexBuffers[startSlot + i], sizeof(D3D12_VERTEX_BUFFER_VIEW)) == 0;
+		}
+
+		if (filter(CommandListState::VertexBuffers, same))
+		{
+			mCommandList->IASetVertexBuffers(startSlot, count, views);
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				mVertexBuffers[startSlot + i] = views[i];
+				mVertexBufferValid[startSlot + i] = true;
+			}
+		}
+	}
+
+	void setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view)
+	{
+		bool same = mIndexBufferValid && std::memcmp(&view, &mIndexBuffer, sizeof(D3D12_INDEX_BUFFER_VIEW)) == 0;
+
+		if (filter(CommandListState::IndexBuffer, same))
+		{
+			mCommandList->IASetIndexBuffer(&view);
+			mIndexBuffer = view;
+			mIndexBufferValid = true;
+		}
+	}
+
+	void setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+	{
+		if (filterRootArgument(CommandListState::RootDescriptorTable, rootParameterIndex, RootArgumentType::DescriptorTable, baseDescriptor.ptr))
+		{
+			mCommandList->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+		}
+	}
+
+	void setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+	{
+		if (filterRootArgument(CommandListState::RootConstantBufferView, rootParameterIndex, RootArgumentType::ConstantBufferView, bufferLocation))
+		{
+			mCommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+		}
+	}
+
+	void setGraphicsRootShaderResourceView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+	{
+		if (filterRootArgument(CommandListState::RootShaderResourceView, rootParameterIndex, RootArgumentType::ShaderResourceView, bufferLocation))
+		{
+			mCommandList->SetGraphicsRootShaderResourceView(rootParameterIndex, bufferLocation);
+		}
+	}
+
+	void setStencilRef(uint32_t stencilRef)
+	{
+		if (filter(CommandListState::StencilRef, mStencilRefValid && stencilRef == mStencilRef))
+		{
+			mCommandList->OMSetStencilRef(stencilRef);
+			mStencilRef = stencilRef;
+			mStencilRefValid = true;
+		}
+	}
+
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+	{
+		mCommandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+	}
+
+	// The command signature may rebind root arguments and vertex/index buffers, the values
+	// the last command leaves behind are not known here.
+	void executeIndirect(ID3D12CommandSignature* commandSignature, uint32_t maxCommandCount, ID3D12Resource* argumentBuffer, uint64_t argumentBufferOffset,
+						 ID3D12Resource* countBuffer = nullptr, uint64_t countBufferOffset = 0)
+	{
+		mCommandList->ExecuteIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset, countBuffer, countBufferOffset);
+
+		mVertexBufferValid = {};
+		mIndexBufferValid = false;
+		invalidateRootArguments();
+	}
+
+	void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+	{
+		mCommandList->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+	}
+
+	const CommandListStateStatistics& statistics() const { return mStatistics; }
+	void resetStatistics() { mStatistics = {}; }
+
+private:
+	enum class RootArgumentType : uint32_t
+	{
+		None,
+		DescriptorTable,
+		ConstantBufferView,
+		ShaderResourceView
+	};
+
+	struct RootArgument
+	{
+		RootArgumentType type = RootArgumentType::None;
+		uint64_t value = 0;
+	};
+
+	// Returns true when the call has to be issued.
+	bool filter(CommandListState state, bool redundant)
+	{
+		auto& counts = redundant ? mStatistics.elided : mStatistics.issued;
+		counts[static_cast<size_t>(state)]++;
+
+		return !redundant;
+	}
+
+	bool filterRootArgument(CommandListState state, uint32_t rootParameterIndex, RootArgumentType type, uint64_t value)
+	{
+		auto& argument = mRootArguments[rootParameterIndex];
+
+		if (!filter(state, argument.type == type && argument.value == value))
+		{
+			return false;
+		}
+
+		argument.type = type;
+		argument.value = value;
+
+		return true;
+	}
+
+	void invalidateRootArguments()
+	{
+		mRootArguments = {};
+	}
+
+	CommandList* mCommandList = nullptr;
+
+	ID3D12PipelineState* mPipelineState = nullptr;
+	ID3D12RootSignature* mRootSignature = nullptr;
+	// At most one CBV/SRV/UAV heap and one sampler heap can be bound
+	std::array<ID3D12DescriptorHeap*, 2> mDescriptorHeaps{};
+	uint32_t mDescriptorHeapCount = 0;
+	D3D12_PRIMITIVE_TOPOLOGY mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	std::array<D3D12_VERTEX_BUFFER_VIEW, MaxVertexBuffers> mVertexBuffers{};
+	std::array<bool, MaxVertexBuffers> mVertexBufferValid{};
+	D3D12_INDEX_BUFFER_VIEW mIndexBuffer{};
+	bool mIndexBufferValid = false;
+	uint32_t mStencilRef = 0;
+	bool mStencilRefValid = false;
+	std::array<RootArgument, MaxRootParameters> mRootArguments{};
+
+	CommandListStateStatistics mStatistics;
+};
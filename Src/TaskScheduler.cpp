@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+std::vector<TaskRange> splitIntoChunks(uint32_t count, uint32_t maxChunkCount, uint32_t minChunkSize)
+{
+	std::vector<TaskRange> chunks;
+
+	if (count == 0)
+	{
+		return chunks;
+	}
+
+	auto chunkCount = std::max(1u, std::min(maxChunkCount, count / std::max(1u, minChunkSize)));
+
+	// The first count % chunkCount chunks take one item more
+	auto chunkSize = count / chunkCount;
+	auto remainder = count % chunkCount;
+
+	uint32_t begin = 0;
+
+	for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		auto end = begin + chunkSize + (chunk < remainder ? 1 : 0);
+		chunks.push_back({ begin, end });
+		begin = end;
+	}
+
+	return chunks;
+}
+
+TaskScheduler::TaskScheduler(uint32_t threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for (uint32_t threadIndex = 1; threadIndex < threadCount; threadIndex++)
+	{
+		mWorkers.emplace_back(&TaskScheduler::workerMain, this, threadIndex);
+	}
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+
+	mWorkAvailable.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void TaskScheduler::run(uint32_t taskCount, const Task& task)
+{
+	if (taskCount == 0)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTask = &task;
+		mTaskCount = taskCount;
+		mNextTask = 0;
+		mBusyWorkers = static_cast<uint32_t>(mWorkers.size());
+		mException = nullptr;
+		mGeneration++;
+	}
+
+	mWorkAvailable.notify_all();
+
+	runTasks(0);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mWorkDone.wait(lock, [this]() { return mBusyWorkers == 0; });
+
+	mTask = nullptr;
+
+	if (mException)
+	{
+		std::rethrow_exception(mException);
+	}
+}
+
+void TaskScheduler::workerMain(uint32_t threadIndex)
+{
+	uint64_t generation = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkAvailable.wait(lock, [this, generation]() { return mQuit || mGeneration != generation; });
+
+			if (mQuit)
+			{
+				return;
+			}
+
+			generation = mGeneration;
+		}
+
+		runTasks(threadIndex);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		if (--mBusyWorkers == 0)
+		{
+			mWorkDone.notify_one();
+		}
+	}
+}
+
+void TaskScheduler::runTasks(uint32_t threadIndex)
+{
+	for (auto taskIndex = mNextTask++; taskIndex < mTaskCount; taskIndex = mNextTask++)
+	{
+		try
+		{
+			(*mTask)(taskIndex, threadIndex);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (!mException)
+			{
+				mException = std::current_exception();
+			}
+		}
+	}
+}
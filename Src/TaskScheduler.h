@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct TaskRange
+{
+	uint32_t begin = 0;
+	uint32_t end = 0;
+
+	uint32_t size() const { return end - begin; }
+};
+
+// Splits [0, count) into at most maxChunkCount contiguous ranges of at least minChunkSize items
+// (except when count itself is smaller) whose sizes differ by at most one.
+std::vector<TaskRange> splitIntoChunks(uint32_t count, uint32_t maxChunkCount, uint32_t minChunkSize);
+
+// Persistent worker threads for short fork/join jobs such as recording command lists in parallel.
+// Unlike parallelFor in Parallel.h no thread is created per job, and tasks are pulled one by one,
+// so uneven tasks still keep every thread busy.
+class TaskScheduler
+{
+public:
+	using Task = std::function<void(uint32_t taskIndex, uint32_t threadIndex)>;
+
+	// threadCount includes the calling thread, 0 means one per hardware thread.
+	explicit TaskScheduler(uint32_t threadCount = 0);
+	TaskScheduler(const TaskScheduler& rhs) = delete;
+	TaskScheduler& operator=(const TaskScheduler& rhs) = delete;
+	~TaskScheduler();
+
+	uint32_t threadCount() const { return static_cast<uint32_t>(mWorkers.size()) + 1; }
+
+	// Runs task(taskIndex, threadIndex) for every task in [0, taskCount) and returns when all are done.
+	// The calling thread works too, as thread 0. The first exception a task throws is rethrown here.
+	void run(uint32_t taskCount, const Task& task);
+
+private:
+	void workerMain(uint32_t threadIndex);
+	void runTasks(uint32_t threadIndex);
+
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+
+	const Task* mTask = nullptr;
+	uint32_t mTaskCount = 0;
+	std::atomic<uint32_t> mNextTask{ 0 };
+	uint64_t mGeneration = 0;
+	uint32_t mBusyWorkers = 0;
+	bool mQuit = false;
+
+	std::exception_ptr mException;
+};
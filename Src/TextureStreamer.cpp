@@ -0,0 +1,293 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+TextureStreamer::TextureStreamer(uint64_t budgetBytes)
+: mBudgetBytes(budgetBytes)
+{
+}
+
+StreamedTextureId TextureStreamer::registerTexture(const StreamedTextureDesc& desc)
+{
+	TextureState texture;
+	texture.mipSizes = desc.mipSizes;
+
+	auto mipCount = static_cast<uint32_t>(desc.mipSizes.size());
+	auto tailMipCount = std::clamp(desc.tailMipCount, 1u, std::max(1u, mipCount));
+
+	texture.tailMip = mipCount - std::min(tailMipCount, mipCount);
+	texture.residentMip = mipCount;
+	texture.pendingMip = mipCount;
+	texture.desiredMip = texture.tailMip;
+
+	mTextures.push_back(std::move(texture));
+
+	return static_cast<StreamedTextureId>(mTextures.size() - 1);
+}
+
+void TextureStreamer::requestMip(StreamedTextureId texture, float mip, uint64_t frame)
+{
+	auto& state = mTextures[texture];
+
+	auto requested = static_cast<uint32_t>(std::clamp(std::floor(mip), 0.0f, static_cast<float>(state.tailMip)));
+
+	// The first request of a frame replaces the previous frame's wish, later ones can only refine it
+	if (state.lastUsedFrame != frame)
+	{
+		state.desiredMip = requested;
+	}
+	else
+	{
+		state.desiredMip = std::min(state.desiredMip, requested);
+	}
+
+	state.lastUsedFrame = frame;
+}
+
+float TextureStreamer::calculateDesiredMip(uint32_t width, uint32_t height, float screenPixels, float uvArea)
+{
+	auto coarsestMip = std::log2(static_cast<float>(std::max(1u, std::max(width, height))));
+
+	if (screenPixels <= 0.0f)
+	{
+		return coarsestMip;
+	}
+
+	// Each mip level divides the texel count by 4, so the level is half the log2 of texels per pixel
+	auto texelsPerPixel = static_cast<float>(width) * height * uvArea / screenPixels;
+
+	return std::clamp(0.5f * std::log2(std::max(texelsPerPixel, 1.0f)), 0.0f, coarsestMip);
+}
+
+std::vector<StreamingRequest> TextureStreamer::update(uint64_t frame, uint64_t maxLoadBytes)
+{
+	std::vector<StreamingRequest> requests;
+
+	mStatistics.loadsIssued = 0;
+	mStatistics.evictionsIssued = 0;
+	mStatistics.loadsDeferred = 0;
+
+	uint64_t issuedBytes = 0;
+
+	for (auto& texture : mTextures)
+	{
+		if (frame > texture.lastUsedFrame + mRequestTimeout)
+		{
+			texture.desiredMip = texture.tailMip;
+		}
+	}
+
+	// Mip tails come first and are not subject to the budget, a texture must always have something to sample
+	for (StreamedTextureId id = 0; id < mTextures.size(); id++)
+	{
+		auto& texture = mTextures[id];
+		auto mipCount = static_cast<uint32_t>(texture.mipSizes.size());
+
+		if (texture.pendingMip != mipCount || mipCount == 0)
+		{
+			continue;
+		}
+
+		auto bytes = mipRangeBytes(texture, texture.tailMip, mipCount);
+
+		if (mResidentBytes + mPendingBytes + bytes > mBudgetBytes)
+		{
+			makeRoom(bytes, id, frame, requests);
+		}
+
+		texture.pendingMip = texture.tailMip;
+		mPendingBytes += bytes;
+		issuedBytes += bytes;
+
+		requests.push_back({ id, StreamingAction::Load, texture.tailMip, bytes });
+		mStatistics.loadsIssued++;
+	}
+
+	// Textures missing the most mips first, ties go to the most recently used one
+	std::vector<StreamedTextureId> candidates;
+
+	for (StreamedTextureId id = 0; id < mTextures.size(); id++)
+	{
+		const auto& texture = mTextures[id];
+
+		if (texture.pendingMip == texture.residentMip && texture.desiredMip < texture.residentMip)
+		{
+			candidates.push_back(id);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [this](StreamedTextureId a, StreamedTextureId b)
+	{
+		const auto& left = mTextures[a];
+		const auto& right = mTextures[b];
+		auto leftMissing = left.residentMip - left.desiredMip;
+		auto rightMissing = right.residentMip - right.desiredMip;
+
+		if (leftMissing != rightMissing)
+		{
+			return leftMissing > rightMissing;
+		}
+
+		return left.lastUsedFrame > right.lastUsedFrame;
+	});
+
+	for (auto id : candidates)
+	{
+		auto& texture = mTextures[id];
+
+		// One mip per update so that every texture sharpens progressively
+		auto mip = texture.residentMip - 1;
+		auto bytes = texture.mipSizes[mip];
+
+		if (issuedBytes + bytes > maxLoadBytes)
+		{
+			mStatistics.loadsDeferred++;
+			continue;
+		}
+
+		if (mResidentBytes + mPendingBytes + bytes > mBudgetBytes && !makeRoom(bytes, id, frame, requests))
+		{
+			mStatistics.loadsDeferred++;
+			continue;
+		}
+
+		texture.pendingMip = mip;
+		mPendingBytes += bytes;
+		issuedBytes += bytes;
+
+		requests.push_back({ id, StreamingAction::Load, mip, bytes });
+		mStatistics.loadsIssued++;
+	}
+
+	mStatistics.budgetBytes = mBudgetBytes;
+	mStatistics.residentBytes = mResidentBytes;
+	mStatistics.pendingBytes = mPendingBytes;
+
+	return requests;
+}
+
+void TextureStreamer::completeLoad(StreamedTextureId texture, uint32_t mip)
+{
+	auto& state = mTextures[texture];
+
+	if (state.pendingMip != mip || mip >= state.residentMip)
+	{
+		return;
+	}
+
+	auto bytes = mipRangeBytes(state, mip, state.residentMip);
+
+	mPendingBytes -= bytes;
+	mResidentBytes += bytes;
+
+	state.residentMip = mip;
+
+	mStatistics.residentBytes = mResidentBytes;
+	mStatistics.pendingBytes = mPendingBytes;
+}
+
+uint64_t TextureStreamer::mipRangeBytes(const TextureState& texture, uint32_t begin, uint32_t end) const
+{
+	uint64_t bytes = 0;
+
+	for (auto mip = begin; mip < end; mip++)
+	{
+		bytes += texture.mipSizes[mip];
+	}
+
+	return bytes;
+}
+
+bool TextureStreamer::makeRoom(uint64_t bytes, StreamedTextureId loading, uint64_t frame, std::vector<StreamingRequest>& requests)
+{
+	auto used = mResidentBytes + mPendingBytes;
+
+	if (used + bytes <= mBudgetBytes)
+	{
+		return true;
+	}
+
+	auto needed = used + bytes - mBudgetBytes;
+
+	// Least recently used first
+	std::vector<StreamedTextureId> victims;
+
+	for (StreamedTextureId id = 0; id < mTextures.size(); id++)
+	{
+		const auto& texture = mTextures[id];
+
+		if (id != loading && texture.pendingMip == texture.residentMip && texture.residentMip < texture.tailMip)
+		{
+			victims.push_back(id);
+		}
+	}
+
+	std::sort(victims.begin(), victims.end(), [this](StreamedTextureId a, StreamedTextureId b)
+	{
+		return mTextures[a].lastUsedFrame < mTextures[b].lastUsedFrame;
+	});
+
+	// First pass drops mips nobody wants any more, the second one takes wanted mips from textures
+	// not used this frame. Textures drawn this frame keep what they asked for, which avoids thrashing.
+	std::vector<uint32_t> evictTo(mTextures.size());
+	uint64_t freed = 0;
+
+	for (auto id : victims)
+	{
+		evictTo[id] = mTextures[id].residentMip;
+	}
+
+	for (uint32_t pass = 0; pass < 2 && freed < needed; pass++)
+	{
+		for (auto id : victims)
+		{
+			const auto& texture = mTextures[id];
+
+			if (pass == 1 && texture.lastUsedFrame >= frame)
+			{
+				continue;
+			}
+
+			auto limit = pass == 0 ? std::max(texture.desiredMip, texture.residentMip) : texture.tailMip;
+
+			while (evictTo[id] < limit && freed < needed)
+			{
+				freed += texture.mipSizes[evictTo[id]];
+				evictTo[id]++;
+			}
+
+			if (freed >= needed)
+			{
+				break;
+			}
+		}
+	}
+
+	if (freed < needed)
+	{
+		return false;
+	}
+
+	for (auto id : victims)
+	{
+		auto& texture = mTextures[id];
+
+		if (evictTo[id] == texture.residentMip)
+		{
+			continue;
+		}
+
+		auto evictedBytes = mipRangeBytes(texture, texture.residentMip, evictTo[id]);
+
+		mResidentBytes -= evictedBytes;
+		texture.residentMip = evictTo[id];
+		texture.pendingMip = evictTo[id];
+
+		requests.push_back({ id, StreamingAction::Evict, texture.residentMip, evictedBytes });
+		mStatistics.evictionsIssued++;
+	}
+
+	return true;
+}
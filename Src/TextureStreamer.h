@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+using StreamedTextureId = uint32_t;
+
+struct StreamedTextureDesc
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	// Size in bytes of every mip level, most detailed first.
+	std::vector<uint64_t> mipSizes;
+
+	// Number of the smallest mips that are loaded up front and never evicted.
+	uint32_t tailMipCount = 1;
+};
+
+enum class StreamingAction
+{
+	Load,	// Make mips [mip, previous resident mip) resident
+	Evict	// Drop mips [previous resident mip, mip)
+};
+
+struct StreamingRequest
+{
+	StreamedTextureId texture = 0;
+	StreamingAction action = StreamingAction::Load;
+
+	// Most detailed mip that is resident once the request has been carried out.
+	uint32_t mip = 0;
+
+	uint64_t bytes = 0;
+};
+
+struct StreamingStatistics
+{
+	uint64_t budgetBytes = 0;
+	uint64_t residentBytes = 0;
+	uint64_t pendingBytes = 0;
+	uint32_t loadsIssued = 0;
+	uint32_t evictionsIssued = 0;
+	// Loads that were wanted but did not fit in the budget this update.
+	uint32_t loadsDeferred = 0;
+};
+
+// Decides which mips of which textures should be resident under a byte budget.
+// It only does bookkeeping: the renderer reports desired mips every frame, update() returns
+// the loads and evictions to perform, and the loader reports completed loads back.
+// Residency always covers a contiguous range [residentMip, mipCount), the mip tail is never evicted.
+class TextureStreamer
+{
+public:
+	explicit TextureStreamer(uint64_t budgetBytes);
+
+	// Registers a texture, its mip tail is requested by the next update().
+	StreamedTextureId registerTexture(const StreamedTextureDesc& desc);
+
+	void setBudget(uint64_t budgetBytes) { mBudgetBytes = budgetBytes; }
+
+	// Frames a texture keeps its desired mip without being requested again before it decays to the tail.
+	void setRequestTimeout(uint32_t frames) { mRequestTimeout = frames; }
+
+	// Reports that a texture was used this frame and wants mip level `mip` (fractional values round down).
+	// Several requests in the same frame keep the most detailed one.
+	void requestMip(StreamedTextureId texture, float mip, uint64_t frame);
+
+	// Desired mip for a texture covering screenPixels pixels on screen, where uvArea is the
+	// fraction of the texture's UV space that is visible (1 for a full quad).
+	static float calculateDesiredMip(uint32_t width, uint32_t height, float screenPixels, float uvArea = 1.0f);
+
+	// Produces this frame's requests. Loads go one mip at a time, most starved textures first,
+	// and at most maxLoadBytes are issued per update. Space is made by evicting the least recently used mips.
+	std::vector<StreamingRequest> update(uint64_t frame, uint64_t maxLoadBytes = UINT64_MAX);
+
+	// Marks a load returned by update() as finished.
+	void completeLoad(StreamedTextureId texture, uint32_t mip);
+
+	uint32_t residentMip(StreamedTextureId texture) const { return mTextures[texture].residentMip; }
+	uint32_t desiredMip(StreamedTextureId texture) const { return mTextures[texture].desiredMip; }
+	uint32_t mipCount(StreamedTextureId texture) const { return static_cast<uint32_t>(mTextures[texture].mipSizes.size()); }
+
+	const StreamingStatistics& statistics() const { return mStatistics; }
+
+private:
+	struct TextureState
+	{
+		std::vector<uint64_t> mipSizes;
+		uint32_t tailMip = 0;
+		// mipCount while nothing is resident.
+		uint32_t residentMip = 0;
+		// Equal to residentMip while no load is in flight.
+		uint32_t pendingMip = 0;
+		uint32_t desiredMip = 0;
+		uint64_t lastUsedFrame = 0;
+	};
+
+	uint64_t mipRangeBytes(const TextureState& texture, uint32_t begin, uint32_t end) const;
+	bool makeRoom(uint64_t bytes, StreamedTextureId loading, uint64_t frame, std::vector<StreamingRequest>& requests);
+
+	std::vector<TextureState> mTextures;
+	uint64_t mBudgetBytes = 0;
+	uint64_t mResidentBytes = 0;
+	uint64_t mPendingBytes = 0;
+	uint32_t mRequestTimeout = 60;
+	StreamingStatistics mStatistics;
+};
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "Utils.h"
 #include <comdef.h>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -8,17 +9,9 @@
 #include <d3dcompiler.h>
 #include <vector>
 
-ComPtr<IDxcUtils> dxcUtils;
-ComPtr<IDxcCompiler3> dxcCompiler;
-
-DXException::DXException(HRESULT hr, const std::wstring& inFunctionName, const std::wstring& inFilename, int inLineNumber, const std::wstring& inErrorMessage) :
-	errorCode(hr),
-	functionName(inFunctionName),
-	filename(inFilename),
-	lineNumber(inLineNumber),
-	errorMessage(inErrorMessage)
-{
-}
+// DXCĶ̼߳乲ÿ̵߳һαʱԼ
+thread_local ComPtr<IDxcUtils> dxcUtils;
+thread_local ComPtr<IDxcCompiler3> dxcCompiler;
 
 std::wstring DXException::ToWString() const
 {
@@ -84,8 +77,53 @@ void Utils::createDXCCompiler()
 	DXCheck(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler)), L"DxcCreateInstance failed!");
 }
 
+std::wstring Utils::compilerVersion()
+{
+	if (!dxcCompiler)
+	{
+		createDXCCompiler();
+	}
+
+	std::wstring version = L"DXC";
+
+	ComPtr<IDxcVersionInfo> versionInfo;
+
+	if (SUCCEEDED(dxcCompiler.As(&versionInfo)))
+	{
+		uint32_t major = 0;
+		uint32_t minor = 0;
+		uint32_t flags = 0;
+		versionInfo->GetVersion(&major, &minor);
+		versionInfo->GetFlags(&flags);
+
+		version += L" " + std::to_wstring(major) + L"." + std::to_wstring(minor) + L" flags " + std::to_wstring(flags);
+	}
+
+	// ͬһ汾ŵĲͬύϣ
+	ComPtr<IDxcVersionInfo2> versionInfo2;
+
+	if (SUCCEEDED(dxcCompiler.As(&versionInfo2)))
+	{
+		uint32_t commitCount = 0;
+		char* commitHash = nullptr;
+
+		if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash)) && commitHash != nullptr)
+		{
+			version += L" commit " + std::to_wstring(commitCount) + L" " + std::wstring(commitHash, commitHash + std::strlen(commitHash));
+			CoTaskMemFree(commitHash);
+		}
+	}
+
+	return version;
+}
+
 void Utils::compileShader(const ShaderCompileParameters& parameters, ComPtr<IDxcBlob>& shader)
 {
+	if (!dxcCompiler)
+	{
+		createDXCCompiler();
+	}
+
 	uint32_t codePage = CP_UTF8;
 	uint32_t sourceSize = 0;
 
@@ -109,47 +147,26 @@ void Utils::compileShader(const ShaderCompileParameters& parameters, ComPtr<IDxc
 
 	ComPtr<IDxcResult> compileResult;
 
-	std::vector<LPCWSTR> arguments;
-
-	// -E for the entry point(eg. PSMain)
-	arguments.push_back(L"-E");
-	arguments.push_back(parameters.entryPoint.c_str());
-
-	// -T for the target profile(eg. ps_6_2)
-	arguments.push_back(L"-T");
-	arguments.push_back(parameters.targetProfile.c_str());
-
-	// -I for include directory
-	arguments.push_back(L"-I");
-	arguments.push_back(L"Assets/Shaders");
-
-	// Strip reflection data and pdbs(see later)
-	arguments.push_back(L"-Qstrip_debug");
-	arguments.push_back(L"-Qstrip_reflect");
+	// бShaderCacheֵʱõͬһ
+	auto argumentStrings = shaderCompileArguments(parameters);
 
-	arguments.push_back(DXC_ARG_WARNINGS_ARE_ERRORS);		// -WX
-
-#if defined(_DEBUG)
-	arguments.push_back(DXC_ARG_DEBUG);					// -Zi
-#endif
-	//arguments.push_back(DXC_ARG_PACK_MATRIX_ROW_MAJOR);		// -zP
+	std::vector<LPCWSTR> arguments;
 
-	for (const std::wstring& define : parameters.defines)
+	for (const auto& argument : argumentStrings)
 	{
-		arguments.push_back(L"-D");
-		arguments.push_back(define.c_str());
+		arguments.push_back(argument.c_str());
 	}
 	
 	// һĬϵIDxcIncludeHandlerָ-I(·ڹĿ¼)
 	// HLSLе#include﷨
-	IDxcIncludeHandler* includeHandler = nullptr;
+	ComPtr<IDxcIncludeHandler> includeHandler;
 	dxcUtils->CreateDefaultIncludeHandler(&includeHandler);
 
 	auto hr = dxcCompiler->Compile(
 		&shaderSourceBuffer,							// pSource
 		arguments.data(),							// pArguments
 		static_cast<uint32_t>(arguments.size()),	// argCount
-		includeHandler, IID_PPV_ARGS(&compileResult));
+		includeHandler.Get(), IID_PPV_ARGS(&compileResult));
 
 	// Error handling
 	ComPtr<IDxcBlobUtf8> errors;
@@ -167,6 +184,20 @@ void Utils::compileShader(const ShaderCompileParameters& parameters, ComPtr<IDxc
 	compileResult->GetResult(&shader);
 }
 
+void Utils::createShaderBlob(const std::vector<uint8_t>& dxil, ComPtr<IDxcBlob>& shader)
+{
+	if (!dxcUtils)
+	{
+		createDXCCompiler();
+	}
+
+	// CreateBlobḴݣIDxcBlobEncodingIDxcBlob
+	ComPtr<IDxcBlobEncoding> blob;
+	DXCheck(dxcUtils->CreateBlob(dxil.data(), static_cast<uint32_t>(dxil.size()), 0, &blob), L"IDxcUtils::CreateBlob failed!");
+
+	shader = blob;
+}
+
 ID3DBlob* Utils::loadShaderBinary(const std::string& path)
 {
 	std::ifstream shaderBinary(path, std::ios::binary);
@@ -11,9 +11,15 @@
 #include <locale>
 #include <codecvt>
 #include <unordered_map>
+#include <memory>
 #include <dxcapi.h>
 #include <wrl.h>
 #include "glm.h"
+#include "HeapAllocator.h"
+#include "GeometryPool.h"
+#include "D3D12Slim.h"
+#include "ShaderCache.h"
+#include "DXException.h"
 
 using namespace DirectX;
 using namespace Microsoft;
@@ -25,30 +31,11 @@ using namespace Microsoft::WRL;
 // ȡ㷨
 #define ROUND_UP(A, B) (static_cast<uint32_t>(((A) + ((B) - 1)) &~ (B - 1)))
 
-#define WIDE(x) L##x
-#define WIDE1(x) WIDE(x)
-#define FILE_NAME WIDE1(__FILE__)
-#define FUNCTION_NAME WIDE1(__FUNCTION__)
-#define ObjectName(object) L#object
 #define CPU_DESCRIPTOR_HEAP_START(descriptorHeap) descriptorHeap->GetCPUDescriptorHandleForHeapStart()
 #define GPU_DESCRIPTOR_HEAP_START(descriptorHeap) descriptorHeap->GetGPUDescriptorHandleForHeapStart()
 
-extern ComPtr<IDxcUtils> dxcUtils;
-extern ComPtr<IDxcCompiler3> dxcCompiler;
-extern const uint32_t NumFrameResources;
-
-inline void setD3D12DebugName(ID3D12Object * object, const std::wstring& name)
-{
-	object->SetName(name.c_str());
-}
-
-#define setD3D12DebugNameComPtr(object) setD3D12DebugName(object.Get(), ObjectName(object));
-
-inline void setD3D12DebugNameIndexd(ID3D12Object* object, const std::wstring& name, uint32_t index)
-{
-	auto fullName = name + L"[" + std::to_wstring(index) + L"]";
-	object->SetName(fullName.c_str());
-}
+extern thread_local ComPtr<IDxcUtils> dxcUtils;
+extern thread_local ComPtr<IDxcCompiler3> dxcCompiler;
 
 /******************************************************************************************
 Function:        TCHAR2STRING
@@ -97,16 +84,6 @@ inline std::wstring utf8_decode(const std::string& str)
 	return wstrTo;
 }
 
-struct ShaderCompileParameters
-{
-	ShaderCompileParameters() {}
-
-	std::wstring path;
-	std::wstring entryPoint;
-	std::wstring targetProfile;
-	std::vector<std::wstring> defines;
-};
-
 class Utils
 {
 public:
@@ -135,30 +112,14 @@ public:
 
 	static void createDXCCompiler();
 
+	// DXCİ汾źύϣΪɫֵһ
+	static std::wstring compilerVersion();
+
 	static void compileShader(const ShaderCompileParameters& parameters, ComPtr<IDxcBlob>& shader);
+	static void createShaderBlob(const std::vector<uint8_t>& dxil, ComPtr<IDxcBlob>& shader);
 	static ID3DBlob* loadShaderBinary(const std::string& path);
 };
 
-class DXException
-{
-public:
-	DXException() = default;
-	DXException(HRESULT hr, const std::wstring& inFunctionName, const std::wstring& inFilename, int inLineNumber, const std::wstring& inErrorMessage = L"");
-
-	std::wstring ToWString() const;
-	std::string ToString() const;
-
-	HRESULT errorCode = S_OK;
-	std::wstring functionName;
-	std::wstring filename;
-	int lineNumber = -1;
-	std::wstring errorMessage;
-};
-
-#define DXThrow(result, message) throw DXException(result, FUNCTION_NAME, FILE_NAME, __LINE__, message);
-
-#define DXCheck(result, message) if (FAILED(result)) { DXThrow(result, message); }
-
 // Defines a subrange of geometry in a MeshGeometry.  This is for when multiple
 // geometries are stored in one vertex and index buffer.  It provides the offsets
 // and data needed to draw a subset of geometry stores in the vertex and index
@@ -190,6 +151,12 @@ struct MeshGeometry
 	Microsoft::WRL::ComPtr<ID3D12Resource> vertexBufferUploader = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource> indexBufferUploader = nullptr;
 
+	// Range in the shared geometry pool, the buffers above then point at the pool's page buffers.
+	GeometryHandle geometry = InvalidGeometryHandle;
+
+	// Keeps the cached asset the pooled range belongs to alive while this mesh uses it.
+	std::shared_ptr<void> asset;
+
 	// Data about the buffers.
 	UINT vertexByteStride = 0;
 	UINT vertexBufferByteSize = 0;
@@ -248,8 +215,8 @@ struct Material
 	// Unique material name for lookup.
 	std::string name;
 
-	// Index into constant buffer corresponding to this material.
-	int32_t materialConstantBufferIndex = -1;
+	// GPU virtual address of this frame's material constants, allocated from the frame resource's dynamic constant buffer.
+	D3D12_GPU_VIRTUAL_ADDRESS constantBufferAddress = 0;
 
 	// Index into SRV heap for diffuse texture.
 	int32_t diffuseSRVHeapIndex = -1;
@@ -257,12 +224,6 @@ struct Material
 	// Index into SRV heap for normal texture.
 	int32_t normalSRVHeapIndex = -1;
 
-	// Dirty flag indicating the material has changed and we need to update the constant buffer.
-	// Because we have a material constant buffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify a material we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-	int32_t numFramesDirty = NumFrameResources;
-
 	// Material constant buffer data used for shading.
 	glm::vec4 diffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
 	glm::vec3 fresnelR0 = { 0.01f, 0.01f, 0.01f };
@@ -279,6 +240,25 @@ enum class TextureDimension : int
 	TextureArray
 };
 
+// GPU copy of a texture file, shared by every Texture loaded from the same content.
+struct TextureAsset
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
+
+	// Where the resource is placed, invalid for committed resources.
+	HeapAllocation allocation;
+
+	// SRV in the staging heap and its copy in the bindless range of the shader visible heap.
+	D3D12Lite::Descriptor stagingDescriptor;
+	D3D12Lite::Descriptor descriptor;
+
+	// Grey and grey + alpha textures are stored with one or two channels and expanded by the SRV.
+	uint32_t componentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+	// Id in the texture streamer, UINT32_MAX for textures that are loaded with all their mips.
+	uint32_t streamedTexture = UINT32_MAX;
+};
+
 struct Texture
 {
 	// Unique material name for lookup.
@@ -291,5 +271,6 @@ struct Texture
 	TextureDimension dimension;
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> uploadHeap = nullptr;
+
+	std::shared_ptr<TextureAsset> asset;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#ifdef _WIN32
 #include "targetver.h"
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 // Windows Header Files
@@ -9,3 +10,13 @@
 #include <malloc.h>
 #include <memory.h>
 #include <tchar.h>
+#else
+// The Tests project also builds on Linux, where the Windows types come from the DirectX-Headers adapter
+#include <climits>
+#include <wsl/winadapter.h>
+// IID_PPV_ARGS needs the interface IDs that MSVC takes from __declspec(uuid)
+#include <directx/d3d12.h>
+#include <dxguids/dxguids.h>
+#include <stdlib.h>
+#include <memory.h>
+#endif
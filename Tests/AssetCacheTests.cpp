@@ -0,0 +1,157 @@
+#include "Test.h"
+#include "AssetCache.h"
+
+#include <memory>
+#include <string>
+
+namespace
+{
+	struct FakeAsset
+	{
+		std::string content;
+	};
+
+	// Counts how often the cache asks for an asset to be created.
+	struct Loader
+	{
+		AssetCache<FakeAsset> cache;
+		uint32_t created = 0;
+
+		std::shared_ptr<FakeAsset> load(const std::filesystem::path& path, uint64_t parameters = 0)
+		{
+			return cache.load(path, parameters, [&]()
+			{
+				created++;
+				return std::make_shared<FakeAsset>(FakeAsset{ path.string() });
+			});
+		}
+	};
+}
+
+TEST_CASE(assetCacheNormalizesPaths)
+{
+	CHECK_EQUAL(normalizeAssetPath("Assets/Models/../Models/Cube.obj"), std::string("assets/models/cube.obj"));
+	CHECK_EQUAL(normalizeAssetPath("./assets/models/cube.obj"), std::string("assets/models/cube.obj"));
+	CHECK(hashAssetContent("cube", 4) == hashAssetContent("cube", 4));
+	CHECK(hashAssetContent("cube", 4) != hashAssetContent("cubf", 4));
+}
+
+TEST_CASE(assetCacheCountsHitsAndMisses)
+{
+	TestDirectory directory;
+	auto path = directory.write("models/cube.obj", "v 0 0 0");
+
+	Loader loader;
+
+	auto first = loader.load(path);
+	auto second = loader.load(directory.path() / "models" / ".." / "models" / "cube.obj");
+
+	CHECK(first != nullptr);
+	CHECK(first == second);
+	CHECK_EQUAL(loader.created, 1u);
+
+	auto statistics = loader.cache.statistics();
+
+	CHECK_EQUAL(statistics.misses, 1u);
+	CHECK_EQUAL(statistics.pathHits, 1u);
+	CHECK_EQUAL(statistics.contentHits, 0u);
+	CHECK_EQUAL(statistics.hits(), 1u);
+	CHECK_EQUAL(statistics.liveAssets, 1u);
+}
+
+TEST_CASE(assetCacheSharesEntriesByContent)
+{
+	TestDirectory directory;
+	auto cube = directory.write("cube.obj", "v 0 0 0");
+	auto copy = directory.write("copy/cube.obj", "v 0 0 0");
+	auto sphere = directory.write("sphere.obj", "v 1 1 1");
+
+	Loader loader;
+
+	auto first = loader.load(cube);
+	auto second = loader.load(copy);
+	auto third = loader.load(sphere);
+
+	// A different path with the same bytes is the same asset, different bytes are not
+	CHECK(first == second);
+	CHECK(first != third);
+	CHECK_EQUAL(loader.created, 2u);
+
+	// The copy's path is keyed now as well
+	CHECK(loader.load(copy) == first);
+
+	auto statistics = loader.cache.statistics();
+
+	CHECK_EQUAL(statistics.misses, 2u);
+	CHECK_EQUAL(statistics.contentHits, 1u);
+	CHECK_EQUAL(statistics.pathHits, 1u);
+
+	// Three paths, two assets
+	CHECK_EQUAL(statistics.liveAssets, 2u);
+}
+
+TEST_CASE(assetCacheKeepsParametersApart)
+{
+	TestDirectory directory;
+	auto path = directory.write("grass.png", "png");
+	auto copy = directory.write("grass2.png", "png");
+
+	Loader loader;
+
+	auto plain = loader.load(path);
+	auto compressed = loader.load(path, 1);
+
+	CHECK(plain != compressed);
+	CHECK(loader.load(path, 1) == compressed);
+
+	// Content sharing only happens between loads with the same parameters
+	CHECK(loader.load(copy, 1) == compressed);
+
+	auto other = loader.load(copy, 2);
+
+	CHECK(other != compressed);
+	CHECK_EQUAL(loader.created, 3u);
+	CHECK_EQUAL(loader.cache.statistics().liveAssets, 3u);
+}
+
+TEST_CASE(assetCacheCreatesReleasedAssetsAgain)
+{
+	TestDirectory directory;
+	auto path = directory.write("cube.obj", "v 0 0 0");
+
+	Loader loader;
+
+	auto asset = loader.load(path);
+	std::weak_ptr<FakeAsset> weak = asset;
+
+	// The cache only holds weak references
+	asset.reset();
+
+	CHECK(weak.expired());
+	CHECK_EQUAL(loader.cache.statistics().liveAssets, 0u);
+
+	asset = loader.load(path);
+
+	CHECK(asset != nullptr);
+	CHECK_EQUAL(loader.created, 2u);
+	CHECK_EQUAL(loader.cache.statistics().misses, 2u);
+
+	asset.reset();
+	loader.cache.prune();
+
+	CHECK_EQUAL(loader.cache.statistics().liveAssets, 0u);
+}
+
+TEST_CASE(assetCacheKeysUnreadableFilesByPath)
+{
+	TestDirectory directory;
+
+	Loader loader;
+
+	auto first = loader.load(directory.path() / "missing.obj");
+	auto second = loader.load(directory.path() / "MISSING.obj");
+
+	CHECK(first == second);
+	CHECK_EQUAL(loader.created, 1u);
+	CHECK_EQUAL(loader.cache.statistics().pathHits, 1u);
+}
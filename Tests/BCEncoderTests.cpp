@@ -0,0 +1,333 @@
+#include "Test.h"
+#include "BCEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	// Decoders written from the format specifications, independent of the encoder, so the tests
+	// check the bits that reach the GPU and not the encoder's own idea of what it wrote.
+
+	uint64_t readBits(const uint8_t* data, uint32_t& position, uint32_t count)
+	{
+		uint64_t value = 0;
+
+		for (uint32_t i = 0; i < count; i++, position++)
+		{
+			value |= static_cast<uint64_t>((data[position / 8] >> (position % 8)) & 1) << i;
+		}
+
+		return value;
+	}
+
+	// BC1 color block. BC3 always decodes it in 4 color mode, without the transparent index.
+	void decodeColorBlock(const uint8_t* block, bool allowTransparent, uint8_t texels[16][4])
+	{
+		uint32_t colors[2] = { static_cast<uint32_t>(block[0] | (block[1] << 8)), static_cast<uint32_t>(block[2] | (block[3] << 8)) };
+		int palette[4][4] = {};
+
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			auto r = (colors[i] >> 11) & 31;
+			auto g = (colors[i] >> 5) & 63;
+			auto b = colors[i] & 31;
+
+			palette[i][0] = static_cast<int>((r << 3) | (r >> 2));
+			palette[i][1] = static_cast<int>((g << 2) | (g >> 4));
+			palette[i][2] = static_cast<int>((b << 3) | (b >> 2));
+			palette[i][3] = 255;
+		}
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			if (colors[0] > colors[1] || !allowTransparent)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+
+		palette[2][3] = 255;
+		palette[3][3] = colors[0] > colors[1] || !allowTransparent ? 255 : 0;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			auto index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				texels[i][c] = static_cast<uint8_t>(palette[index][c]);
+			}
+		}
+	}
+
+	// BC4 block, the alpha half of BC3 and each half of BC5.
+	void decodeChannelBlock(const uint8_t* block, uint32_t channel, uint8_t texels[16][4])
+	{
+		int palette[8] = { block[0], block[1] };
+
+		if (block[0] > block[1])
+		{
+			for (int i = 1; i < 7; i++)
+			{
+				palette[i + 1] = ((7 - i) * palette[0] + i * palette[1] + 3) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+			{
+				palette[i + 1] = ((5 - i) * palette[0] + i * palette[1] + 2) / 5;
+			}
+
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint32_t position = 16;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			texels[i][channel] = static_cast<uint8_t>(palette[readBits(block, position, 3)]);
+		}
+	}
+
+	// BC7 mode 6: one subset, 7 bit RGBA endpoints with a p-bit each and 4 bit indices.
+	bool decodeBC7Block(const uint8_t* block, uint8_t texels[16][4])
+	{
+		uint32_t position = 0;
+
+		if (readBits(block, position, 7) != 1u << 6)
+		{
+			return false;
+		}
+
+		int endpoints[2][4];
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			for (uint32_t e = 0; e < 2; e++)
+			{
+				endpoints[e][c] = static_cast<int>(readBits(block, position, 7));
+			}
+		}
+
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			auto pBit = static_cast<int>(readBits(block, position, 1));
+
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				endpoints[e][c] = (endpoints[e][c] << 1) | pBit;
+			}
+		}
+
+		constexpr int Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			// The anchor texel drops the top bit of its index, which is always 0
+			auto index = static_cast<uint32_t>(readBits(block, position, i == 0 ? 3 : 4));
+
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				texels[i][c] = static_cast<uint8_t>(((64 - Weights[index]) * endpoints[0][c] + Weights[index] * endpoints[1][c] + 32) >> 6);
+			}
+		}
+
+		return true;
+	}
+
+	std::vector<uint8_t> decode(BCFormat format, const std::vector<uint8_t>& blocks, size_t blockRowPitch, uint32_t width, uint32_t height)
+	{
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4, 0);
+
+		for (uint32_t blockY = 0; blockY < height / 4; blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < width / 4; blockX++)
+			{
+				const auto* block = blocks.data() + blockY * blockRowPitch + blockX * getBCBlockSize(format);
+				uint8_t texels[16][4] = {};
+
+				switch (format)
+				{
+				case BCFormat::BC1:
+					decodeColorBlock(block, true, texels);
+					break;
+				case BCFormat::BC3:
+					decodeColorBlock(block + 8, false, texels);
+					decodeChannelBlock(block, 3, texels);
+					break;
+				case BCFormat::BC4:
+					decodeChannelBlock(block, 0, texels);
+					break;
+				case BCFormat::BC5:
+					decodeChannelBlock(block, 0, texels);
+					decodeChannelBlock(block + 8, 1, texels);
+					break;
+				case BCFormat::BC7:
+					CHECK(decodeBC7Block(block, texels));
+					break;
+				}
+
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					auto* texel = pixels.data() + ((blockY * 4 + i / 4) * width + blockX * 4 + i % 4) * 4;
+					std::copy(texels[i], texels[i] + 4, texel);
+				}
+			}
+		}
+
+		return pixels;
+	}
+
+	// A diagonal gradient with a little deterministic noise, the kind of content the formats are made for:
+	// the colors of a block lie close to one line.
+	std::vector<uint8_t> testImage(uint32_t width, uint32_t height, bool opaque)
+	{
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+		uint32_t seed = 12345;
+
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				auto* texel = pixels.data() + (y * width + x) * 4;
+
+				seed = seed * 1664525u + 1013904223u;
+				auto noise = static_cast<int>(seed >> 29);
+
+				auto t = static_cast<int>((x + y) * 255 / (width + height - 2));
+
+				texel[0] = static_cast<uint8_t>(t);
+				texel[1] = static_cast<uint8_t>(64 + t / 2);
+				texel[2] = static_cast<uint8_t>(200 - t / 2 + noise);
+				texel[3] = opaque ? 255 : static_cast<uint8_t>(255 - t / 2 - noise);
+			}
+		}
+
+		return pixels;
+	}
+
+	struct RoundTripError
+	{
+		double rmse = 0.0;
+		int maxError = 0;
+	};
+
+	RoundTripError compare(const std::vector<uint8_t>& source, const std::vector<uint8_t>& decoded, uint32_t channelCount)
+	{
+		RoundTripError result;
+		double sum = 0.0;
+		size_t count = 0;
+
+		for (size_t texel = 0; texel < source.size() / 4; texel++)
+		{
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				auto error = std::abs(static_cast<int>(source[texel * 4 + c]) - static_cast<int>(decoded[texel * 4 + c]));
+				sum += static_cast<double>(error) * error;
+				result.maxError = std::max(result.maxError, error);
+				count++;
+			}
+		}
+
+		result.rmse = std::sqrt(sum / count);
+
+		return result;
+	}
+
+	// Encodes, decodes with the reference decoder above and returns the error of what was decoded.
+	// The encoder's own report has to describe the same bits.
+	RoundTripError roundTrip(BCFormat format, bool opaque, uint32_t channelCount, size_t rowPadding = 0)
+	{
+		constexpr uint32_t Size = 32;
+
+		auto source = testImage(Size, Size, opaque);
+		auto rowPitch = getBCRowPitch(format, Size) + rowPadding;
+
+		std::vector<uint8_t> blocks(rowPitch * (Size / 4), 0);
+
+		auto report = encodeBC(source.data(), Size, Size, Size * 4, format, blocks.data(), rowPitch);
+		auto error = compare(source, decode(format, blocks, rowPitch, Size, Size), channelCount);
+
+		CHECK_EQUAL(report.blockCount, uint64_t{ (Size / 4) * (Size / 4) });
+		CHECK(std::abs(report.rmse - error.rmse) < 0.5);
+		CHECK(std::abs(static_cast<int>(report.maxError) - error.maxError) <= 1);
+
+		return error;
+	}
+}
+
+TEST_CASE(bcEncoderSizesBlocks)
+{
+	CHECK_EQUAL(getBCBlockSize(BCFormat::BC1), 8u);
+	CHECK_EQUAL(getBCBlockSize(BCFormat::BC3), 16u);
+	CHECK_EQUAL(getBCBlockSize(BCFormat::BC5), 16u);
+	CHECK_EQUAL(getBCBlockSize(BCFormat::BC7), 16u);
+
+	// Partial blocks round up
+	CHECK_EQUAL(getBCRowPitch(BCFormat::BC1, 10), size_t{ 24 });
+	CHECK_EQUAL(getBCImageSize(BCFormat::BC7, 10, 6), size_t{ 3 * 2 * 16 });
+}
+
+TEST_CASE(bc1RoundTripStaysWithinItsErrorBound)
+{
+	auto error = roundTrip(BCFormat::BC1, true, 4);
+
+	CHECK(error.rmse < 3.0);
+	CHECK(error.maxError <= 10);
+}
+
+TEST_CASE(bc3RoundTripStaysWithinItsErrorBound)
+{
+	auto error = roundTrip(BCFormat::BC3, false, 4);
+
+	CHECK(error.rmse < 3.0);
+	CHECK(error.maxError <= 10);
+}
+
+TEST_CASE(bc5RoundTripStaysWithinItsErrorBound)
+{
+	auto error = roundTrip(BCFormat::BC5, true, 2);
+
+	CHECK(error.rmse < 1.5);
+	CHECK(error.maxError <= 4);
+}
+
+TEST_CASE(bc7Mode6RoundTripStaysWithinItsErrorBound)
+{
+	// Block rows further apart than they need to be, as in a staged texture footprint
+	auto error = roundTrip(BCFormat::BC7, false, 4, 24);
+
+	CHECK(error.rmse < 2.0);
+	CHECK(error.maxError <= 6);
+}
+
+TEST_CASE(bcEncoderKeepsBC1OpaqueAndDetectsTransparency)
+{
+	auto opaque = testImage(8, 8, true);
+	auto transparent = testImage(8, 8, false);
+
+	CHECK(!hasTransparency(opaque.data(), 8, 8, 8 * 4));
+	CHECK(hasTransparency(transparent.data(), 8, 8, 8 * 4));
+
+	// Opaque content never selects BC1's transparent black
+	std::vector<uint8_t> blocks(getBCImageSize(BCFormat::BC1, 8, 8));
+	encodeBC(opaque.data(), 8, 8, 8 * 4, BCFormat::BC1, blocks.data(), getBCRowPitch(BCFormat::BC1, 8));
+
+	auto decoded = decode(BCFormat::BC1, blocks, getBCRowPitch(BCFormat::BC1, 8), 8, 8);
+
+	for (size_t texel = 0; texel < decoded.size() / 4; texel++)
+	{
+		CHECK_EQUAL(decoded[texel * 4 + 3], 255);
+	}
+}
@@ -0,0 +1,122 @@
+#include "Test.h"
+#include "DeferredReleaseQueue.h"
+#include "FakeFence.h"
+
+#include <memory>
+#include <vector>
+
+TEST_CASE(deferredReleaseQueueKeepsObjectsUntilTheirFenceCompletes)
+{
+	FakeFence fence;
+	DeferredReleaseQueue queue;
+
+	// Stands in for a ComPtr, the queue holds one reference
+	auto first = std::make_shared<int>(1);
+	auto second = std::make_shared<int>(2);
+
+	auto firstFence = fence.signal();
+	queue.retire(first, firstFence);
+	queue.retire(second, fence.signal());
+
+	CHECK_EQUAL(first.use_count(), 2);
+	CHECK_EQUAL(queue.releaseCompleted(fence.completed), 0u);
+
+	fence.complete(firstFence);
+	CHECK_EQUAL(queue.releaseCompleted(fence.completed), 1u);
+	CHECK_EQUAL(first.use_count(), 1);
+	CHECK_EQUAL(second.use_count(), 2);
+
+	fence.complete(fence.signaled);
+	CHECK_EQUAL(queue.releaseCompleted(fence.completed), 1u);
+	CHECK_EQUAL(second.use_count(), 1);
+	CHECK_EQUAL(queue.pendingCount(), 0u);
+}
+
+TEST_CASE(deferredReleaseQueueReleasesInOrder)
+{
+	FakeFence fence;
+	DeferredReleaseQueue queue;
+	std::vector<int> released;
+
+	// Two on the same fence value, then one each on later ones
+	auto shared = fence.signal();
+	queue.defer([&released]() { released.push_back(0); }, shared);
+	queue.defer([&released]() { released.push_back(1); }, shared);
+	queue.defer([&released]() { released.push_back(2); }, fence.signal());
+	queue.defer([&released]() { released.push_back(3); }, fence.signal());
+
+	// Completing a later value releases everything up to it
+	fence.complete(2);
+	CHECK_EQUAL(queue.releaseCompleted(fence.completed), 3u);
+
+	std::vector<int> expected = { 0, 1, 2 };
+	CHECK(released == expected);
+
+	fence.complete(3);
+	queue.releaseCompleted(fence.completed);
+
+	expected.push_back(3);
+	CHECK(released == expected);
+}
+
+TEST_CASE(deferredReleaseQueueCallsEachCallbackOnce)
+{
+	FakeFence fence;
+	DeferredReleaseQueue queue;
+	int calls = 0;
+
+	queue.defer([&calls]() { calls++; }, fence.signal());
+
+	fence.complete(1);
+	queue.releaseCompleted(fence.completed);
+	queue.releaseCompleted(fence.completed);
+	queue.releaseAll();
+
+	CHECK_EQUAL(calls, 1);
+
+	// Moved into the queue, so a copy left behind does not count
+	auto callback = [&calls]() { calls++; };
+	queue.defer(callback, fence.signal());
+	queue.releaseAll();
+
+	CHECK_EQUAL(calls, 2);
+}
+
+TEST_CASE(deferredReleaseQueueReleaseAllIgnoresTheFence)
+{
+	FakeFence fence;
+	int calls = 0;
+	auto object = std::make_shared<int>(1);
+
+	{
+		DeferredReleaseQueue queue;
+
+		queue.retire(object, fence.signal());
+		queue.defer([&calls]() { calls++; }, fence.signal());
+		queue.releaseAll();
+
+		CHECK_EQUAL(calls, 1);
+		CHECK_EQUAL(object.use_count(), 1);
+
+		auto statistics = queue.statistics();
+		CHECK_EQUAL(statistics.retiredCount, 2u);
+		CHECK_EQUAL(statistics.releasedCount, 2u);
+		CHECK_EQUAL(statistics.pendingCount, 0u);
+		CHECK_EQUAL(statistics.highWaterMark, 2u);
+
+		// Whatever is still queued goes with the queue
+		queue.retire(object, fence.signal());
+		queue.defer([&calls]() { calls++; }, fence.signal());
+	}
+
+	CHECK_EQUAL(calls, 2);
+	CHECK_EQUAL(object.use_count(), 1);
+}
+
+DEATH_TEST(deferredReleaseQueueRejectsDecreasingFenceValues)
+{
+	DeferredReleaseQueue queue;
+
+	queue.defer([]() {}, 2);
+	queue.defer([]() {}, 1);
+}
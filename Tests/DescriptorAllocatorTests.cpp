@@ -0,0 +1,118 @@
+#include "pch.h"
+#include "Test.h"
+#include "DescriptorAllocator.h"
+#include "FakeFence.h"
+
+#include <algorithm>
+#include <vector>
+
+TEST_CASE(descriptorFreeListReusesTheLastFreedIndex)
+{
+	// A staging heap: indices come back right away
+	DescriptorFreeList freeList(0, 4);
+
+	std::vector<uint32_t> indices;
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		indices.push_back(freeList.allocate());
+		CHECK_EQUAL(indices.back(), i);
+	}
+
+	CHECK_EQUAL(freeList.allocate(), InvalidDescriptorIndex);
+
+	freeList.free(indices[1]);
+	freeList.free(indices[3]);
+
+	CHECK_EQUAL(freeList.allocate(), 3u);
+	CHECK_EQUAL(freeList.allocate(), 1u);
+	CHECK_EQUAL(freeList.allocate(), InvalidDescriptorIndex);
+
+	auto statistics = freeList.statistics();
+	CHECK_EQUAL(statistics.capacity, 4u);
+	CHECK_EQUAL(statistics.allocatedCount, 4u);
+	CHECK_EQUAL(statistics.highWaterMark, 4u);
+}
+
+TEST_CASE(descriptorFreeListStaysInsideTheBindlessRange)
+{
+	// Slots [0, 2) are reserved, the bindless range is [2, 5)
+	DescriptorFreeList freeList(2, 3);
+
+	CHECK_EQUAL(freeList.first(), 2u);
+	CHECK_EQUAL(freeList.count(), 3u);
+
+	CHECK_EQUAL(freeList.allocate(), 2u);
+	CHECK_EQUAL(freeList.allocate(), 3u);
+	CHECK_EQUAL(freeList.allocate(), 4u);
+	CHECK_EQUAL(freeList.allocate(), InvalidDescriptorIndex);
+
+	freeList.free(2);
+	CHECK_EQUAL(freeList.allocate(), 2u);
+}
+
+TEST_CASE(descriptorFreeListDefersReuseUntilTheFenceCompletes)
+{
+	FakeFence fence;
+	DescriptorFreeList freeList(0, 2);
+
+	auto first = freeList.allocate();
+	auto second = freeList.allocate();
+
+	freeList.freeDeferred(first, fence.signal());
+	freeList.freeDeferred(second, fence.signal());
+
+	// Both still count as allocated while the GPU may read them
+	CHECK_EQUAL(freeList.allocate(), InvalidDescriptorIndex);
+	CHECK_EQUAL(freeList.statistics().allocatedCount, 2u);
+	CHECK_EQUAL(freeList.statistics().pendingFreeCount, 2u);
+
+	fence.complete(1);
+	freeList.releaseCompleted(fence.completed);
+
+	CHECK_EQUAL(freeList.statistics().pendingFreeCount, 1u);
+	CHECK_EQUAL(freeList.allocate(), first);
+	CHECK_EQUAL(freeList.allocate(), InvalidDescriptorIndex);
+
+	fence.complete(2);
+	freeList.releaseCompleted(fence.completed);
+
+	CHECK_EQUAL(freeList.allocate(), second);
+
+	auto statistics = freeList.statistics();
+	CHECK_EQUAL(statistics.allocatedCount, 2u);
+	CHECK_EQUAL(statistics.pendingFreeCount, 0u);
+	CHECK_EQUAL(statistics.highWaterMark, 2u);
+}
+
+TEST_CASE(descriptorLinearAllocatorResetsOnlyTheBegunFrame)
+{
+	// Three frames of four slots each, after a persistent range of ten
+	DescriptorLinearAllocator allocator(10, 12, 3);
+
+	CHECK_EQUAL(allocator.frameCount(), 3u);
+	CHECK_EQUAL(allocator.segmentSize(), 4u);
+
+	allocator.beginFrame(0);
+	CHECK_EQUAL(allocator.allocate(3), 10u);
+	CHECK_EQUAL(allocator.allocate(2), InvalidDescriptorIndex);
+	CHECK_EQUAL(allocator.allocate(1), 13u);
+
+	allocator.beginFrame(1);
+	CHECK_EQUAL(allocator.allocate(2), 14u);
+	CHECK_EQUAL(allocator.statistics().allocatedCount, 2u);
+
+	allocator.beginFrame(2);
+	CHECK_EQUAL(allocator.allocate(4), 18u);
+	CHECK_EQUAL(allocator.allocate(1), InvalidDescriptorIndex);
+
+	// Frame 0 comes around again and starts from the beginning of its segment
+	allocator.beginFrame(0);
+	CHECK_EQUAL(allocator.statistics().allocatedCount, 0u);
+	CHECK_EQUAL(allocator.allocate(4), 10u);
+
+	auto statistics = allocator.statistics();
+	CHECK_EQUAL(statistics.capacity, 4u);
+	CHECK_EQUAL(statistics.allocatedCount, 4u);
+	CHECK_EQUAL(statistics.highWaterMark, 4u);
+}
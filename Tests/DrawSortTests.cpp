@@ -0,0 +1,145 @@
+#include "Test.h"
+#include "DrawSort.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+	std::vector<uint32_t> sortedOrder(RadixSorter& sorter, const std::vector<uint64_t>& keys)
+	{
+		auto order = sorter.sort(keys.data(), static_cast<uint32_t>(keys.size()));
+
+		return std::vector<uint32_t>(order, order + keys.size());
+	}
+
+	std::vector<uint32_t> stableSortedOrder(const std::vector<uint64_t>& keys)
+	{
+		std::vector<uint32_t> order(keys.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+		return order;
+	}
+}
+
+TEST_CASE(drawSortQuantizesDepthInOrder)
+{
+	CHECK_EQUAL(quantizeDrawSortDepth(0.0f), 0u);
+	CHECK_EQUAL(quantizeDrawSortDepth(-1.0f), 0u);
+
+	auto previous = 0u;
+
+	for (auto depth : { 0.01f, 0.1f, 1.0f, 1.5f, 10.0f, 100.0f, 1000.0f })
+	{
+		auto quantized = quantizeDrawSortDepth(depth);
+
+		CHECK(quantized > previous);
+		CHECK(quantized < (1u << DrawSortDepthBits));
+
+		previous = quantized;
+	}
+}
+
+TEST_CASE(opaqueDrawSortKeyOrdersLayerPipelineMaterialDepth)
+{
+	auto key = [](uint32_t layer, uint32_t pipeline, uint32_t material, uint32_t depth)
+	{
+		return makeOpaqueDrawSortKey(layer, pipeline, material, 0, depth);
+	};
+
+	constexpr uint32_t Max = 0xFFFFFFFF;
+
+	// Each field wins over every field after it, even when those are at their largest
+	CHECK(key(0, Max, Max, Max) < key(1, 0, 0, 0));
+	CHECK(key(1, 0, Max, Max) < key(1, 1, 0, 0));
+	CHECK(key(1, 1, 0, Max) < key(1, 1, 1, 0));
+
+	// Front to back inside a state group
+	auto near = quantizeDrawSortDepth(1.0f);
+	auto far = quantizeDrawSortDepth(50.0f);
+
+	CHECK(key(1, 1, 1, near) < key(1, 1, 1, far));
+
+	// Fields are truncated to their bits and do not spill into their neighbours
+	CHECK_EQUAL(key(1, 1u << DrawSortPipelineBits, 0, 0), key(1, 0, 0, 0));
+	CHECK_EQUAL(makeOpaqueDrawSortKey(0, 0, 0, 0, Max) >> DrawSortDepthBits, uint64_t{ 0 });
+}
+
+TEST_CASE(transparentDrawSortKeyOrdersBackToFront)
+{
+	auto near = quantizeDrawSortDepth(1.0f);
+	auto far = quantizeDrawSortDepth(50.0f);
+
+	// Depth comes before state and sorts the far item first
+	CHECK(makeTransparentDrawSortKey(3, 5, 5, 5, far) < makeTransparentDrawSortKey(3, 0, 0, 0, near));
+
+	// State only decides at equal depth
+	CHECK(makeTransparentDrawSortKey(3, 0, 9, 0, near) < makeTransparentDrawSortKey(3, 1, 0, 0, near));
+
+	// The layer still comes first
+	CHECK(makeTransparentDrawSortKey(2, 0, 0, 0, near) < makeTransparentDrawSortKey(3, 0, 0, 0, far));
+}
+
+TEST_CASE(radixSorterMatchesStableSortOnRandomKeys)
+{
+	std::mt19937_64 random(42);
+	RadixSorter sorter;
+
+	// Full width keys, draw shaped keys with many duplicates, and counts around the scratch size
+	for (uint32_t count : { 0u, 1u, 2u, 255u, 1000u, 5000u, 300u })
+	{
+		std::vector<uint64_t> wide(count);
+		std::vector<uint64_t> draws(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			wide[i] = random();
+
+			auto value = random();
+			draws[i] = makeOpaqueDrawSortKey(value & 3, (value >> 2) & 3, (value >> 4) & 7, (value >> 7) & 7, (value >> 10) & 15);
+		}
+
+		CHECK(sortedOrder(sorter, wide) == stableSortedOrder(wide));
+
+		// Equal keys keep their submission order
+		CHECK(sortedOrder(sorter, draws) == stableSortedOrder(draws));
+	}
+}
+
+TEST_CASE(radixSorterHandlesKeysThatShareEveryDigit)
+{
+	RadixSorter sorter;
+	std::vector<uint64_t> keys(16, 0x0123456789ABCDEFull);
+
+	// Every pass is skipped and the order is the identity
+	CHECK(sortedOrder(sorter, keys) == stableSortedOrder(keys));
+
+	// Keys differing in the top digit only
+	keys[3] = 0xFF23456789ABCDEFull;
+	keys[7] = 0x0023456789ABCDEFull;
+
+	auto order = sortedOrder(sorter, keys);
+
+	CHECK_EQUAL(order.front(), 7u);
+	CHECK_EQUAL(order.back(), 3u);
+	CHECK(order == stableSortedOrder(keys));
+}
+
+// Prints the radix sort and std::sort times from 1K to 1M draw keys.
+BENCHMARK(drawSortBenchmark)
+{
+	auto results = benchmarkDrawSort();
+
+	for (const auto& result : results)
+	{
+		std::printf("  %7u keys, radix sort %.3f ms, std::sort %.3f ms, %.2fx\n", result.count,
+					result.radixSortMilliseconds, result.stdSortMilliseconds,
+					result.stdSortMilliseconds / result.radixSortMilliseconds);
+	}
+
+	CHECK_EQUAL(results.size(), size_t{ 4 });
+}
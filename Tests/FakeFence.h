@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// Stands in for an ID3D12Fence: the CPU signals values in order and the GPU completes them later.
+struct FakeFence
+{
+	uint64_t signaled = 0;
+	uint64_t completed = 0;
+
+	uint64_t signal() { return ++signaled; }
+	void complete(uint64_t value) { completed = value; }
+};
@@ -0,0 +1,138 @@
+#include "Test.h"
+#include "FencedRecycler.h"
+#include "FakeFence.h"
+
+#include <vector>
+
+namespace
+{
+	// Items are ids handed out by create(), so the test sees which item came back.
+	struct IdSource
+	{
+		int next = 0;
+
+		int operator()() { return next++; }
+	};
+}
+
+TEST_CASE(fencedRecyclerCreatesUntilAFenceCompletes)
+{
+	FakeFence fence;
+	FencedRecycler<int> recycler;
+	IdSource ids;
+
+	// Three frames in flight, none completed: every frame needs a new item
+	for (int frame = 0; frame < 3; frame++)
+	{
+		auto item = recycler.acquire(fence.completed, ids);
+		CHECK_EQUAL(item, frame);
+		recycler.retire(item, fence.signal());
+	}
+
+	CHECK_EQUAL(recycler.statistics().createdCount, 3u);
+	CHECK_EQUAL(recycler.statistics().retiredCount, 3u);
+
+	// The first frame completes, its item is the only one that can come back
+	fence.complete(1);
+	CHECK_EQUAL(recycler.acquire(fence.completed, ids), 0);
+	CHECK_EQUAL(recycler.acquire(fence.completed, ids), 3);
+
+	auto statistics = recycler.statistics();
+	CHECK_EQUAL(statistics.createdCount, 4u);
+	CHECK_EQUAL(statistics.recycledCount, 1u);
+	CHECK_EQUAL(statistics.inUseCount, 2u);
+	CHECK_EQUAL(statistics.retiredCount, 2u);
+}
+
+TEST_CASE(fencedRecyclerReturnsItemsOldestFirst)
+{
+	FakeFence fence;
+	FencedRecycler<int> recycler;
+	IdSource ids;
+
+	std::vector<int> items;
+
+	for (int i = 0; i < 4; i++)
+	{
+		items.push_back(recycler.acquire(fence.completed, ids));
+	}
+
+	// Two items retired on the same fence value, two on later ones
+	auto first = fence.signal();
+	recycler.retire(items[2], first);
+	recycler.retire(items[0], first);
+	recycler.retire(items[3], fence.signal());
+	recycler.retire(items[1], fence.signal());
+
+	fence.complete(fence.signaled);
+
+	CHECK_EQUAL(recycler.acquire(fence.completed, ids), 2);
+	CHECK_EQUAL(recycler.acquire(fence.completed, ids), 0);
+	CHECK_EQUAL(recycler.acquire(fence.completed, ids), 3);
+	CHECK_EQUAL(recycler.acquire(fence.completed, ids), 1);
+	CHECK_EQUAL(recycler.statistics().createdCount, 4u);
+}
+
+TEST_CASE(fencedRecyclerSteadyStateStopsCreating)
+{
+	// Frames submitted with up to two in flight: the pool settles at three items
+	FakeFence fence;
+	FencedRecycler<int> recycler;
+	IdSource ids;
+
+	for (int frame = 0; frame < 100; frame++)
+	{
+		if (fence.signaled >= 2)
+		{
+			fence.complete(fence.signaled - 2);
+		}
+
+		auto item = recycler.acquire(fence.completed, ids);
+		recycler.retire(item, fence.signal());
+	}
+
+	auto statistics = recycler.statistics();
+	CHECK_EQUAL(statistics.createdCount, 3u);
+	CHECK_EQUAL(statistics.recycledCount, 97u);
+	CHECK_EQUAL(statistics.highWaterMark, 1u);
+	CHECK_EQUAL(statistics.inUseCount, 0u);
+}
+
+TEST_CASE(fencedRecyclerStatisticsCombinePeaks)
+{
+	FakeFence fence;
+	FencedRecycler<int> first;
+	FencedRecycler<int> second;
+	IdSource ids;
+
+	// Peaks of 3 and 2 at different times
+	std::vector<int> items;
+
+	for (int i = 0; i < 3; i++)
+	{
+		items.push_back(first.acquire(fence.completed, ids));
+	}
+
+	for (auto item : items)
+	{
+		first.retire(item, fence.signal());
+	}
+
+	items.clear();
+
+	for (int i = 0; i < 2; i++)
+	{
+		items.push_back(second.acquire(fence.completed, ids));
+	}
+
+	second.retire(items[0], fence.signal());
+
+	FencedRecyclerStatistics statistics;
+	statistics.add(first.statistics());
+	statistics.add(second.statistics());
+
+	CHECK_EQUAL(statistics.createdCount, 5u);
+	CHECK_EQUAL(statistics.inUseCount, 1u);
+	CHECK_EQUAL(statistics.retiredCount, 4u);
+	CHECK_EQUAL(statistics.highWaterMark, 3u);
+}
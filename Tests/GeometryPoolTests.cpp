@@ -0,0 +1,165 @@
+#include "Test.h"
+#include "GeometryPool.h"
+
+#include <cmath>
+#include <vector>
+
+TEST_CASE(rangeAllocatorCoalescesFreedRanges)
+{
+	RangeAllocator allocator(100);
+
+	auto a = allocator.allocate(10);
+	auto b = allocator.allocate(10);
+	auto c = allocator.allocate(10);
+
+	CHECK_EQUAL(a, 0u);
+	CHECK_EQUAL(b, 10u);
+	CHECK_EQUAL(c, 20u);
+	CHECK_EQUAL(allocator.usedSize(), 30u);
+	CHECK_EQUAL(allocator.freeRangeCount(), size_t{ 1 });
+
+	// A hole between two live ranges stays on its own
+	allocator.free(b, 10);
+
+	CHECK_EQUAL(allocator.freeRangeCount(), size_t{ 2 });
+	CHECK_EQUAL(allocator.largestFreeRange(), 70u);
+
+	// Merges with the free range after it
+	allocator.free(a, 10);
+
+	CHECK_EQUAL(allocator.freeRangeCount(), size_t{ 2 });
+	CHECK_EQUAL(allocator.allocate(20), 0u);
+
+	allocator.free(0, 20);
+
+	// Merges with the ranges on both sides
+	allocator.free(c, 10);
+
+	CHECK_EQUAL(allocator.freeRangeCount(), size_t{ 1 });
+	CHECK_EQUAL(allocator.largestFreeRange(), 100u);
+	CHECK_EQUAL(allocator.usedSize(), 0u);
+}
+
+TEST_CASE(rangeAllocatorAlignsToAnyStride)
+{
+	RangeAllocator allocator(100);
+
+	CHECK_EQUAL(allocator.allocate(5), 0u);
+
+	// Vertex strides are not powers of two, the padding in front stays free
+	CHECK_EQUAL(allocator.allocate(12, 12), 12u);
+	CHECK_EQUAL(allocator.freeRangeCount(), size_t{ 2 });
+
+	// First fit takes the padding when it is large enough
+	CHECK_EQUAL(allocator.allocate(7), 5u);
+	CHECK_EQUAL(allocator.freeRangeCount(), size_t{ 1 });
+
+	CHECK_EQUAL(allocator.allocate(20, 20), 40u);
+	CHECK_EQUAL(allocator.usedSize(), 44u);
+}
+
+TEST_CASE(rangeAllocatorFailsWhenNoRangeFits)
+{
+	RangeAllocator allocator(64);
+
+	CHECK_EQUAL(allocator.allocate(0), RangeAllocator::InvalidOffset);
+	CHECK_EQUAL(allocator.allocate(65), RangeAllocator::InvalidOffset);
+
+	allocator.allocate(4);
+	auto a = allocator.allocate(30);
+	allocator.allocate(30);
+
+	allocator.free(a, 30);
+
+	// 30 bytes are free at offset 4 but not the alignment padding on top of them
+	CHECK_EQUAL(allocator.allocate(30, 8), RangeAllocator::InvalidOffset);
+	CHECK_EQUAL(allocator.allocate(26, 8), 8u);
+	CHECK_EQUAL(allocator.freeRangeCount(), size_t{ 1 });
+}
+
+TEST_CASE(geometryPoolDefragmentMapsOldToNewOffsets)
+{
+	GeometryPool pool(1000, 100);
+
+	auto a = pool.allocate(10, 12, 6);
+	auto b = pool.allocate(5, 20, 3);
+	auto c = pool.allocate(4, 12, 6);
+
+	REQUIRE(a != InvalidGeometryHandle && b != InvalidGeometryHandle && c != InvalidGeometryHandle);
+	CHECK_EQUAL(pool.allocation(b).vertexOffset, 120u);
+	CHECK_EQUAL(pool.allocation(b).startIndexLocation, 6u);
+
+	// The first multiple of 12 after b
+	CHECK_EQUAL(pool.allocation(c).vertexOffset, 228u);
+	CHECK_EQUAL(pool.allocation(c).baseVertexLocation(), 19u);
+	CHECK_EQUAL(pool.allocation(c).startIndexLocation, 9u);
+
+	pool.free(a);
+
+	auto moves = pool.defragment(0);
+
+	REQUIRE(moves.size() == 2);
+
+	for (const auto& move : moves)
+	{
+		// Every move describes a live range and the handle already points at the new place
+		CHECK(move.handle == b || move.handle == c);
+		CHECK_EQUAL(pool.allocation(move.handle).vertexOffset, move.after.vertexOffset);
+		CHECK_EQUAL(pool.allocation(move.handle).startIndexLocation, move.after.startIndexLocation);
+		CHECK_EQUAL(move.before.vertexSize, move.after.vertexSize);
+		CHECK_EQUAL(move.before.indexCount, move.after.indexCount);
+
+		if (move.handle == b)
+		{
+			CHECK_EQUAL(move.before.vertexOffset, 120u);
+			CHECK_EQUAL(move.after.vertexOffset, 0u);
+			CHECK_EQUAL(move.before.startIndexLocation, 6u);
+			CHECK_EQUAL(move.after.startIndexLocation, 0u);
+		}
+		else
+		{
+			// Packed behind b, at its stride
+			CHECK_EQUAL(move.before.vertexOffset, 228u);
+			CHECK_EQUAL(move.after.vertexOffset, 108u);
+			CHECK_EQUAL(move.after.baseVertexLocation(), 9u);
+			CHECK_EQUAL(move.before.startIndexLocation, 9u);
+			CHECK_EQUAL(move.after.startIndexLocation, 3u);
+		}
+	}
+
+	auto statistics = pool.statistics();
+
+	CHECK_EQUAL(statistics.allocationCount, 2u);
+	CHECK_EQUAL(statistics.vertexUsed, 148u);
+	CHECK_EQUAL(statistics.indexUsed, 9u);
+
+	// Only the stride padding between b and c is left apart from the free tail
+	CHECK(std::abs(statistics.vertexFragmentation - (1.0 - 844.0 / 852.0)) < 1e-9);
+}
+
+TEST_CASE(geometryPoolGivesLargeMeshesTheirOwnPage)
+{
+	GeometryPool pool(1000, 100);
+
+	auto small = pool.allocate(10, 12, 6);
+	auto large = pool.allocate(200, 12, 300);
+
+	CHECK_EQUAL(pool.pageCount(), 2u);
+	CHECK_EQUAL(pool.allocation(small).page, 0u);
+	CHECK_EQUAL(pool.allocation(large).page, 1u);
+	CHECK(pool.vertexPageSize(1) >= 2400u);
+	CHECK(pool.indexPageCount(1) >= 300u);
+
+	// Meshes without vertices only take index space
+	auto dynamic = pool.allocate(0, 0, 12);
+
+	CHECK_EQUAL(pool.allocation(dynamic).page, 0u);
+	CHECK_EQUAL(pool.allocation(dynamic).vertexSize, 0u);
+	CHECK_EQUAL(pool.allocation(dynamic).baseVertexLocation(), 0u);
+
+	// Freed handles are reused
+	pool.free(small);
+
+	CHECK_EQUAL(pool.allocate(1, 12, 3), small);
+	CHECK_EQUAL(pool.statistics().allocationCount, 3u);
+}
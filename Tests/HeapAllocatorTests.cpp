@@ -0,0 +1,340 @@
+#include "Test.h"
+#include "HeapAllocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr uint64_t KB = 1024;
+	constexpr uint64_t MB = 1024 * 1024;
+
+	bool overlaps(const TLSFAllocation& a, const TLSFAllocation& b)
+	{
+		return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+	}
+
+	// Random sizes and alignments in the shape of textures and buffers: mostly small, some large.
+	struct ChurnGenerator
+	{
+		std::mt19937 random{ 11 };
+
+		uint64_t size()
+		{
+			auto kind = random() % 8;
+			return kind < 5 ? 256 + random() % (64 * KB) : kind < 7 ? 64 * KB + random() % (1 * MB) : 1 * MB + random() % (4 * MB);
+		}
+
+		uint64_t alignment()
+		{
+			const uint64_t alignments[] = { 256, 4 * KB, 64 * KB };
+			return alignments[random() % 3];
+		}
+	};
+}
+
+TEST_CASE(tlsfAllocatorAllocatesAndMergesBack)
+{
+	TLSFAllocator allocator(1 * MB);
+
+	auto a = allocator.allocate(1000);
+	auto b = allocator.allocate(256);
+	auto c = allocator.allocate(4 * KB);
+
+	REQUIRE(a.valid() && b.valid() && c.valid());
+
+	// Sizes round up to 256
+	CHECK_EQUAL(a.size, 1024u);
+	CHECK_EQUAL(a.offset, 0u);
+	CHECK_EQUAL(b.offset, 1024u);
+	CHECK_EQUAL(c.offset, 1280u);
+
+	auto statistics = allocator.statistics();
+	CHECK_EQUAL(statistics.allocationCount, 3u);
+	CHECK_EQUAL(statistics.usedBytes, 1024u + 256u + 4096u);
+	CHECK_EQUAL(statistics.freeBlockCount, 1u);
+
+	// Freeing a and c leaves two holes, b joins them all back into one block
+	allocator.free(a);
+	allocator.free(c);
+	CHECK_EQUAL(allocator.statistics().freeBlockCount, 2u);
+
+	allocator.free(b);
+
+	statistics = allocator.statistics();
+	CHECK_EQUAL(statistics.allocationCount, 0u);
+	CHECK_EQUAL(statistics.usedBytes, 0u);
+	CHECK_EQUAL(statistics.freeBlockCount, 1u);
+	CHECK_EQUAL(statistics.largestFreeBlock, 1 * MB);
+	CHECK_EQUAL(statistics.fragmentation(), 0.0);
+}
+
+TEST_CASE(tlsfAllocatorHonoursAlignment)
+{
+	TLSFAllocator allocator(4 * MB);
+
+	auto small = allocator.allocate(256);
+	auto aligned = allocator.allocate(64 * KB, 64 * KB);
+
+	REQUIRE(aligned.valid());
+	CHECK_EQUAL(aligned.offset % (64 * KB), 0u);
+	CHECK_EQUAL(aligned.offset, 64 * KB);
+
+	// The padding in front of the aligned block stays usable
+	auto padding = allocator.allocate(32 * KB);
+
+	REQUIRE(padding.valid());
+	CHECK_EQUAL(padding.offset, 256u);
+	CHECK(!overlaps(padding, aligned));
+
+	auto msaa = allocator.allocate(1 * MB, 4 * MB);
+
+	// Nothing past offset 0 is 4MB aligned in a 4MB range
+	CHECK(!msaa.valid());
+
+	allocator.free(small);
+	allocator.free(aligned);
+	allocator.free(padding);
+
+	msaa = allocator.allocate(1 * MB, 4 * MB);
+	CHECK(msaa.valid());
+	CHECK_EQUAL(msaa.offset, 0u);
+}
+
+TEST_CASE(tlsfAllocatorReusesHoles)
+{
+	TLSFAllocator allocator(1 * MB);
+
+	std::vector<TLSFAllocation> allocations;
+
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		allocations.push_back(allocator.allocate(64 * KB));
+	}
+
+	CHECK(!allocator.allocate(256).valid());
+
+	allocator.free(allocations[5]);
+
+	auto reused = allocator.allocate(60 * KB);
+
+	REQUIRE(reused.valid());
+	CHECK_EQUAL(reused.offset, 5 * 64 * KB);
+
+	// The 4KB left over is a block of its own
+	CHECK_EQUAL(allocator.statistics().freeBlockCount, 1u);
+	CHECK_EQUAL(allocator.statistics().freeBytes, 4 * KB);
+	CHECK(!allocator.allocate(8 * KB).valid());
+	CHECK(allocator.allocate(4 * KB).valid());
+}
+
+TEST_CASE(tlsfAllocatorRejectsOversizedRequests)
+{
+	TLSFAllocator allocator(1 * MB);
+
+	CHECK(!allocator.allocate(1 * MB + 1).valid());
+	CHECK(allocator.allocate(1 * MB).valid());
+	CHECK(!allocator.allocate(1).valid());
+}
+
+TEST_CASE(heapAllocatorGrowsAndDedicatesLargeHeaps)
+{
+	HeapAllocator allocator(4 * MB);
+
+	auto a = allocator.allocate(3 * MB, 64 * KB);
+	auto b = allocator.allocate(2 * MB, 64 * KB);
+
+	REQUIRE(a.valid() && b.valid());
+	CHECK_EQUAL(a.heap, 0u);
+	CHECK_EQUAL(b.heap, 1u);
+	CHECK_EQUAL(allocator.heapCount(), 2u);
+	CHECK_EQUAL(allocator.heapSize(1), 4 * MB);
+
+	// Larger than a heap: gets a heap of exactly its aligned size
+	auto large = allocator.allocate(9 * MB + 100, 64 * KB);
+
+	REQUIRE(large.valid());
+	CHECK_EQUAL(large.heap, 2u);
+	CHECK_EQUAL(large.offset, 0u);
+	CHECK_EQUAL(allocator.heapSize(2), 9 * MB + 64 * KB);
+
+	// Small requests go to the first heap with room
+	auto small = allocator.allocate(512 * KB, 64 * KB);
+
+	CHECK_EQUAL(small.heap, 0u);
+	CHECK_EQUAL(small.offset, 3 * MB);
+
+	auto statistics = allocator.statistics();
+	CHECK_EQUAL(statistics.totalBytes, 8 * MB + 9 * MB + 64 * KB);
+	CHECK_EQUAL(statistics.allocationCount, 4u);
+	CHECK_EQUAL(statistics.largestFreeBlock, 2 * MB);
+
+	allocator.free(a);
+	allocator.free(b);
+	allocator.free(large);
+	allocator.free(small);
+
+	CHECK_EQUAL(allocator.statistics().usedBytes, 0u);
+
+	// Freeing an invalid allocation is a no-op
+	CHECK(!allocator.free(HeapAllocation{}));
+}
+
+TEST_CASE(heapAllocatorReleasesDedicatedHeaps)
+{
+	HeapAllocator allocator(4 * MB);
+
+	auto small = allocator.allocate(1 * MB, 64 * KB);
+	auto large = allocator.allocate(6 * MB, 64 * KB);
+
+	REQUIRE(small.valid() && large.valid());
+	CHECK_EQUAL(large.heap, 1u);
+	CHECK_EQUAL(allocator.heapSize(1), 6 * MB);
+
+	// The dedicated heap has no room left for anyone else, a small request does not go there
+	auto other = allocator.allocate(3 * MB + 512 * KB, 64 * KB);
+
+	REQUIRE(other.valid());
+	CHECK_EQUAL(other.heap, 2u);
+
+	// Freeing from a shared heap keeps it, freeing the dedicated allocation releases its heap
+	CHECK(!allocator.free(small));
+	CHECK(allocator.free(large));
+
+	CHECK_EQUAL(allocator.heapCount(), 3u);
+	CHECK_EQUAL(allocator.heapSize(0), 4 * MB);
+	CHECK_EQUAL(allocator.heapSize(1), 0u);
+	CHECK_EQUAL(allocator.statistics().totalBytes, 8 * MB);
+
+	// A released heap takes no allocations until its index is reused for a new heap
+	auto fits = allocator.allocate(2 * MB, 64 * KB);
+
+	CHECK_EQUAL(fits.heap, 0u);
+
+	auto reused = allocator.allocate(5 * MB, 64 * KB);
+
+	REQUIRE(reused.valid());
+	CHECK_EQUAL(reused.heap, 1u);
+	CHECK_EQUAL(allocator.heapSize(1), 5 * MB);
+	CHECK_EQUAL(allocator.heapCount(), 3u);
+
+	CHECK(allocator.free(reused));
+	CHECK(!allocator.free(other));
+	CHECK(!allocator.free(fits));
+
+	CHECK_EQUAL(allocator.statistics().usedBytes, 0u);
+}
+
+TEST_CASE(tlsfAllocatorSurvivesChurn)
+{
+	TLSFAllocator allocator(64 * MB);
+	ChurnGenerator generator;
+
+	std::vector<TLSFAllocation> live;
+
+	for (uint32_t i = 0; i < 20000; i++)
+	{
+		if (!live.empty() && (generator.random() % 2 == 0 || live.size() > 64))
+		{
+			auto index = generator.random() % live.size();
+			allocator.free(live[index]);
+			live[index] = live.back();
+			live.pop_back();
+			continue;
+		}
+
+		auto alignment = generator.alignment();
+		auto allocation = allocator.allocate(generator.size(), alignment);
+
+		if (!allocation.valid())
+		{
+			continue;
+		}
+
+		CHECK_EQUAL(allocation.offset % alignment, 0u);
+		CHECK(allocation.offset + allocation.size <= allocator.size());
+
+		for (const auto& other : live)
+		{
+			if (overlaps(allocation, other))
+			{
+				REQUIRE(!"allocations overlap");
+			}
+		}
+
+		live.push_back(allocation);
+	}
+
+	uint64_t liveBytes = 0;
+
+	for (const auto& allocation : live)
+	{
+		liveBytes += allocation.size;
+	}
+
+	CHECK_EQUAL(allocator.statistics().usedBytes, liveBytes);
+
+	for (const auto& allocation : live)
+	{
+		allocator.free(allocation);
+	}
+
+	auto statistics = allocator.statistics();
+	CHECK_EQUAL(statistics.freeBlockCount, 1u);
+	CHECK_EQUAL(statistics.largestFreeBlock, 64 * MB);
+}
+
+// Prints the cost of an allocate/free pair under churn and the fragmentation it leaves behind.
+BENCHMARK(heapAllocatorChurnBenchmark)
+{
+	constexpr uint32_t OperationCount = 200000;
+
+	HeapAllocator allocator(64 * MB);
+	ChurnGenerator generator;
+
+	std::vector<HeapAllocation> live;
+	live.reserve(1024);
+
+	uint32_t allocations = 0;
+	double worstFragmentation = 0.0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < OperationCount; i++)
+	{
+		// Hovers around 512 live allocations
+		if (!live.empty() && generator.random() % 1024 < live.size())
+		{
+			auto index = generator.random() % live.size();
+			allocator.free(live[index]);
+			live[index] = live.back();
+			live.pop_back();
+		}
+		else
+		{
+			auto allocation = allocator.allocate(generator.size(), generator.alignment());
+			REQUIRE(allocation.valid());
+
+			live.push_back(allocation);
+			allocations++;
+		}
+
+		if (i % 4096 == 0)
+		{
+			worstFragmentation = std::max(worstFragmentation, allocator.statistics().fragmentation());
+		}
+	}
+
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	auto statistics = allocator.statistics();
+
+	std::printf("  %u operations, %.1f ns each, %u heaps of %llu MB, %.1f%% used, worst fragmentation %.2f\n",
+				OperationCount, elapsed / OperationCount, allocator.heapCount(),
+				static_cast<unsigned long long>(allocator.heapSize(0) / MB),
+				100.0 * statistics.usedBytes / statistics.totalBytes, worstFragmentation);
+
+	CHECK(allocations > 0);
+}
@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "Test.h"
+#include "IndirectCommands.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	template <typename T>
+	T readArgument(const std::vector<uint8_t>& buffer, const IndirectCommandLayout& layout, uint32_t command, uint32_t argument)
+	{
+		T value;
+		std::memcpy(&value, buffer.data() + command * layout.byteStride() + layout.argumentOffset(argument), sizeof(T));
+
+		return value;
+	}
+}
+
+TEST_CASE(indirectCommandLayoutPacksArgumentsTightly)
+{
+	IndirectCommandLayout layout;
+
+	auto constants = layout.addConstants(3, 3, 1);
+	auto objectConstants = layout.addConstantBufferView(1);
+	auto vertexBuffer = layout.addVertexBufferView(0);
+	auto indexBuffer = layout.addIndexBufferView();
+	auto draw = layout.addDrawIndexed();
+
+	CHECK_EQUAL(layout.argumentCount(), 5u);
+
+	CHECK_EQUAL(layout.argumentOffset(constants), 0u);
+	CHECK_EQUAL(layout.argumentSize(constants), 12u);
+	CHECK_EQUAL(layout.argumentOffset(objectConstants), 12u);
+	CHECK_EQUAL(layout.argumentSize(objectConstants), 8u);
+	CHECK_EQUAL(layout.argumentOffset(vertexBuffer), 20u);
+	CHECK_EQUAL(layout.argumentSize(vertexBuffer), static_cast<uint32_t>(sizeof(D3D12_VERTEX_BUFFER_VIEW)));
+	CHECK_EQUAL(layout.argumentOffset(indexBuffer), 20u + static_cast<uint32_t>(sizeof(D3D12_VERTEX_BUFFER_VIEW)));
+	CHECK_EQUAL(layout.argumentSize(draw), static_cast<uint32_t>(sizeof(D3D12_DRAW_INDEXED_ARGUMENTS)));
+
+	auto stride = 12u + 8u + static_cast<uint32_t>(sizeof(D3D12_VERTEX_BUFFER_VIEW) + sizeof(D3D12_INDEX_BUFFER_VIEW) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+	CHECK_EQUAL(layout.byteStride(), stride);
+	CHECK_EQUAL(layout.argumentOffset(draw) + layout.argumentSize(draw), stride);
+
+	CHECK(layout.argument(constants).Type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT);
+	CHECK_EQUAL(layout.argument(constants).Constant.RootParameterIndex, 3u);
+	CHECK_EQUAL(layout.argument(constants).Constant.DestOffsetIn32BitValues, 1u);
+	CHECK_EQUAL(layout.argument(constants).Constant.Num32BitValuesToSet, 3u);
+	CHECK_EQUAL(layout.argument(objectConstants).ConstantBufferView.RootParameterIndex, 1u);
+}
+
+TEST_CASE(indirectCommandLayoutDescribesTheCommandSignature)
+{
+	IndirectCommandLayout drawOnly;
+	drawOnly.addDrawIndexed();
+
+	CHECK(!drawOnly.changesRootArguments());
+
+	IndirectCommandLayout layout;
+	layout.addShaderResourceView(5);
+	layout.addDraw();
+
+	CHECK(layout.changesRootArguments());
+
+	auto desc = layout.commandSignatureDesc();
+	CHECK_EQUAL(desc.ByteStride, layout.byteStride());
+	CHECK_EQUAL(desc.NumArgumentDescs, 2u);
+	CHECK(desc.pArgumentDescs == &layout.argument(0));
+	CHECK(desc.pArgumentDescs[1].Type == D3D12_INDIRECT_ARGUMENT_TYPE_DRAW);
+	CHECK_EQUAL(layout.byteStride(), static_cast<uint32_t>(sizeof(D3D12_GPU_VIRTUAL_ADDRESS) + sizeof(D3D12_DRAW_ARGUMENTS)));
+}
+
+TEST_CASE(indirectCommandWriterPacksCommandsAtTheStride)
+{
+	IndirectCommandLayout layout;
+	auto constants = layout.addConstants(0, 2);
+	auto objectConstants = layout.addConstantBufferView(1);
+	auto draw = layout.addDrawIndexed();
+
+	// Ends with a guard command the writer must not touch
+	std::vector<uint8_t> buffer(layout.byteStride() * 4, 0xCD);
+	IndirectCommandWriter writer(&layout, buffer.data(), 3);
+
+	for (uint32_t command = 0; command < 3; command++)
+	{
+		REQUIRE(writer.beginCommand());
+
+		uint32_t values[] = { command, command * 10 };
+		writer.setConstants(constants, values, 2);
+		writer.setConstantBufferView(objectConstants, 0x10000 + command * 256);
+		writer.setDrawIndexed(draw, 36, 1, command * 36, -static_cast<int32_t>(command), 0);
+	}
+
+	CHECK(!writer.beginCommand());
+	CHECK_EQUAL(writer.commandCount(), 3u);
+	CHECK_EQUAL(writer.byteSize(), static_cast<uint64_t>(layout.byteStride()) * 3);
+
+	for (uint32_t command = 0; command < 3; command++)
+	{
+		CHECK_EQUAL(readArgument<uint32_t>(buffer, layout, command, constants), command);
+		CHECK_EQUAL(readArgument<D3D12_GPU_VIRTUAL_ADDRESS>(buffer, layout, command, objectConstants), 0x10000u + command * 256);
+
+		auto arguments = readArgument<D3D12_DRAW_INDEXED_ARGUMENTS>(buffer, layout, command, draw);
+		CHECK_EQUAL(arguments.IndexCountPerInstance, 36u);
+		CHECK_EQUAL(arguments.InstanceCount, 1u);
+		CHECK_EQUAL(arguments.StartIndexLocation, command * 36);
+		CHECK_EQUAL(arguments.BaseVertexLocation, -static_cast<int32_t>(command));
+		CHECK_EQUAL(arguments.StartInstanceLocation, 0u);
+	}
+
+	for (uint32_t i = layout.byteStride() * 3; i < buffer.size(); i++)
+	{
+		CHECK_EQUAL(buffer[i], 0xCD);
+	}
+}
+
+TEST_CASE(indirectCommandWriterWritesBufferViews)
+{
+	IndirectCommandLayout layout;
+	auto vertexBuffer = layout.addVertexBufferView(0);
+	auto indexBuffer = layout.addIndexBufferView();
+	auto draw = layout.addDraw();
+
+	std::vector<uint8_t> buffer(layout.byteStride());
+	IndirectCommandWriter writer(&layout, buffer.data(), 1);
+
+	REQUIRE(writer.beginCommand());
+	writer.setVertexBufferView(vertexBuffer, { 0x2000, 4096, 32 });
+	writer.setIndexBufferView(indexBuffer, { 0x8000, 1024, DXGI_FORMAT_R32_UINT });
+	writer.setDraw(draw, 3, 2, 6, 1);
+
+	auto vertexView = readArgument<D3D12_VERTEX_BUFFER_VIEW>(buffer, layout, 0, vertexBuffer);
+	CHECK_EQUAL(vertexView.BufferLocation, 0x2000u);
+	CHECK_EQUAL(vertexView.SizeInBytes, 4096u);
+	CHECK_EQUAL(vertexView.StrideInBytes, 32u);
+
+	auto indexView = readArgument<D3D12_INDEX_BUFFER_VIEW>(buffer, layout, 0, indexBuffer);
+	CHECK_EQUAL(indexView.BufferLocation, 0x8000u);
+	CHECK(indexView.Format == DXGI_FORMAT_R32_UINT);
+
+	auto arguments = readArgument<D3D12_DRAW_ARGUMENTS>(buffer, layout, 0, draw);
+	CHECK_EQUAL(arguments.VertexCountPerInstance, 3u);
+	CHECK_EQUAL(arguments.InstanceCount, 2u);
+	CHECK_EQUAL(arguments.StartVertexLocation, 6u);
+	CHECK_EQUAL(arguments.StartInstanceLocation, 1u);
+}
@@ -0,0 +1,148 @@
+#include "Test.h"
+#include "InstanceBatcher.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+	InstanceKey makeKey(uint64_t mesh, uint64_t material, uint32_t startIndexLocation = 0)
+	{
+		InstanceKey key;
+		key.mesh = mesh;
+		key.material = material;
+		key.pipeline = 4;
+		key.indexCount = 36;
+		key.startIndexLocation = startIndexLocation;
+
+		return key;
+	}
+}
+
+TEST_CASE(instanceBatcherGroupsByKeyInFirstItemOrder)
+{
+	InstanceBatcher batcher;
+
+	batcher.add(makeKey(1, 1), 0);
+	batcher.add(makeKey(2, 1), 1);
+	batcher.add(makeKey(1, 1), 2);
+	batcher.add(makeKey(1, 2), 3);
+	batcher.add(makeKey(2, 1), 4);
+	batcher.add(makeKey(1, 1), 5);
+	batcher.build();
+
+	const auto& batches = batcher.batches();
+	REQUIRE(batches.size() == 3);
+
+	CHECK(batches[0].key == makeKey(1, 1));
+	CHECK(batches[1].key == makeKey(2, 1));
+	CHECK(batches[2].key == makeKey(1, 2));
+
+	CHECK_EQUAL(batches[0].firstInstance, 0u);
+	CHECK_EQUAL(batches[0].instanceCount, 3u);
+	CHECK_EQUAL(batches[1].firstInstance, 3u);
+	CHECK_EQUAL(batches[1].instanceCount, 2u);
+	CHECK_EQUAL(batches[2].firstInstance, 5u);
+	CHECK_EQUAL(batches[2].instanceCount, 1u);
+
+	// Items keep their order inside a batch
+	std::vector<uint32_t> expected = { 0, 2, 5, 1, 4, 3 };
+	CHECK(batcher.instances() == expected);
+	CHECK_EQUAL(batcher.itemCount(), 6u);
+}
+
+TEST_CASE(instanceBatcherSeparatesSubmeshes)
+{
+	InstanceBatcher batcher;
+
+	// Same mesh and material, different submeshes
+	batcher.add(makeKey(1, 1, 0), 0);
+	batcher.add(makeKey(1, 1, 36), 1);
+
+	auto baseVertex = makeKey(1, 1, 0);
+	baseVertex.baseVertexLocation = 24;
+	batcher.add(baseVertex, 2);
+
+	auto pipeline = makeKey(1, 1, 0);
+	pipeline.pipeline = 5;
+	batcher.add(pipeline, 3);
+
+	batcher.build();
+
+	CHECK_EQUAL(batcher.batches().size(), 4u);
+}
+
+TEST_CASE(instanceBatcherClearStartsOver)
+{
+	InstanceBatcher batcher;
+
+	batcher.add(makeKey(1, 1), 0);
+	batcher.add(makeKey(2, 1), 1);
+	batcher.build();
+
+	batcher.clear();
+
+	CHECK_EQUAL(batcher.batches().size(), 0u);
+	CHECK_EQUAL(batcher.itemCount(), 0u);
+
+	batcher.add(makeKey(2, 1), 7);
+	batcher.build();
+
+	REQUIRE(batcher.batches().size() == 1);
+	CHECK(batcher.batches()[0].key == makeKey(2, 1));
+	CHECK_EQUAL(batcher.instances()[0], 7u);
+}
+
+TEST_CASE(instanceBatcherMatchesReferenceGrouping)
+{
+	// Enough keys to grow the table a few times, with colliding hashes among them
+	std::mt19937 random(7);
+	InstanceBatcher batcher;
+
+	for (int frame = 0; frame < 3; frame++)
+	{
+		batcher.clear();
+
+		std::vector<InstanceKey> keys;
+		std::vector<std::vector<uint32_t>> expected;
+		std::vector<InstanceKey> items;
+
+		for (uint32_t item = 0; item < 2000; item++)
+		{
+			auto key = makeKey(random() % 40, random() % 10);
+			items.push_back(key);
+			batcher.add(key, item);
+
+			size_t batch = 0;
+
+			while (batch < keys.size() && !(keys[batch] == key))
+			{
+				batch++;
+			}
+
+			if (batch == keys.size())
+			{
+				keys.push_back(key);
+				expected.emplace_back();
+			}
+
+			expected[batch].push_back(item);
+		}
+
+		batcher.build();
+
+		const auto& batches = batcher.batches();
+		REQUIRE(batches.size() == keys.size());
+
+		for (size_t batch = 0; batch < batches.size(); batch++)
+		{
+			CHECK(batches[batch].key == keys[batch]);
+			REQUIRE(batches[batch].instanceCount == expected[batch].size());
+
+			for (uint32_t i = 0; i < batches[batch].instanceCount; i++)
+			{
+				CHECK_EQUAL(batcher.instances()[batches[batch].firstInstance + i], expected[batch][i]);
+			}
+		}
+	}
+}
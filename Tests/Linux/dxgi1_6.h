@@ -0,0 +1,5 @@
+#pragma once
+
+// <dxgi1_6.h> for the Linux build of the tests: the tested code only needs the formats, which
+// come with the DirectX-Headers. Swap chains and adapters are not available.
+#include <dxgiformat.h>
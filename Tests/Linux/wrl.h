@@ -0,0 +1,4 @@
+#pragma once
+
+// <wrl.h> for the Linux build of the tests: ComPtr comes from the DirectX-Headers adapter.
+#include <wsl/wrladapter.h>
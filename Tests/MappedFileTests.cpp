@@ -0,0 +1,61 @@
+#include "Test.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <utility>
+
+TEST_CASE(mappedFileMapsTheWholeFile)
+{
+	TestDirectory directory;
+
+	std::string content(10000, '\0');
+
+	for (size_t i = 0; i < content.size(); i++)
+	{
+		content[i] = static_cast<char>(i * 7);
+	}
+
+	auto path = directory.write("texture.dds", content);
+
+	MappedFile file;
+
+	REQUIRE(file.open(path));
+	REQUIRE(file.isOpen());
+	REQUIRE(file.size() == content.size());
+
+	CHECK(std::string(reinterpret_cast<const char*>(file.data()), file.size()) == content);
+
+	// Any range inside the mapping, page aligned or not
+	file.prefetch(file.data() + 4097, 1000);
+
+	// Moving hands the mapping over, the source is left closed
+	MappedFile moved(std::move(file));
+
+	CHECK(!file.isOpen());
+	CHECK_EQUAL(file.size(), size_t{ 0 });
+	REQUIRE(moved.isOpen());
+	CHECK_EQUAL(moved.data()[9999], static_cast<uint8_t>(9999 * 7));
+
+	moved.close();
+
+	CHECK(!moved.isOpen());
+	CHECK(moved.data() == nullptr);
+}
+
+TEST_CASE(mappedFileFailsForMissingAndEmptyFiles)
+{
+	TestDirectory directory;
+
+	MappedFile file;
+
+	CHECK(!file.open(directory.path() / "missing.dds"));
+	CHECK(!file.isOpen());
+
+	CHECK(!file.open(directory.write("empty.dds", "")));
+	CHECK(!file.isOpen());
+	CHECK_EQUAL(file.size(), size_t{ 0 });
+
+	// A failed open leaves the object usable
+	CHECK(file.open(directory.write("small.dds", "DDS ")));
+	CHECK_EQUAL(file.size(), size_t{ 4 });
+}
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "Test.h"
+#include "PipelineStateCache.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Owns everything a description points to, so the tests can build the same description twice
+	// at different addresses.
+	struct PipelineDescription
+	{
+		std::vector<uint8_t> vertexShader = std::vector<uint8_t>(64, 0x11);
+		std::vector<uint8_t> pixelShader = std::vector<uint8_t>(96, 0x22);
+		std::string positionSemantic = "POSITION";
+		std::string texcoordSemantic = "TEXCOORD";
+		std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc()
+		{
+			inputElements =
+			{
+				{ positionSemantic.c_str(), 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+				{ texcoordSemantic.c_str(), 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+			};
+
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC desc{};
+			desc.VS = { vertexShader.data(), vertexShader.size() };
+			desc.PS = { pixelShader.data(), pixelShader.size() };
+			desc.InputLayout = { inputElements.data(), static_cast<uint32_t>(inputElements.size()) };
+			desc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+			desc.SampleMask = UINT_MAX;
+			desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+			desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+			desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+			desc.NumRenderTargets = 1;
+			desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+			desc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+			desc.SampleDesc.Count = 1;
+
+			return desc;
+		}
+	};
+
+	constexpr uint64_t RootSignatureHash = 0x1234;
+}
+
+TEST_CASE(pipelineStateHashIgnoresPointers)
+{
+	PipelineDescription first;
+	PipelineDescription second;
+
+	auto firstDesc = first.desc();
+	auto secondDesc = second.desc();
+
+	// Different addresses for bytecode, input layout and semantic names, same contents
+	CHECK(firstDesc.VS.pShaderBytecode != secondDesc.VS.pShaderBytecode);
+	CHECK(firstDesc.InputLayout.pInputElementDescs[0].SemanticName != secondDesc.InputLayout.pInputElementDescs[0].SemanticName);
+
+	// The root signature is identified by its hash, and CachedPSO never counts
+	firstDesc.pRootSignature = reinterpret_cast<ID3D12RootSignature*>(0x1000);
+	secondDesc.pRootSignature = reinterpret_cast<ID3D12RootSignature*>(0x2000);
+	secondDesc.CachedPSO = { second.pixelShader.data(), 16 };
+
+	CHECK_EQUAL(hashGraphicsPipelineState(firstDesc, RootSignatureHash), hashGraphicsPipelineState(secondDesc, RootSignatureHash));
+	CHECK(hashGraphicsPipelineState(firstDesc, RootSignatureHash) != hashGraphicsPipelineState(firstDesc, RootSignatureHash + 1));
+
+	second.pixelShader[50] ^= 1;
+	CHECK(hashGraphicsPipelineState(firstDesc, RootSignatureHash) != hashGraphicsPipelineState(secondDesc, RootSignatureHash));
+}
+
+TEST_CASE(pipelineStateHashIgnoresUnusedRenderTargets)
+{
+	PipelineDescription description;
+
+	auto desc = description.desc();
+	auto hash = hashGraphicsPipelineState(desc, RootSignatureHash);
+
+	// Past NumRenderTargets, and blend states other than the first without independent blending
+	auto unused = desc;
+	unused.RTVFormats[1] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	unused.BlendState.RenderTarget[3].BlendEnable = TRUE;
+
+	CHECK_EQUAL(hashGraphicsPipelineState(unused, RootSignatureHash), hash);
+
+	auto used = desc;
+	used.RTVFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	CHECK(hashGraphicsPipelineState(used, RootSignatureHash) != hash);
+
+	used = unused;
+	used.NumRenderTargets = 2;
+	CHECK(hashGraphicsPipelineState(used, RootSignatureHash) != hash);
+
+	used = unused;
+	used.BlendState.IndependentBlendEnable = TRUE;
+	CHECK(hashGraphicsPipelineState(used, RootSignatureHash) != hash);
+}
+
+TEST_CASE(pipelineStateHashTreatsSemanticsCaseInsensitively)
+{
+	PipelineDescription upper;
+	PipelineDescription lower;
+	lower.positionSemantic = "position";
+	lower.texcoordSemantic = "TexCoord";
+
+	PipelineDescription other;
+	other.texcoordSemantic = "NORMAL";
+
+	auto hash = hashGraphicsPipelineState(upper.desc(), RootSignatureHash);
+
+	CHECK_EQUAL(hashGraphicsPipelineState(lower.desc(), RootSignatureHash), hash);
+	CHECK(hashGraphicsPipelineState(other.desc(), RootSignatureHash) != hash);
+}
+
+TEST_CASE(pipelineLibraryNameIsTheHashInHex)
+{
+	CHECK(pipelineLibraryName(0x0123456789ABCDEFull) == L"0123456789ABCDEF");
+	CHECK(pipelineLibraryName(0x2Aull) == L"000000000000002A");
+}
+
+TEST_CASE(pipelineLibraryFileRoundTrips)
+{
+	std::vector<uint8_t> library(1000);
+
+	for (size_t i = 0; i < library.size(); i++)
+	{
+		library[i] = static_cast<uint8_t>(i * 7);
+	}
+
+	auto file = packPipelineLibrary(library.data(), library.size());
+
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+	REQUIRE(unpackPipelineLibrary(file.data(), file.size(), data, size));
+	CHECK(data == file.data() + file.size() - library.size());
+	REQUIRE(size == library.size());
+	CHECK(std::vector<uint8_t>(data, data + size) == library);
+}
+
+TEST_CASE(pipelineLibraryFileRejectsDamagedFiles)
+{
+	std::vector<uint8_t> library(256, 0x5A);
+	auto file = packPipelineLibrary(library.data(), library.size());
+
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+	CHECK(!unpackPipelineLibrary(nullptr, 0, data, size));
+
+	// Truncated, inside the header or the blob, and with bytes appended
+	CHECK(!unpackPipelineLibrary(file.data(), 8, data, size));
+	CHECK(!unpackPipelineLibrary(file.data(), file.size() - 1, data, size));
+
+	auto longer = file;
+	longer.push_back(0);
+	CHECK(!unpackPipelineLibrary(longer.data(), longer.size(), data, size));
+
+	// A flipped bit in the blob, and another magic number
+	auto damaged = file;
+	damaged.back() ^= 0x10;
+	CHECK(!unpackPipelineLibrary(damaged.data(), damaged.size(), data, size));
+
+	damaged = file;
+	damaged[0] ^= 0xFF;
+	CHECK(!unpackPipelineLibrary(damaged.data(), damaged.size(), data, size));
+
+	// An empty library is never written
+	auto empty = packPipelineLibrary(nullptr, 0);
+	CHECK(!unpackPipelineLibrary(empty.data(), empty.size(), data, size));
+
+	CHECK(data == nullptr);
+	CHECK_EQUAL(size, 0u);
+}
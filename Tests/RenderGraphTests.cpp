@@ -0,0 +1,251 @@
+#include "pch.h"
+#include "Test.h"
+#include "RenderGraph.h"
+
+#include <vector>
+
+namespace
+{
+	constexpr D3D12_RESOURCE_STATES RenderTarget = D3D12_RESOURCE_STATE_RENDER_TARGET;
+	constexpr D3D12_RESOURCE_STATES PixelShaderResource = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	constexpr D3D12_RESOURCE_STATES NonPixelShaderResource = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+	constexpr D3D12_RESOURCE_STATES Present = D3D12_RESOURCE_STATE_PRESENT;
+
+	// compile() never touches the resources, imported ones only need to be told apart
+	ID3D12Resource* fakeResource(uintptr_t id)
+	{
+		return reinterpret_cast<ID3D12Resource*>(id * 16);
+	}
+
+	RenderGraphResource createTarget(RenderGraph& graph, const std::string& name, uint64_t size)
+	{
+		D3D12_RESOURCE_DESC desc{};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		desc.Width = 256;
+		desc.Height = 256;
+		desc.DepthOrArraySize = 1;
+		desc.MipLevels = 1;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+		D3D12_RESOURCE_ALLOCATION_INFO allocation{};
+		allocation.SizeInBytes = size;
+		allocation.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+		return graph.createTransient(name, desc, allocation);
+	}
+
+	RenderGraph::Execute nothing()
+	{
+		return [](ID3D12GraphicsCommandList*) {};
+	}
+
+	std::vector<std::string> compiledPassNames(const RenderGraph& graph)
+	{
+		std::vector<std::string> names;
+
+		for (const auto& compiledPass : graph.compiledPasses())
+		{
+			names.push_back(graph.passName(compiledPass.pass));
+		}
+
+		return names;
+	}
+
+	bool isTransition(const RenderGraphBarrier& barrier, RenderGraphResource resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+	{
+		return barrier.type == RenderGraphBarrier::Type::Transition && barrier.resource == resource && barrier.stateBefore == before && barrier.stateAfter == after;
+	}
+}
+
+TEST_CASE(renderGraphKeepsAValidInsertionOrder)
+{
+	RenderGraph graph;
+	auto backBuffer = graph.importResource("BackBuffer", fakeResource(1), Present);
+	auto scene = createTarget(graph, "Scene", 65536);
+
+	graph.addPass("Scene", nothing()).write(scene, RenderTarget);
+	graph.addPass("Composite", nothing()).read(scene, PixelShaderResource).write(backBuffer, RenderTarget);
+	graph.addPass("UI", nothing()).write(backBuffer, RenderTarget);
+	graph.compile();
+
+	std::vector<std::string> expected = { "Scene", "Composite", "UI" };
+	CHECK(compiledPassNames(graph) == expected);
+}
+
+TEST_CASE(renderGraphSortsReadersAfterTheirWriters)
+{
+	RenderGraph graph;
+	auto backBuffer = graph.importResource("BackBuffer", fakeResource(1), Present);
+	auto scene = createTarget(graph, "Scene", 65536);
+	auto bloom = createTarget(graph, "Bloom", 65536);
+
+	// Added consumers first: nothing wrote the transients yet, so the reads see their last writes
+	graph.addPass("Composite", nothing()).read(scene, PixelShaderResource).read(bloom, PixelShaderResource).write(backBuffer, RenderTarget);
+	graph.addPass("Bloom", nothing()).read(scene, PixelShaderResource).write(bloom, RenderTarget);
+	graph.addPass("Scene", nothing()).write(scene, RenderTarget);
+	graph.compile();
+
+	std::vector<std::string> expected = { "Scene", "Bloom", "Composite" };
+	CHECK(compiledPassNames(graph) == expected);
+}
+
+TEST_CASE(renderGraphOrdersWritesAndReadsOfOneResource)
+{
+	RenderGraph graph;
+	auto history = graph.importResource("History", fakeResource(1), PixelShaderResource);
+	auto output = graph.importResource("Output", fakeResource(2), RenderTarget);
+
+	// Writers keep their order, a read of an imported resource before any write sees the old content
+	graph.addPass("Overwrite", nothing()).write(history, RenderTarget);
+	graph.addPass("Touch Up", nothing()).write(history, RenderTarget);
+	graph.addPass("Read Old", nothing()).read(history, PixelShaderResource).write(output, RenderTarget);
+	graph.compile();
+
+	std::vector<std::string> expected = { "Overwrite", "Touch Up", "Read Old" };
+	CHECK(compiledPassNames(graph) == expected);
+
+	graph.reset();
+	history = graph.importResource("History", fakeResource(1), PixelShaderResource);
+	output = graph.importResource("Output", fakeResource(2), RenderTarget);
+
+	graph.addPass("Read Old", nothing()).read(history, PixelShaderResource).write(output, RenderTarget);
+	graph.addPass("Overwrite", nothing()).write(history, RenderTarget);
+	graph.compile();
+
+	expected = { "Read Old", "Overwrite" };
+	CHECK(compiledPassNames(graph) == expected);
+}
+
+TEST_CASE(renderGraphCullsUnusedPasses)
+{
+	RenderGraph graph;
+	auto backBuffer = graph.importResource("BackBuffer", fakeResource(1), Present);
+	auto scene = createTarget(graph, "Scene", 65536);
+	auto debug = createTarget(graph, "Debug", 65536);
+	auto debugBlur = createTarget(graph, "DebugBlur", 65536);
+	auto readback = createTarget(graph, "Readback", 65536);
+
+	auto scenePass = graph.addPass("Scene", nothing()).write(scene, RenderTarget).pass();
+	auto debugPass = graph.addPass("Debug", nothing()).write(debug, RenderTarget).pass();
+	auto debugBlurPass = graph.addPass("Debug Blur", nothing()).read(debug, PixelShaderResource).write(debugBlur, RenderTarget).pass();
+	auto readbackPass = graph.addPass("Readback", nothing()).write(readback, RenderTarget).sideEffects().pass();
+	auto compositePass = graph.addPass("Composite", nothing()).read(scene, PixelShaderResource).write(backBuffer, RenderTarget).pass();
+	graph.compile();
+
+	// Debug Blur's output is never read, which leaves Debug without a reader as well
+	CHECK(!graph.isCulled(scenePass));
+	CHECK(graph.isCulled(debugPass));
+	CHECK(graph.isCulled(debugBlurPass));
+	CHECK(!graph.isCulled(readbackPass));
+	CHECK(!graph.isCulled(compositePass));
+
+	std::vector<std::string> expected = { "Scene", "Readback", "Composite" };
+	CHECK(compiledPassNames(graph) == expected);
+}
+
+TEST_CASE(renderGraphBatchesBarriersPerPass)
+{
+	RenderGraph graph;
+	auto backBuffer = graph.importResource("BackBuffer", fakeResource(1), Present);
+	auto shadowMap = graph.importResource("ShadowMap", fakeResource(2), RenderTarget);
+	auto albedo = graph.importResource("Albedo", fakeResource(3), PixelShaderResource);
+
+	graph.addPass("Shadows", nothing()).write(shadowMap, RenderTarget);
+	// Two reads of one resource need both states at once, albedo is already readable
+	graph.addPass("Lighting", nothing())
+		.read(shadowMap, PixelShaderResource)
+		.read(shadowMap, NonPixelShaderResource)
+		.read(albedo, PixelShaderResource)
+		.write(backBuffer, RenderTarget);
+	graph.addPass("UI", nothing()).write(backBuffer, RenderTarget);
+	graph.compile();
+
+	const auto& passes = graph.compiledPasses();
+	REQUIRE(passes.size() == 3);
+
+	CHECK(passes[0].barriers.empty());
+
+	REQUIRE(passes[1].barriers.size() == 2);
+	CHECK(isTransition(passes[1].barriers[0], shadowMap, RenderTarget, PixelShaderResource | NonPixelShaderResource));
+	CHECK(isTransition(passes[1].barriers[1], backBuffer, Present, RenderTarget));
+
+	// Already a render target
+	CHECK(passes[2].barriers.empty());
+
+	// Imported resources go back to their final states after the last pass
+	const auto& finalBarriers = graph.finalBarriers();
+	REQUIRE(finalBarriers.size() == 2);
+	CHECK(isTransition(finalBarriers[0], backBuffer, RenderTarget, Present));
+	CHECK(isTransition(finalBarriers[1], shadowMap, PixelShaderResource | NonPixelShaderResource, RenderTarget));
+}
+
+TEST_CASE(renderGraphAliasesTransientsWithDisjointLifetimes)
+{
+	RenderGraph graph;
+	auto backBuffer = graph.importResource("BackBuffer", fakeResource(1), Present);
+	auto first = createTarget(graph, "First", 65536);
+	auto second = createTarget(graph, "Second", 65536);
+	auto longLived = createTarget(graph, "LongLived", 131072);
+
+	graph.addPass("Write First", nothing()).write(first, RenderTarget).write(longLived, RenderTarget);
+	graph.addPass("Read First", nothing()).read(first, PixelShaderResource).write(backBuffer, RenderTarget);
+	graph.addPass("Write Second", nothing()).write(second, RenderTarget);
+	graph.addPass("Read Second", nothing()).read(second, PixelShaderResource).read(longLived, PixelShaderResource).write(backBuffer, RenderTarget);
+	graph.compile();
+
+	// The largest goes first, the two short lived targets share the memory after it
+	CHECK_EQUAL(graph.transientHeapOffset(longLived), 0u);
+	CHECK_EQUAL(graph.transientHeapOffset(first), 131072u);
+	CHECK_EQUAL(graph.transientHeapOffset(second), 131072u);
+	CHECK_EQUAL(graph.transientHeapSize(), 196608u);
+
+	const auto& passes = graph.compiledPasses();
+	REQUIRE(passes.size() == 4);
+
+	// First takes over memory last used by Second in the previous frame
+	REQUIRE(passes[0].barriers.size() == 1);
+	CHECK(passes[0].barriers[0].type == RenderGraphBarrier::Type::Aliasing);
+	CHECK_EQUAL(passes[0].barriers[0].resource, first);
+	CHECK_EQUAL(passes[0].barriers[0].aliasedBefore, InvalidRenderGraphResource);
+
+	REQUIRE(passes[1].barriers.size() == 2);
+	CHECK(isTransition(passes[1].barriers[0], first, RenderTarget, PixelShaderResource));
+	CHECK(isTransition(passes[1].barriers[1], backBuffer, Present, RenderTarget));
+
+	// First goes back to its creation state after its last use, then Second takes over the memory
+	REQUIRE(passes[2].barriers.size() == 2);
+	CHECK(isTransition(passes[2].barriers[0], first, PixelShaderResource, RenderTarget));
+	CHECK(passes[2].barriers[1].type == RenderGraphBarrier::Type::Aliasing);
+	CHECK_EQUAL(passes[2].barriers[1].resource, second);
+	CHECK_EQUAL(passes[2].barriers[1].aliasedBefore, first);
+
+	REQUIRE(passes[3].barriers.size() == 2);
+	CHECK(isTransition(passes[3].barriers[0], second, RenderTarget, PixelShaderResource));
+	CHECK(isTransition(passes[3].barriers[1], longLived, RenderTarget, PixelShaderResource));
+
+	const auto& finalBarriers = graph.finalBarriers();
+	REQUIRE(finalBarriers.size() == 3);
+	CHECK(isTransition(finalBarriers[0], second, PixelShaderResource, RenderTarget));
+	CHECK(isTransition(finalBarriers[1], longLived, PixelShaderResource, RenderTarget));
+	CHECK(isTransition(finalBarriers[2], backBuffer, RenderTarget, Present));
+}
+
+TEST_CASE(renderGraphSeparatesOverlappingTransients)
+{
+	RenderGraph graph;
+	auto backBuffer = graph.importResource("BackBuffer", fakeResource(1), Present);
+	auto first = createTarget(graph, "First", 65536);
+	auto second = createTarget(graph, "Second", 65536);
+
+	graph.addPass("Write Both", nothing()).write(first, RenderTarget).write(second, RenderTarget);
+	graph.addPass("Read Both", nothing()).read(first, PixelShaderResource).read(second, PixelShaderResource).write(backBuffer, RenderTarget);
+	graph.compile();
+
+	CHECK(graph.transientHeapOffset(first) != graph.transientHeapOffset(second));
+	CHECK_EQUAL(graph.transientHeapSize(), 131072u);
+
+	// Nothing else ever used their memory
+	CHECK(graph.compiledPasses()[0].barriers.empty());
+}
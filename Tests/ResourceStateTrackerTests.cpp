@@ -0,0 +1,209 @@
+#include "pch.h"
+#include "Test.h"
+#include "ResourceStateTracker.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	// Stands in for an ID3D12GraphicsCommandList: keeps every ResourceBarrier call as one batch.
+	struct RecordingCommandList
+	{
+		std::vector<std::vector<D3D12_RESOURCE_BARRIER>> batches;
+
+		void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers)
+		{
+			batches.emplace_back(barriers, barriers + count);
+		}
+	};
+
+	// The tracker only compares the pointers, so the fakes never have to point at real resources.
+	ID3D12Resource* fakeResource(uintptr_t id)
+	{
+		return reinterpret_cast<ID3D12Resource*>(id * 16);
+	}
+
+	bool isTransition(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* resource, D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter,
+					  D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE, uint32_t subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+	{
+		return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Flags == flags && barrier.Transition.pResource == resource &&
+			   barrier.Transition.Subresource == subresource && barrier.Transition.StateBefore == stateBefore && barrier.Transition.StateAfter == stateAfter;
+	}
+}
+
+TEST_CASE(resourceStateTrackerDropsSatisfiedRequests)
+{
+	RecordingCommandList commandList;
+	ResourceStateTracker tracker;
+
+	auto texture = fakeResource(1);
+	tracker.track(texture, 1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+	// Both are part of the combined read state
+	tracker.transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.transition(texture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	tracker.flush(&commandList);
+
+	CHECK_EQUAL(commandList.batches.size(), 0u);
+
+	// A write state never satisfies another state
+	tracker.transition(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.transition(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.flush(&commandList);
+	tracker.transition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.flush(&commandList);
+
+	REQUIRE(commandList.batches.size() == 2);
+	CHECK(isTransition(commandList.batches[0][0], texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+	CHECK(isTransition(commandList.batches[1][0], texture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_RENDER_TARGET));
+
+	const auto& statistics = tracker.statistics();
+	CHECK_EQUAL(statistics.requested, 5u);
+	CHECK_EQUAL(statistics.elided, 3u);
+	CHECK_EQUAL(statistics.merged, 0u);
+	CHECK_EQUAL(statistics.issued, 2u);
+	CHECK_EQUAL(statistics.batches, 2u);
+}
+
+TEST_CASE(resourceStateTrackerBatchesAndMergesQueuedBarriers)
+{
+	RecordingCommandList commandList;
+	ResourceStateTracker tracker;
+
+	auto first = fakeResource(1);
+	auto second = fakeResource(2);
+	tracker.track(first, 1, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.track(second, 1, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	// The second request of each resource rewrites its queued barrier, the third cancels the one of second
+	tracker.transition(first, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.transition(second, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.transition(first, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.transition(second, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.transition(second, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	CHECK(tracker.state(first) == D3D12_RESOURCE_STATE_RENDER_TARGET);
+	CHECK(tracker.state(second) == D3D12_RESOURCE_STATE_COPY_DEST);
+
+	tracker.flush(&commandList);
+
+	REQUIRE(commandList.batches.size() == 1);
+	REQUIRE(commandList.batches[0].size() == 1);
+	CHECK(isTransition(commandList.batches[0][0], first, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	CHECK(tracker.pendingBarriers().empty());
+
+	const auto& statistics = tracker.statistics();
+	CHECK_EQUAL(statistics.requested, 5u);
+	CHECK_EQUAL(statistics.elided, 0u);
+	CHECK_EQUAL(statistics.merged, 3u);
+	CHECK_EQUAL(statistics.issued, 1u);
+	CHECK_EQUAL(statistics.batches, 1u);
+}
+
+TEST_CASE(resourceStateTrackerSplitsTransitionsAcrossFlushes)
+{
+	RecordingCommandList commandList;
+	ResourceStateTracker tracker;
+
+	auto texture = fakeResource(1);
+	tracker.track(texture, 1, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+	tracker.beginTransition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.flush(&commandList);
+
+	// The state only changes once the transition ends
+	CHECK(tracker.state(texture) == D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+	tracker.transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	CHECK(tracker.state(texture) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.flush(&commandList);
+
+	REQUIRE(commandList.batches.size() == 2);
+	CHECK(isTransition(commandList.batches[0][0], texture, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+	CHECK(isTransition(commandList.batches[1][0], texture, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+
+	// Begin and end in the same batch become one ordinary barrier
+	tracker.beginTransition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.transition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.flush(&commandList);
+
+	REQUIRE(commandList.batches.size() == 3);
+	REQUIRE(commandList.batches[2].size() == 1);
+	CHECK(isTransition(commandList.batches[2][0], texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
+}
+
+TEST_CASE(resourceStateTrackerTracksSubresources)
+{
+	RecordingCommandList commandList;
+	ResourceStateTracker tracker;
+
+	D3D12_RESOURCE_DESC desc{};
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.MipLevels = 2;
+	desc.DepthOrArraySize = 2;
+
+	auto texture = fakeResource(1);
+	tracker.track(texture, ResourceStateTracker::subresourceCount(desc), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	tracker.transition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET, 1);
+	tracker.flush(&commandList);
+
+	CHECK(tracker.state(texture, 0) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	CHECK(tracker.state(texture, 1) == D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+	// Only the subresource in another state needs a barrier, then they share one state again
+	tracker.transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.flush(&commandList);
+
+	REQUIRE(commandList.batches.size() == 2);
+	CHECK(isTransition(commandList.batches[0][0], texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_FLAG_NONE, 1));
+	REQUIRE(commandList.batches[1].size() == 1);
+	CHECK(isTransition(commandList.batches[1][0], texture, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_NONE, 1));
+
+	tracker.transition(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.flush(&commandList);
+
+	REQUIRE(commandList.batches.size() == 3);
+	REQUIRE(commandList.batches[2].size() == 1);
+	CHECK(isTransition(commandList.batches[2][0], texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+}
+
+TEST_CASE(resourceStateTrackerUntrackDropsQueuedBarriers)
+{
+	RecordingCommandList commandList;
+	ResourceStateTracker tracker;
+
+	auto released = fakeResource(1);
+	auto split = fakeResource(2);
+	auto other = fakeResource(3);
+	tracker.track(released, 1, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.track(split, 1, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.track(other, 1, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	tracker.transition(released, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.beginTransition(split, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.transition(other, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	tracker.untrack(released);
+
+	CHECK(!tracker.isTracked(released));
+	REQUIRE(tracker.pendingBarriers().size() == 2);
+
+	// The begin barrier moved down a slot, ending the split must still find it
+	tracker.transition(split, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.flush(&commandList);
+
+	REQUIRE(commandList.batches.size() == 1);
+	REQUIRE(commandList.batches[0].size() == 2);
+	CHECK(isTransition(commandList.batches[0][0], split, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	CHECK(isTransition(commandList.batches[0][1], other, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+	// A new resource at the same address starts over
+	tracker.track(released, 1, D3D12_RESOURCE_STATE_COMMON);
+	tracker.transition(released, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.untrack(released);
+	tracker.flush(&commandList);
+
+	CHECK_EQUAL(commandList.batches.size(), 1u);
+}
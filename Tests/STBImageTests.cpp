@@ -0,0 +1,220 @@
+#include "Test.h"
+#include "STBImage.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	// 5x4 RGB, the rows use the None, Sub, Up, Average and Paeth filters in turn.
+	// Texel (x, y) is (x * 50 + y * 3, y * 60 + x * 5, 250 - x * 40 - y * 10).
+	const uint8_t TestPng[] =
+	{
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x04, 0x08, 0x02, 0x00, 0x00, 0x00, 0xc9, 0x51, 0x62,
+		0x17, 0x00, 0x00, 0x00, 0x2e, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9c, 0x63, 0x60, 0x60, 0xf8, 0x65,
+		0xc4, 0x7a, 0x29, 0x85, 0x6b, 0xd5, 0x34, 0xfe, 0xa6, 0x13, 0x22, 0x51, 0x8c, 0xcc, 0x36, 0x1f,
+		0x8c, 0x58, 0x6f, 0xc0, 0x11, 0x13, 0xb3, 0xcd, 0x37, 0x14, 0xc4, 0x56, 0x91, 0x29, 0xad, 0xf8,
+		0x1c, 0x8e, 0x00, 0xb8, 0xc7, 0x16, 0x66, 0x8d, 0xab, 0x61, 0x4b, 0x00, 0x00, 0x00, 0x00, 0x49,
+		0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+	// 16x16 baseline JPEG, no chroma subsampling and all quantizers 1.
+	// Texel (x, y) is (x * 12 + 20, y * 12 + 30, 128) before compression.
+	const uint8_t TestJpeg[] =
+	{
+		0xff, 0xd8, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x10,
+		0x03, 0x01, 0x11, 0x00, 0x02, 0x11, 0x00, 0x03, 0x11, 0x00, 0xff, 0xc4, 0x00, 0x1f, 0x00, 0x00,
+		0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0x1f, 0x01,
+		0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5,
+		0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00, 0x00, 0x01,
+		0x7d, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61,
+		0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1,
+		0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27,
+		0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+		0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+		0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+		0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6,
+		0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4,
+		0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1,
+		0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+		0xf8, 0xf9, 0xfa, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x10, 0x03, 0x10, 0x00, 0x3f,
+		0x00, 0xfc, 0x5a, 0xf8, 0x7d, 0xfb, 0x3f, 0xff, 0x00, 0xa8, 0xff, 0x00, 0x42, 0xfe, 0xef, 0xfc,
+		0xb3, 0xfa, 0x7b, 0x57, 0xf7, 0x6f, 0x89, 0x7e, 0x24, 0x7f, 0xac, 0xff, 0x00, 0x48, 0xf5, 0xfe,
+		0x2f, 0xfe, 0xbd, 0x7e, 0x67, 0xf0, 0x4b, 0xe2, 0xe7, 0xfc, 0x7a, 0x7f, 0xa5, 0x7f, 0x73, 0xf8,
+		0xfe, 0x9e, 0xf5, 0xf7, 0x37, 0xc3, 0xef, 0xd9, 0xff, 0x00, 0xfd, 0x47, 0xfa, 0x17, 0xf7, 0x7f,
+		0xe5, 0x9f, 0xd3, 0xda, 0xbf, 0x9f, 0xbc, 0x4b, 0xf1, 0x23, 0xfd, 0x67, 0xfa, 0x47, 0xaf, 0xf1,
+		0x7f, 0xf5, 0xeb, 0xfd, 0x80, 0xf8, 0x25, 0xf1, 0x73, 0xfe, 0x3d, 0x3f, 0xd2, 0xbf, 0xb9, 0xfc,
+		0x7f, 0x4f, 0x7a, 0xfb, 0x77, 0xe1, 0xf7, 0xec, 0xff, 0x00, 0xfe, 0xa3, 0xfd, 0x0b, 0xfb, 0xbf,
+		0xf2, 0xcf, 0xe9, 0xed, 0x5f, 0x81, 0x78, 0x97, 0xe2, 0x47, 0xfa, 0xcf, 0xf4, 0x8f, 0x5f, 0xe2,
+		0xff, 0x00, 0xeb, 0xd7, 0xfc, 0x9e, 0xfc, 0x12, 0xf8, 0xb9, 0xff, 0x00, 0x1e, 0x9f, 0xe9, 0x5f,
+		0xdc, 0xfe, 0x3f, 0xa7, 0xbd, 0x7d, 0xcd, 0xf0, 0xfb, 0xf6, 0x7f, 0xff, 0x00, 0x51, 0xfe, 0x85,
+		0xfd, 0xdf, 0xf9, 0x67, 0xf4, 0xf6, 0xaf, 0xe7, 0xdf, 0x12, 0xfc, 0x48, 0xff, 0x00, 0x59, 0xfe,
+		0x91, 0xeb, 0xfc, 0x5f, 0xfd, 0x7a, 0xff, 0x00, 0x60, 0x3e, 0x09, 0x7c, 0x5c, 0xff, 0x00, 0x8f,
+		0x4f, 0xf4, 0xaf, 0xee, 0x7f, 0x1f, 0xd3, 0xde, 0xbf, 0xff, 0xd9,
+	};
+
+	constexpr uint8_t Padding = 0xcd;
+
+	// A destination whose bytes past each row (and past the last one) start out as Padding.
+	std::vector<uint8_t> destination(const STBImage& image, size_t rowPitch)
+	{
+		return std::vector<uint8_t>(rowPitch * image.height() + 16, Padding);
+	}
+
+	bool paddingIntact(const std::vector<uint8_t>& data, const STBImage& image, size_t rowSize, size_t rowPitch)
+	{
+		for (size_t i = 0; i < data.size(); i++)
+		{
+			auto inRow = i / rowPitch < image.height() && i % rowPitch < rowSize;
+
+			if (!inRow && data[i] != Padding)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void checkPng(const std::vector<uint8_t>& data, size_t rowPitch, bool bgra)
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			for (uint32_t x = 0; x < 5; x++)
+			{
+				const auto* texel = data.data() + y * rowPitch + x * 4;
+
+				CHECK_EQUAL(texel[bgra ? 2 : 0], x * 50 + y * 3);
+				CHECK_EQUAL(texel[1], y * 60 + x * 5);
+				CHECK_EQUAL(texel[bgra ? 0 : 2], 250 - x * 40 - y * 10);
+				CHECK_EQUAL(texel[3], 255);
+			}
+		}
+	}
+
+	void checkJpeg(const std::vector<uint8_t>& data, size_t rowPitch)
+	{
+		for (uint32_t y = 0; y < 16; y++)
+		{
+			for (uint32_t x = 0; x < 16; x++)
+			{
+				const auto* texel = data.data() + y * rowPitch + x * 4;
+
+				CHECK(std::abs(texel[0] - static_cast<int>(x * 12 + 20)) <= 4);
+				CHECK(std::abs(texel[1] - static_cast<int>(y * 12 + 30)) <= 4);
+				CHECK(std::abs(texel[2] - 128) <= 4);
+				CHECK_EQUAL(texel[3], 255);
+			}
+		}
+	}
+}
+
+TEST_CASE(stbImageOpenReadsTheHeaderOnly)
+{
+	STBImage image;
+
+	REQUIRE(image.open(TestPng, sizeof(TestPng)));
+
+	CHECK_EQUAL(image.width(), 5u);
+	CHECK_EQUAL(image.height(), 4u);
+	CHECK_EQUAL(image.channels(), 3u);
+	CHECK(image.nativeFormat() == ImageFormat::RGBA8);
+
+	STBImage broken;
+
+	CHECK(!broken.open(TestPng, 16));
+	CHECK(!broken.error().empty());
+}
+
+TEST_CASE(stbImageDecodesPngIntoPackedRows)
+{
+	STBImage image;
+	REQUIRE(image.open(TestPng, sizeof(TestPng)));
+
+	const size_t rowSize = 5 * 4;
+	auto data = destination(image, rowSize);
+
+	REQUIRE(image.decode(data.data(), rowSize, ImageFormat::RGBA8));
+
+	checkPng(data, rowSize, false);
+	CHECK(paddingIntact(data, image, rowSize, rowSize));
+}
+
+TEST_CASE(stbImageDecodesPngIntoPitchedRows)
+{
+	STBImage image;
+	REQUIRE(image.open(TestPng, sizeof(TestPng)));
+
+	// Upload footprints align rows to 256 bytes
+	const size_t rowSize = 5 * 4;
+	const size_t rowPitch = 256;
+	auto data = destination(image, rowPitch);
+
+	REQUIRE(image.decode(data.data(), rowPitch, ImageFormat::BGRA8));
+
+	checkPng(data, rowPitch, true);
+	CHECK(paddingIntact(data, image, rowSize, rowPitch));
+}
+
+TEST_CASE(stbImageDecodesJpegIntoPackedRows)
+{
+	STBImage image;
+	REQUIRE(image.open(TestJpeg, sizeof(TestJpeg)));
+	REQUIRE(image.width() == 16 && image.height() == 16);
+
+	const size_t rowSize = 16 * 4;
+	auto data = destination(image, rowSize);
+
+	REQUIRE(image.decode(data.data(), rowSize, ImageFormat::RGBA8));
+
+	checkJpeg(data, rowSize);
+	CHECK(paddingIntact(data, image, rowSize, rowSize));
+}
+
+TEST_CASE(stbImageDecodesJpegIntoPitchedRows)
+{
+	const size_t rowSize = 16 * 4;
+	const size_t rowPitch = rowSize + 12;
+
+	STBImage packedImage;
+	REQUIRE(packedImage.open(TestJpeg, sizeof(TestJpeg)));
+
+	auto packed = destination(packedImage, rowSize);
+	REQUIRE(packedImage.decode(packed.data(), rowSize, ImageFormat::RGBA8));
+
+	STBImage image;
+	REQUIRE(image.open(TestJpeg, sizeof(TestJpeg)));
+
+	auto data = destination(image, rowPitch);
+	REQUIRE(image.decode(data.data(), rowPitch, ImageFormat::RGBA8));
+
+	checkJpeg(data, rowPitch);
+	CHECK(paddingIntact(data, image, rowSize, rowPitch));
+
+	// The pitch only moves the rows, the texels are the same
+	for (uint32_t y = 0; y < 16; y++)
+	{
+		CHECK(std::equal(packed.begin() + y * rowSize, packed.begin() + (y + 1) * rowSize, data.begin() + y * rowPitch));
+	}
+}
+
+TEST_CASE(stbImageRejectsARowPitchNarrowerThanARow)
+{
+	STBImage image;
+	REQUIRE(image.open(TestPng, sizeof(TestPng)));
+
+	std::vector<uint8_t> data(64 * 4, Padding);
+
+	CHECK(!image.decode(data.data(), 5 * 4 - 1, ImageFormat::RGBA8));
+	CHECK(!image.error().empty());
+
+	// One byte per texel once the texels are reduced to R8
+	CHECK(image.decode(data.data(), 5, ImageFormat::R8));
+}
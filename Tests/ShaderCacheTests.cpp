@@ -0,0 +1,139 @@
+#include "Test.h"
+#include "ShaderCache.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	ShaderCompileParameters pixelShader(const std::filesystem::path& path)
+	{
+		ShaderCompileParameters parameters;
+		parameters.path = path.wstring();
+		parameters.entryPoint = L"PSMain";
+		parameters.targetProfile = L"ps_6_0";
+
+		return parameters;
+	}
+}
+
+TEST_CASE(shaderIncludeScanSkipsComments)
+{
+	auto includes = scanShaderIncludes(
+		"#include \"Common.hlsli\"\n"
+		"  #  include <Lighting.hlsli>\n"
+		"// #include \"LineComment.hlsli\"\n"
+		"/* #include \"BlockComment.hlsli\"\n"
+		"#include \"StillComment.hlsli\" */\n"
+		"float4 color; #include \"NotAtLineStart.hlsli\"\n"
+		"#include \"Unterminated.hlsli\n"
+		"#include \"Sub/Fog.hlsli\" // trailing comment\n"
+		"#ifdef FOG\n"
+		"#include \"Conditional.hlsli\"\n"
+		"#endif\n");
+
+	std::vector<std::string> expected = { "Common.hlsli", "Lighting.hlsli", "Sub/Fog.hlsli", "Conditional.hlsli" };
+	CHECK(includes == expected);
+
+	CHECK(scanShaderIncludes("").empty());
+	CHECK(scanShaderIncludes("/* unterminated").empty());
+}
+
+TEST_CASE(shaderCacheKeyFollowsIncludedFiles)
+{
+	TestDirectory directory;
+
+	auto shader = directory.write("Shader.hlsl", "#include \"Common.hlsli\"\n#include <Shared.hlsli>\nfloat4 PSMain() : SV_Target { return 0; }\n");
+	directory.write("Common.hlsli", "#include \"Nested.hlsli\"\n");
+	directory.write("Nested.hlsli", "static const float a = 1;\n");
+	directory.write("Include/Shared.hlsli", "static const float b = 2;\n");
+	directory.write("Unrelated.hlsli", "static const float c = 3;\n");
+
+	ShaderCache cache(directory.path() / "Cache", { directory.path() / "Include" }, L"DXC 1.7");
+
+	auto files = collectShaderFiles(shader, cache.includeDirectories());
+	CHECK_EQUAL(files.size(), 4u);
+
+	auto key = cache.key(pixelShader(shader));
+	CHECK(key != 0);
+	CHECK_EQUAL(cache.key(pixelShader(shader)), key);
+
+	// A file nothing includes does not matter
+	directory.write("Unrelated.hlsli", "static const float c = 4;\n");
+	CHECK_EQUAL(cache.key(pixelShader(shader)), key);
+
+	// Any file in the include tree does, however deep and wherever it was found
+	directory.write("Nested.hlsli", "static const float a = 5;\n");
+	auto nestedKey = cache.key(pixelShader(shader));
+	CHECK(nestedKey != key);
+
+	directory.write("Include/Shared.hlsli", "static const float b = 6;\n");
+	CHECK(cache.key(pixelShader(shader)) != nestedKey);
+
+	// So do the arguments
+	auto defined = pixelShader(shader);
+	defined.defines.push_back(L"FOG");
+	CHECK(cache.key(defined) != cache.key(pixelShader(shader)));
+
+	CHECK_EQUAL(cache.key(pixelShader(directory.path() / "Missing.hlsl")), 0u);
+}
+
+TEST_CASE(shaderCacheKeyFollowsTheCompilerVersion)
+{
+	TestDirectory directory;
+
+	auto shader = directory.write("Shader.hlsl", "float4 PSMain() : SV_Target { return 0; }\n");
+
+	ShaderCache cache(directory.path() / "Cache", {}, L"DXC 1.7 commit 4 abc");
+	ShaderCache sameCompiler(directory.path() / "Cache", {}, L"DXC 1.7 commit 4 abc");
+	ShaderCache newCompiler(directory.path() / "Cache", {}, L"DXC 1.8 commit 2 def");
+
+	CHECK_EQUAL(sameCompiler.key(pixelShader(shader)), cache.key(pixelShader(shader)));
+	CHECK(newCompiler.key(pixelShader(shader)) != cache.key(pixelShader(shader)));
+}
+
+TEST_CASE(shaderCacheRejectsDamagedBlobs)
+{
+	TestDirectory directory;
+	ShaderCache cache(directory.path(), {}, L"DXC 1.7");
+
+	std::vector<uint8_t> dxil(300);
+
+	for (size_t i = 0; i < dxil.size(); i++)
+	{
+		dxil[i] = static_cast<uint8_t>(i * 13);
+	}
+
+	std::vector<uint8_t> loaded;
+
+	CHECK(!cache.load(0x1234, loaded));
+	CHECK(!cache.store(0x1234, {}));
+
+	REQUIRE(cache.store(0x1234, dxil));
+	REQUIRE(cache.load(0x1234, loaded));
+	CHECK(loaded == dxil);
+
+	// The blob is named by its key, and the header repeats it
+	auto path = directory.path() / "0000000000001234.dxil";
+	REQUIRE(std::filesystem::exists(path));
+	std::filesystem::copy_file(path, directory.path() / "0000000000005678.dxil");
+	CHECK(!cache.load(0x5678, loaded));
+
+	// A flipped byte in the DXIL
+	{
+		std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(-1, std::ios::end);
+		file.put(static_cast<char>(dxil.back() ^ 0x40));
+	}
+
+	CHECK(!cache.load(0x1234, loaded));
+
+	// A truncated blob
+	REQUIRE(cache.store(0x1234, dxil));
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 10);
+	CHECK(!cache.load(0x1234, loaded));
+
+	CHECK(cache.store(0x1234, dxil));
+	CHECK(cache.load(0x1234, loaded));
+}
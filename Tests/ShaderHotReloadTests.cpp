@@ -0,0 +1,155 @@
+#include "Test.h"
+#include "ShaderHotReload.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Modification times can be as coarse as a second or two, so edits move them on explicitly.
+	void touch(const std::filesystem::path& path, int seconds)
+	{
+		std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(seconds));
+	}
+
+	bool samePaths(const std::vector<std::filesystem::path>& paths, const std::vector<std::filesystem::path>& expected)
+	{
+		if (paths.size() != expected.size())
+		{
+			return false;
+		}
+
+		for (const auto& path : expected)
+		{
+			bool found = false;
+
+			for (const auto& candidate : paths)
+			{
+				found = found || std::filesystem::equivalent(candidate, path);
+			}
+
+			if (!found)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+TEST_CASE(shaderDependencyGraphFollowsNestedIncludes)
+{
+	TestDirectory directory;
+
+	auto opaque = directory.write("Opaque.hlsl", "#include \"Common.hlsl\"\n");
+	auto common = directory.write("Common.hlsl", "#include \"LightingUtil.hlsl\"\n#include <Fog.hlsl>\n");
+	auto lighting = directory.write("LightingUtil.hlsl", "float3 light;\n");
+	auto fog = directory.write("Include/Fog.hlsl", "float fogStart;\n");
+
+	ShaderDependencyGraph graph({ directory.path() / "Include" });
+	graph.addProgram("OpaquePS", opaque);
+
+	CHECK_EQUAL(graph.programCount(), 1u);
+	CHECK(samePaths(graph.files(), { opaque, common, lighting, fog }));
+
+	std::vector<std::string> expected = { "OpaquePS" };
+	CHECK(graph.dependents(lighting) == expected);
+	CHECK(graph.dependents(fog) == expected);
+
+	// Spelled another way, still the same file
+	CHECK(graph.dependents(directory.path() / "Include" / ".." / "LightingUtil.hlsl") == expected);
+	CHECK(graph.dependents(directory.path() / "Unrelated.hlsl").empty());
+}
+
+TEST_CASE(shaderDependencyGraphInvalidatesExactlyTheDependents)
+{
+	TestDirectory directory;
+
+	auto lighting = directory.write("LightingUtil.hlsl", "float3 light;\n");
+	auto opaque = directory.write("Opaque.hlsl", "#include \"LightingUtil.hlsl\"\n");
+	auto transparent = directory.write("Transparent.hlsl", "#include \"Opaque.hlsl\"\n");
+	auto skybox = directory.write("Skybox.hlsl", "float4 sky;\n");
+	auto shadow = directory.write("Shadow.hlsl", "#include \"LightingUtil.hlsl\"\n");
+
+	ShaderDependencyGraph graph;
+	graph.addProgram("OpaquePS", opaque);
+	graph.addProgram("SkyboxPS", skybox);
+	graph.addProgram("TransparentPS", transparent);
+	graph.addProgram("ShadowVS", shadow);
+
+	// The shared header reaches every program that includes it, directly or not, in the order they were added
+	std::vector<std::string> expected = { "OpaquePS", "TransparentPS", "ShadowVS" };
+	CHECK(graph.invalidate({ lighting }) == expected);
+
+	expected = { "OpaquePS", "TransparentPS" };
+	CHECK(graph.invalidate({ opaque }) == expected);
+
+	expected = { "SkyboxPS", "ShadowVS" };
+	CHECK(graph.invalidate({ shadow, skybox }) == expected);
+
+	CHECK(graph.invalidate({ directory.path() / "Unrelated.hlsl" }).empty());
+}
+
+TEST_CASE(shaderDependencyGraphPicksUpIncludesAddedByAnEdit)
+{
+	TestDirectory directory;
+
+	auto skybox = directory.write("Skybox.hlsl", "float4 sky;\n");
+	auto fog = directory.write("Fog.hlsl", "float fogStart;\n");
+
+	ShaderDependencyGraph graph;
+	graph.addProgram("SkyboxPS", skybox);
+
+	CHECK(graph.dependents(fog).empty());
+	CHECK_EQUAL(graph.files().size(), 1u);
+
+	directory.write("Skybox.hlsl", "#include \"Fog.hlsl\"\nfloat4 sky;\n");
+
+	std::vector<std::string> expected = { "SkyboxPS" };
+	CHECK(graph.invalidate({ skybox }) == expected);
+	CHECK(graph.dependents(fog) == expected);
+	CHECK(samePaths(graph.files(), { skybox, fog }));
+
+	// And drops the ones an edit removed
+	directory.write("Skybox.hlsl", "float4 sky;\n");
+	graph.invalidate({ skybox });
+
+	CHECK(graph.dependents(fog).empty());
+}
+
+TEST_CASE(fileWatcherReportsChangedFiles)
+{
+	TestDirectory directory;
+
+	auto common = directory.write("Common.hlsl", "float3 light;\n");
+	auto opaque = directory.write("Opaque.hlsl", "#include \"Common.hlsl\"\n");
+	auto created = directory.path() / "Created.hlsl";
+
+	FileWatcher watcher;
+	watcher.watch(common);
+	watcher.watch(opaque);
+	watcher.watch(created);
+	watcher.watch(common);
+
+	CHECK_EQUAL(watcher.watchedCount(), 3u);
+	CHECK(watcher.poll().empty());
+
+	directory.write("Common.hlsl", "float3 light2;\n");
+	touch(common, 2);
+
+	auto changed = watcher.poll();
+	REQUIRE(changed.size() == 1);
+	CHECK(std::filesystem::equivalent(changed[0], common));
+
+	// Reported once per change
+	CHECK(watcher.poll().empty());
+
+	directory.write("Created.hlsl", "float4 sky;\n");
+	std::filesystem::remove(opaque);
+
+	changed = watcher.poll();
+	CHECK_EQUAL(changed.size(), 2u);
+	CHECK(watcher.poll().empty());
+}
@@ -0,0 +1,221 @@
+#include "Test.h"
+#include "StagingRing.h"
+#include "FakeFence.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct LiveAllocation
+	{
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		// 0 while the allocation is not retired yet.
+		uint64_t fenceValue = 0;
+	};
+
+	bool overlaps(const LiveAllocation& allocation, uint64_t offset, uint64_t size)
+	{
+		return offset < allocation.offset + allocation.size && allocation.offset < offset + size;
+	}
+}
+
+TEST_CASE(stagingRingAlignsAllocations)
+{
+	StagingRing ring(4096);
+
+	CHECK_EQUAL(ring.allocate(100, 4), 0u);
+	CHECK_EQUAL(ring.allocate(100, 256), 256u);
+	CHECK_EQUAL(ring.allocate(10, 512), 512u);
+	CHECK_EQUAL(ring.usedBytes(), 522u);
+	CHECK_EQUAL(ring.openBytes(), 522u);
+
+	CHECK_EQUAL(ring.allocate(0, 4), StagingRing::InvalidOffset);
+	CHECK_EQUAL(ring.allocate(4097, 4), StagingRing::InvalidOffset);
+}
+
+TEST_CASE(stagingRingReclaimsOnlyCompletedFences)
+{
+	FakeFence fence;
+	StagingRing ring(1024);
+
+	ring.allocate(256, 4);
+	ring.retire(fence.signal());
+
+	ring.allocate(256, 4);
+	ring.retire(fence.signal());
+
+	CHECK_EQUAL(ring.regionCount(), 2u);
+	CHECK_EQUAL(ring.openBytes(), 0u);
+
+	// Retiring with nothing allocated adds no region
+	ring.retire(fence.signal());
+	CHECK_EQUAL(ring.regionCount(), 2u);
+
+	ring.reclaim(fence.completed);
+	CHECK_EQUAL(ring.usedBytes(), 512u);
+
+	fence.complete(1);
+	ring.reclaim(fence.completed);
+	CHECK_EQUAL(ring.regionCount(), 1u);
+	CHECK_EQUAL(ring.usedBytes(), 256u);
+
+	fence.complete(3);
+	ring.reclaim(fence.completed);
+	CHECK_EQUAL(ring.regionCount(), 0u);
+	CHECK_EQUAL(ring.usedBytes(), 0u);
+
+	// An idle ring starts over at 0
+	CHECK_EQUAL(ring.allocate(1024, 4), 0u);
+}
+
+TEST_CASE(stagingRingKeepsOpenAllocations)
+{
+	StagingRing ring(1024);
+
+	ring.allocate(512, 4);
+
+	// Not retired yet, so no fence value can free it
+	ring.reclaim(UINT64_MAX);
+
+	CHECK_EQUAL(ring.usedBytes(), 512u);
+	CHECK_EQUAL(ring.allocate(512, 4), 512u);
+	CHECK_EQUAL(ring.allocate(1, 1), StagingRing::InvalidOffset);
+}
+
+TEST_CASE(stagingRingReportsFullRing)
+{
+	FakeFence fence;
+	StagingRing ring(1024);
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		CHECK_EQUAL(ring.allocate(256, 256), i * 256u);
+	}
+
+	ring.retire(fence.signal());
+
+	CHECK_EQUAL(ring.allocate(1, 1), StagingRing::InvalidOffset);
+
+	ring.reclaim(fence.completed);
+	CHECK_EQUAL(ring.allocate(1, 1), StagingRing::InvalidOffset);
+
+	fence.complete(fence.signaled);
+	ring.reclaim(fence.completed);
+	CHECK_EQUAL(ring.allocate(1, 1), 0u);
+}
+
+TEST_CASE(stagingRingWrapsAround)
+{
+	FakeFence fence;
+	StagingRing ring(1024);
+
+	CHECK_EQUAL(ring.allocate(400, 4), 0u);
+	ring.retire(fence.signal());
+
+	CHECK_EQUAL(ring.allocate(400, 4), 400u);
+	ring.retire(fence.signal());
+
+	fence.complete(1);
+	ring.reclaim(fence.completed);
+
+	// 224 bytes are left at the end, too few, so the allocation wraps to 0 where the first region was
+	CHECK_EQUAL(ring.allocate(400, 4), 0u);
+	CHECK_EQUAL(ring.usedBytes(), 1024u);
+	CHECK_EQUAL(ring.allocate(1, 1), StagingRing::InvalidOffset);
+
+	ring.retire(fence.signal());
+
+	// The second region's space comes back, the wrapped one is still in flight
+	fence.complete(2);
+	ring.reclaim(fence.completed);
+
+	CHECK_EQUAL(ring.allocate(300, 4), 400u);
+	CHECK_EQUAL(ring.allocate(400, 4), StagingRing::InvalidOffset);
+}
+
+TEST_CASE(stagingRingNeverHandsOutSpaceInFlight)
+{
+	// Uploads of random sizes with the GPU two fence values behind, every allocation is checked
+	// against everything that is not reclaimed yet.
+	FakeFence fence;
+	StagingRing ring(64 * 1024);
+
+	std::mt19937 random(7);
+	std::uniform_int_distribution<uint64_t> sizes(1, 20 * 1024);
+	const uint64_t alignments[] = { 4, 256, 512 };
+
+	std::vector<LiveAllocation> live;
+	uint32_t fullCount = 0;
+
+	for (uint32_t frame = 0; frame < 2000; frame++)
+	{
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			auto size = sizes(random);
+			auto alignment = alignments[random() % 3];
+			auto offset = ring.allocate(size, alignment);
+
+			// Full, wait for the GPU like allocateStagingMemory does
+			while (offset == StagingRing::InvalidOffset)
+			{
+				fullCount++;
+
+				ring.retire(fence.signal());
+
+				for (auto& allocation : live)
+				{
+					if (allocation.fenceValue == 0)
+					{
+						allocation.fenceValue = fence.signaled;
+					}
+				}
+
+				fence.complete(fence.signaled);
+				ring.reclaim(fence.completed);
+
+				offset = ring.allocate(size, alignment);
+			}
+
+			CHECK_EQUAL(offset % alignment, 0u);
+			CHECK(offset + size <= ring.capacity());
+
+			live.erase(std::remove_if(live.begin(), live.end(), [&](const LiveAllocation& allocation)
+			{
+				return allocation.fenceValue != 0 && allocation.fenceValue <= fence.completed;
+			}), live.end());
+
+			for (const auto& allocation : live)
+			{
+				if (overlaps(allocation, offset, size))
+				{
+					REQUIRE(!"allocation overlaps one the GPU may still read");
+				}
+			}
+
+			live.push_back({ offset, size, 0 });
+		}
+
+		ring.retire(fence.signal());
+
+		for (auto& allocation : live)
+		{
+			if (allocation.fenceValue == 0)
+			{
+				allocation.fenceValue = fence.signaled;
+			}
+		}
+
+		if (fence.signaled > 2)
+		{
+			fence.complete(fence.signaled - 2);
+		}
+
+		ring.reclaim(fence.completed);
+	}
+
+	// The ring did fill up and wrap during the run
+	CHECK(fullCount > 0);
+}
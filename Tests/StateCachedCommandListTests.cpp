@@ -0,0 +1,250 @@
+#include "pch.h"
+#include "Test.h"
+#include "StateCachedCommandList.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Stands in for an ID3D12GraphicsCommandList: records the name of every call that reaches it.
+	struct RecordingCommandList
+	{
+		std::vector<std::string> calls;
+
+		void SetPipelineState(ID3D12PipelineState*) { calls.push_back("SetPipelineState"); }
+		void SetGraphicsRootSignature(ID3D12RootSignature*) { calls.push_back("SetGraphicsRootSignature"); }
+		void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) { calls.push_back("SetDescriptorHeaps"); }
+		void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) { calls.push_back("IASetPrimitiveTopology"); }
+		void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) { calls.push_back("IASetVertexBuffers"); }
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) { calls.push_back("IASetIndexBuffer"); }
+		void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) { calls.push_back("SetGraphicsRootDescriptorTable"); }
+		void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetGraphicsRootConstantBufferView"); }
+		void SetGraphicsRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetGraphicsRootShaderResourceView"); }
+		void OMSetStencilRef(UINT) { calls.push_back("OMSetStencilRef"); }
+		void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) { calls.push_back("DrawIndexedInstanced"); }
+		void DrawInstanced(UINT, UINT, UINT, UINT) { calls.push_back("DrawInstanced"); }
+		void ExecuteIndirect(ID3D12CommandSignature*, UINT, ID3D12Resource*, UINT64, ID3D12Resource*, UINT64) { calls.push_back("ExecuteIndirect"); }
+
+		size_t count(const std::string& name) const
+		{
+			size_t result = 0;
+
+			for (const auto& call : calls)
+			{
+				result += call == name ? 1 : 0;
+			}
+
+			return result;
+		}
+	};
+
+	// The cache only compares the pointers, so the fakes never have to point at real objects.
+	template <typename T>
+	T* fakeObject(uintptr_t id)
+	{
+		return reinterpret_cast<T*>(id * 16);
+	}
+
+	D3D12_VERTEX_BUFFER_VIEW vertexBufferView(D3D12_GPU_VIRTUAL_ADDRESS location)
+	{
+		return { location, 4096, 32 };
+	}
+}
+
+TEST_CASE(stateCachedCommandListDropsRepeatedState)
+{
+	RecordingCommandList commandList;
+	StateCachedCommandList<RecordingCommandList> cached(&commandList);
+
+	auto pipelineState = fakeObject<ID3D12PipelineState>(1);
+
+	for (int i = 0; i < 3; i++)
+	{
+		cached.setPipelineState(pipelineState);
+		cached.setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		cached.setStencilRef(1);
+		cached.drawInstanced(3, 1, 0, 0);
+	}
+
+	CHECK_EQUAL(commandList.count("SetPipelineState"), 1u);
+	CHECK_EQUAL(commandList.count("IASetPrimitiveTopology"), 1u);
+	CHECK_EQUAL(commandList.count("OMSetStencilRef"), 1u);
+	CHECK_EQUAL(commandList.count("DrawInstanced"), 3u);
+
+	const auto& statistics = cached.statistics();
+	CHECK_EQUAL(statistics.issuedCount(CommandListState::PipelineState), 1u);
+	CHECK_EQUAL(statistics.elidedCount(CommandListState::PipelineState), 2u);
+	CHECK_EQUAL(statistics.totalIssued(), 3u);
+	CHECK_EQUAL(statistics.totalElided(), 6u);
+
+	cached.setPipelineState(fakeObject<ID3D12PipelineState>(2));
+	cached.setStencilRef(0);
+
+	CHECK_EQUAL(commandList.count("SetPipelineState"), 2u);
+	CHECK_EQUAL(commandList.count("OMSetStencilRef"), 2u);
+}
+
+TEST_CASE(stateCachedCommandListRootSignatureInvalidatesRootArguments)
+{
+	RecordingCommandList commandList;
+	StateCachedCommandList<RecordingCommandList> cached(&commandList);
+
+	cached.setGraphicsRootSignature(fakeObject<ID3D12RootSignature>(1));
+	cached.setGraphicsRootConstantBufferView(0, 0x1000);
+	cached.setGraphicsRootConstantBufferView(0, 0x1000);
+	cached.setGraphicsRootShaderResourceView(1, 0x2000);
+
+	CHECK_EQUAL(commandList.count("SetGraphicsRootConstantBufferView"), 1u);
+
+	// The same root signature again keeps the arguments
+	cached.setGraphicsRootSignature(fakeObject<ID3D12RootSignature>(1));
+	cached.setGraphicsRootConstantBufferView(0, 0x1000);
+
+	CHECK_EQUAL(commandList.count("SetGraphicsRootSignature"), 1u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootConstantBufferView"), 1u);
+
+	cached.setGraphicsRootSignature(fakeObject<ID3D12RootSignature>(2));
+	cached.setGraphicsRootConstantBufferView(0, 0x1000);
+	cached.setGraphicsRootShaderResourceView(1, 0x2000);
+
+	CHECK_EQUAL(commandList.count("SetGraphicsRootSignature"), 2u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootConstantBufferView"), 2u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootShaderResourceView"), 2u);
+}
+
+TEST_CASE(stateCachedCommandListRootArgumentTypeIsPartOfTheValue)
+{
+	RecordingCommandList commandList;
+	StateCachedCommandList<RecordingCommandList> cached(&commandList);
+
+	// Same slot and the same 64 bit value, but a different kind of root argument
+	cached.setGraphicsRootConstantBufferView(2, 0x4000);
+	cached.setGraphicsRootShaderResourceView(2, 0x4000);
+	cached.setGraphicsRootDescriptorTable(2, { 0x4000 });
+
+	CHECK_EQUAL(commandList.count("SetGraphicsRootConstantBufferView"), 1u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootShaderResourceView"), 1u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootDescriptorTable"), 1u);
+}
+
+TEST_CASE(stateCachedCommandListDescriptorHeapsInvalidateTables)
+{
+	RecordingCommandList commandList;
+	StateCachedCommandList<RecordingCommandList> cached(&commandList);
+
+	ID3D12DescriptorHeap* heaps[] = { fakeObject<ID3D12DescriptorHeap>(1), fakeObject<ID3D12DescriptorHeap>(2) };
+
+	cached.setDescriptorHeaps(2, heaps);
+	cached.setGraphicsRootDescriptorTable(0, { 0x100 });
+	cached.setGraphicsRootConstantBufferView(1, 0x200);
+	cached.setDescriptorHeaps(2, heaps);
+	cached.setGraphicsRootDescriptorTable(0, { 0x100 });
+
+	CHECK_EQUAL(commandList.count("SetDescriptorHeaps"), 1u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootDescriptorTable"), 1u);
+
+	// Only one of the heaps changes: the tables point into the old heaps, the CBV is still bound
+	heaps[1] = fakeObject<ID3D12DescriptorHeap>(3);
+	cached.setDescriptorHeaps(2, heaps);
+	cached.setGraphicsRootDescriptorTable(0, { 0x100 });
+	cached.setGraphicsRootConstantBufferView(1, 0x200);
+
+	CHECK_EQUAL(commandList.count("SetDescriptorHeaps"), 2u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootDescriptorTable"), 2u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootConstantBufferView"), 1u);
+
+	// A subset of the previous heaps is a different binding
+	cached.setDescriptorHeaps(1, heaps);
+
+	CHECK_EQUAL(commandList.count("SetDescriptorHeaps"), 3u);
+}
+
+TEST_CASE(stateCachedCommandListComparesBufferViews)
+{
+	RecordingCommandList commandList;
+	StateCachedCommandList<RecordingCommandList> cached(&commandList);
+
+	D3D12_VERTEX_BUFFER_VIEW views[] = { vertexBufferView(0x1000), vertexBufferView(0x2000) };
+	D3D12_INDEX_BUFFER_VIEW indexView = { 0x8000, 1024, DXGI_FORMAT_R32_UINT };
+
+	cached.setVertexBuffers(0, 2, views);
+	cached.setVertexBuffers(0, 2, views);
+	cached.setVertexBuffers(1, 1, &views[1]);
+	cached.setIndexBuffer(indexView);
+	cached.setIndexBuffer(indexView);
+
+	CHECK_EQUAL(commandList.count("IASetVertexBuffers"), 1u);
+	CHECK_EQUAL(commandList.count("IASetIndexBuffer"), 1u);
+
+	// Same location, different size
+	views[1].SizeInBytes = 2048;
+	cached.setVertexBuffers(0, 2, views);
+	indexView.Format = DXGI_FORMAT_R16_UINT;
+	cached.setIndexBuffer(indexView);
+
+	CHECK_EQUAL(commandList.count("IASetVertexBuffers"), 2u);
+	CHECK_EQUAL(commandList.count("IASetIndexBuffer"), 2u);
+
+	// A slot that was never set is not known to be bound
+	cached.setVertexBuffers(2, 1, &views[0]);
+
+	CHECK_EQUAL(commandList.count("IASetVertexBuffers"), 3u);
+}
+
+TEST_CASE(stateCachedCommandListExecuteIndirectForgetsBindings)
+{
+	RecordingCommandList commandList;
+	StateCachedCommandList<RecordingCommandList> cached(&commandList);
+
+	auto pipelineState = fakeObject<ID3D12PipelineState>(1);
+	auto view = vertexBufferView(0x1000);
+	D3D12_INDEX_BUFFER_VIEW indexView = { 0x8000, 1024, DXGI_FORMAT_R32_UINT };
+
+	cached.setPipelineState(pipelineState);
+	cached.setVertexBuffers(0, 1, &view);
+	cached.setIndexBuffer(indexView);
+	cached.setGraphicsRootConstantBufferView(0, 0x1000);
+
+	cached.executeIndirect(fakeObject<ID3D12CommandSignature>(1), 16, fakeObject<ID3D12Resource>(1), 0);
+
+	// The command signature may have changed the buffers and root arguments, not the PSO
+	cached.setPipelineState(pipelineState);
+	cached.setVertexBuffers(0, 1, &view);
+	cached.setIndexBuffer(indexView);
+	cached.setGraphicsRootConstantBufferView(0, 0x1000);
+
+	CHECK_EQUAL(commandList.count("ExecuteIndirect"), 1u);
+	CHECK_EQUAL(commandList.count("SetPipelineState"), 1u);
+	CHECK_EQUAL(commandList.count("IASetVertexBuffers"), 2u);
+	CHECK_EQUAL(commandList.count("IASetIndexBuffer"), 2u);
+	CHECK_EQUAL(commandList.count("SetGraphicsRootConstantBufferView"), 2u);
+}
+
+TEST_CASE(stateCachedCommandListResetForgetsEverything)
+{
+	RecordingCommandList first;
+	RecordingCommandList second;
+	StateCachedCommandList<RecordingCommandList> cached(&first);
+
+	cached.setPipelineState(fakeObject<ID3D12PipelineState>(1));
+	cached.setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	cached.setStencilRef(0);
+
+	cached.reset(&second);
+
+	cached.setPipelineState(fakeObject<ID3D12PipelineState>(1));
+	cached.setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	cached.setStencilRef(0);
+
+	CHECK_EQUAL(first.calls.size(), 3u);
+	CHECK_EQUAL(second.calls.size(), 3u);
+	CHECK(cached.get() == &second);
+
+	// invalidate() is for state set behind the cache's back on the same list
+	cached.invalidate();
+	cached.setPipelineState(fakeObject<ID3D12PipelineState>(1));
+
+	CHECK_EQUAL(second.count("SetPipelineState"), 2u);
+}
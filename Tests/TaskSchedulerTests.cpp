@@ -0,0 +1,127 @@
+#include "Test.h"
+#include "TaskScheduler.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+TEST_CASE(splitIntoChunksBalancesContiguousRanges)
+{
+	auto chunks = splitIntoChunks(10, 4, 1);
+
+	REQUIRE(chunks.size() == 4);
+
+	// Sizes differ by at most one and the larger chunks come first
+	CHECK_EQUAL(chunks[0].size(), 3u);
+	CHECK_EQUAL(chunks[1].size(), 3u);
+	CHECK_EQUAL(chunks[2].size(), 2u);
+	CHECK_EQUAL(chunks[3].size(), 2u);
+
+	uint32_t begin = 0;
+
+	for (const auto& chunk : chunks)
+	{
+		CHECK_EQUAL(chunk.begin, begin);
+		begin = chunk.end;
+	}
+
+	CHECK_EQUAL(begin, 10u);
+
+	// The minimum chunk size caps the chunk count, a small count still gets one chunk
+	CHECK_EQUAL(splitIntoChunks(100, 8, 40).size(), size_t{ 2 });
+	CHECK_EQUAL(splitIntoChunks(3, 8, 40).size(), size_t{ 1 });
+	CHECK_EQUAL(splitIntoChunks(3, 8, 40)[0].size(), 3u);
+	CHECK(splitIntoChunks(0, 8, 1).empty());
+}
+
+TEST_CASE(taskSchedulerRunsEveryTaskExactlyOnce)
+{
+	constexpr uint32_t TaskCount = 1000;
+
+	TaskScheduler scheduler(4);
+
+	CHECK_EQUAL(scheduler.threadCount(), 4u);
+
+	auto runs = std::make_unique<std::atomic<uint32_t>[]>(TaskCount);
+
+	// The workers are reused between runs, each run has to start from its own first task
+	for (uint32_t round = 0; round < 50; round++)
+	{
+		std::atomic<uint32_t> badThreadIndex{ 0 };
+
+		scheduler.run(TaskCount, [&](uint32_t taskIndex, uint32_t threadIndex)
+		{
+			runs[taskIndex]++;
+
+			if (threadIndex >= scheduler.threadCount())
+			{
+				badThreadIndex++;
+			}
+		});
+
+		CHECK_EQUAL(badThreadIndex.load(), 0u);
+	}
+
+	for (uint32_t i = 0; i < TaskCount; i++)
+	{
+		CHECK_EQUAL(runs[i].load(), 50u);
+	}
+
+	// Nothing to do returns at once
+	scheduler.run(0, [&](uint32_t, uint32_t) { runs[0]++; });
+
+	CHECK_EQUAL(runs[0].load(), 50u);
+}
+
+TEST_CASE(taskSchedulerRunsOnTheCallingThreadAlone)
+{
+	TaskScheduler scheduler(1);
+
+	CHECK_EQUAL(scheduler.threadCount(), 1u);
+
+	std::string order;
+
+	scheduler.run(5, [&](uint32_t taskIndex, uint32_t threadIndex)
+	{
+		CHECK_EQUAL(threadIndex, 0u);
+		order += static_cast<char>('0' + taskIndex);
+	});
+
+	CHECK_EQUAL(order, std::string("01234"));
+}
+
+TEST_CASE(taskSchedulerRethrowsTaskExceptions)
+{
+	TaskScheduler scheduler(4);
+
+	std::atomic<uint32_t> completed{ 0 };
+	std::string message;
+
+	try
+	{
+		scheduler.run(100, [&](uint32_t taskIndex, uint32_t)
+		{
+			if (taskIndex == 37)
+			{
+				throw std::runtime_error("task 37");
+			}
+
+			completed++;
+		});
+	}
+	catch (const std::runtime_error& exception)
+	{
+		message = exception.what();
+	}
+
+	// The other tasks still ran before the exception reached the caller
+	CHECK_EQUAL(message, std::string("task 37"));
+	CHECK_EQUAL(completed.load(), 99u);
+
+	// The next run starts clean
+	completed = 0;
+	scheduler.run(100, [&](uint32_t, uint32_t) { completed++; });
+
+	CHECK_EQUAL(completed.load(), 100u);
+}
@@ -0,0 +1,190 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#include <crtdbg.h>
+#endif
+
+namespace
+{
+	struct TestCase
+	{
+		const char* name;
+		TestFunction function;
+		TestKind kind;
+	};
+
+	std::vector<TestCase>& testCases()
+	{
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+
+	uint32_t currentFailures = 0;
+	uint32_t directoryCount = 0;
+
+	// The --death process: runs the body of one death test, which should not come back
+	int runDeathTestBody(const char* name)
+	{
+#ifdef _WIN32
+		// A failed assert prints and aborts instead of opening a dialog nobody is there to close
+		_set_error_mode(_OUT_TO_STDERR);
+		_set_abort_behavior(0, _WRITE_ABORT_MSG | _CALL_REPORTFAULT);
+		_CrtSetReportMode(_CRT_ASSERT, _CRTDBG_MODE_FILE);
+		_CrtSetReportFile(_CRT_ASSERT, _CRTDBG_FILE_STDERR);
+#endif
+
+		for (const auto& test : testCases())
+		{
+			if (test.kind == TestKind::Death && std::strcmp(test.name, name) == 0)
+			{
+				try
+				{
+					test.function();
+				}
+				catch (...)
+				{
+				}
+			}
+		}
+
+		return 0;
+	}
+
+#ifndef NDEBUG
+	// True when the death test ended its process
+	bool runDeathTest(const char* executable, const char* name)
+	{
+#ifdef _WIN32
+		const char* discardOutput = " > NUL 2>&1";
+#else
+		const char* discardOutput = " > /dev/null 2>&1";
+#endif
+		auto command = std::string("\"") + executable + "\" --death " + name + discardOutput;
+
+		return std::system(command.c_str()) != 0;
+	}
+#endif
+}
+
+TestRegistration::TestRegistration(const char* name, TestFunction function, TestKind kind)
+{
+	testCases().push_back({ name, function, kind });
+}
+
+void reportTestFailure(const char* file, int line, const std::string& message)
+{
+	std::printf("%s(%d): CHECK failed: %s\n", file, line, message.c_str());
+	currentFailures++;
+}
+
+TestDirectory::TestDirectory()
+{
+	std::error_code error;
+	auto base = std::filesystem::temp_directory_path(error);
+
+	// Several test runs may share the temporary directory, a random number keeps them apart
+	static const auto run = std::random_device()();
+	mPath = base / ("Tests-" + std::to_string(run) + "-" + std::to_string(directoryCount++));
+
+	std::filesystem::remove_all(mPath, error);
+	std::filesystem::create_directories(mPath, error);
+}
+
+TestDirectory::~TestDirectory()
+{
+	std::error_code error;
+	std::filesystem::remove_all(mPath, error);
+}
+
+std::filesystem::path TestDirectory::write(const std::string& name, const std::string& content) const
+{
+	auto path = mPath / name;
+
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(content.data(), content.size());
+
+	return path;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 3 && std::strcmp(argv[1], "--death") == 0)
+	{
+		return runDeathTestBody(argv[2]);
+	}
+
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	uint32_t run = 0;
+	uint32_t failed = 0;
+
+	for (const auto& test : testCases())
+	{
+		if (filter != nullptr && std::strstr(test.name, filter) == nullptr)
+		{
+			continue;
+		}
+
+		// Benchmarks take long and only print, they run when asked for by name
+		if (test.kind == TestKind::Benchmark && filter == nullptr)
+		{
+			continue;
+		}
+
+		currentFailures = 0;
+
+		if (test.kind == TestKind::Death)
+		{
+#ifdef NDEBUG
+			std::printf("[skipped] %s\n", test.name);
+			continue;
+#else
+			if (!runDeathTest(argv[0], test.name))
+			{
+				reportTestFailure(test.name, 0, "the process did not end");
+			}
+#endif
+		}
+		else
+		{
+			try
+			{
+				test.function();
+			}
+			catch (const TestAbort&)
+			{
+			}
+			catch (const std::exception& exception)
+			{
+				reportTestFailure(test.name, 0, std::string("unexpected exception: ") + exception.what());
+			}
+		}
+
+		run++;
+
+		if (currentFailures > 0)
+		{
+			std::printf("[FAILED] %s\n", test.name);
+			failed++;
+		}
+		else
+		{
+			std::printf("[passed] %s\n", test.name);
+		}
+	}
+
+	std::printf("%u tests, %u failed\n", run, failed);
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+// A minimal test harness for the modules that do not need a device or a window.
+// TEST_CASE registers a function at static initialization time, the runner in Test.cpp
+// calls every registered test (or the ones whose name contains the first argument) and
+// returns the number of failed tests. CHECK records a failure and carries on, REQUIRE
+// stops the current test.
+// DEATH_TEST registers a test whose body has to end the process, by failing an assert for
+// instance. The runner starts itself again with --death <name> to run it and the test passes
+// when that process fails. Asserts are compiled out with NDEBUG, death tests are skipped there.
+// BENCHMARK registers a measurement that prints its results. It is left out of the default run
+// and only runs when the first argument names it ("Tests Benchmark" runs them all).
+
+using TestFunction = void (*)();
+
+enum class TestKind
+{
+	Test,
+	Death,
+	Benchmark
+};
+
+struct TestRegistration
+{
+	TestRegistration(const char* name, TestFunction function, TestKind kind = TestKind::Test);
+};
+
+// Thrown by REQUIRE to leave the current test, caught by the runner.
+struct TestAbort
+{
+};
+
+void reportTestFailure(const char* file, int line, const std::string& message);
+
+// An empty directory under the system temporary directory for tests of code that reads and writes
+// files, removed with everything in it when the test is done.
+class TestDirectory
+{
+public:
+	TestDirectory();
+	~TestDirectory();
+
+	TestDirectory(const TestDirectory&) = delete;
+	TestDirectory& operator=(const TestDirectory&) = delete;
+
+	const std::filesystem::path& path() const { return mPath; }
+
+	// Creates or replaces the file at name (relative to the directory, parents are created) and returns its path.
+	std::filesystem::path write(const std::string& name, const std::string& content) const;
+
+private:
+	std::filesystem::path mPath;
+};
+
+template <typename T>
+void printTestValue(std::ostringstream& stream, const T& value)
+{
+	if constexpr (std::is_enum_v<T>)
+	{
+		stream << static_cast<int64_t>(value);
+	}
+	else if constexpr (std::is_arithmetic_v<T>)
+	{
+		// Promotes uint8_t to a number instead of a character.
+		stream << +value;
+	}
+	else
+	{
+		stream << value;
+	}
+}
+
+template <typename Left, typename Right>
+std::string describeComparison(const char* expression, const Left& left, const Right& right)
+{
+	std::ostringstream stream;
+	stream << expression << " (";
+	printTestValue(stream, left);
+	stream << " vs ";
+	printTestValue(stream, right);
+	stream << ")";
+
+	return stream.str();
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name); \
+	static void name()
+
+#define DEATH_TEST(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name, TestKind::Death); \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name, TestKind::Benchmark); \
+	static void name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) reportTestFailure(__FILE__, __LINE__, #expression); } while (false)
+
+#define CHECK_EQUAL(left, right) \
+	do { const auto& checkLeft = (left); const auto& checkRight = (right); \
+		 if (!(checkLeft == checkRight)) reportTestFailure(__FILE__, __LINE__, describeComparison(#left " == " #right, checkLeft, checkRight)); } while (false)
+
+#define REQUIRE(expression) \
+	do { if (!(expression)) { reportTestFailure(__FILE__, __LINE__, #expression); throw TestAbort{}; } } while (false)
@@ -0,0 +1,264 @@
+#include "Test.h"
+#include "TextureStreamer.h"
+
+#include <vector>
+
+namespace
+{
+	// Four mips, the last one is the tail.
+	StreamedTextureDesc testTexture()
+	{
+		StreamedTextureDesc desc;
+		desc.width = 16;
+		desc.height = 16;
+		desc.mipSizes = { 512, 128, 32, 8 };
+		desc.tailMipCount = 1;
+
+		return desc;
+	}
+
+	constexpr uint64_t FullTextureBytes = 512 + 128 + 32 + 8;
+
+	// Runs one update and completes every load it issued right away, like a loader with no latency.
+	std::vector<StreamingRequest> step(TextureStreamer& streamer, uint64_t frame)
+	{
+		auto requests = streamer.update(frame);
+
+		for (const auto& request : requests)
+		{
+			if (request.action == StreamingAction::Load)
+			{
+				streamer.completeLoad(request.texture, request.mip);
+			}
+		}
+
+		return requests;
+	}
+}
+
+TEST_CASE(textureStreamerLoadsMipTailsFirst)
+{
+	// The budget does not even cover the tails, they are loaded anyway
+	TextureStreamer streamer(0);
+
+	auto a = streamer.registerTexture(testTexture());
+	auto b = streamer.registerTexture(testTexture());
+
+	streamer.requestMip(a, 0.0f, 1);
+
+	auto requests = streamer.update(1);
+
+	REQUIRE(requests.size() == 2);
+
+	for (const auto& request : requests)
+	{
+		CHECK(request.action == StreamingAction::Load);
+		CHECK_EQUAL(request.mip, 3u);
+		CHECK_EQUAL(request.bytes, 8u);
+	}
+
+	CHECK_EQUAL(requests[0].texture, a);
+	CHECK_EQUAL(requests[1].texture, b);
+
+	// Nothing is resident until the loads complete
+	CHECK_EQUAL(streamer.residentMip(a), 4u);
+	CHECK_EQUAL(streamer.statistics().pendingBytes, 16u);
+
+	streamer.completeLoad(a, 3);
+	streamer.completeLoad(b, 3);
+
+	CHECK_EQUAL(streamer.residentMip(a), 3u);
+	CHECK_EQUAL(streamer.statistics().residentBytes, 16u);
+	CHECK_EQUAL(streamer.statistics().pendingBytes, 0u);
+}
+
+TEST_CASE(textureStreamerLoadsOneMipPerUpdate)
+{
+	TextureStreamer streamer(FullTextureBytes);
+
+	auto texture = streamer.registerTexture(testTexture());
+
+	step(streamer, 1);
+
+	for (uint32_t mip = 3; mip-- > 0;)
+	{
+		auto frame = 5 - mip;
+		streamer.requestMip(texture, 0.0f, frame);
+
+		auto requests = step(streamer, frame);
+
+		REQUIRE(requests.size() == 1);
+		CHECK(requests[0].action == StreamingAction::Load);
+		CHECK_EQUAL(requests[0].mip, mip);
+		CHECK_EQUAL(streamer.residentMip(texture), mip);
+	}
+
+	CHECK_EQUAL(streamer.statistics().residentBytes, FullTextureBytes);
+
+	// Everything wanted is resident
+	streamer.requestMip(texture, 0.0f, 6);
+	CHECK(step(streamer, 6).empty());
+}
+
+TEST_CASE(textureStreamerEvictsLeastRecentlyUsedFirst)
+{
+	// Room for two full textures and the tail of a third
+	TextureStreamer streamer(2 * FullTextureBytes + 8);
+
+	auto a = streamer.registerTexture(testTexture());
+	auto b = streamer.registerTexture(testTexture());
+	auto c = streamer.registerTexture(testTexture());
+
+	step(streamer, 1);
+
+	// a is last used at frame 4 and b at frame 5
+	for (uint64_t frame = 2; frame <= 5; frame++)
+	{
+		if (frame <= 4)
+		{
+			streamer.requestMip(a, 0.0f, frame);
+		}
+
+		streamer.requestMip(b, 0.0f, frame);
+		step(streamer, frame);
+	}
+
+	REQUIRE(streamer.residentMip(a) == 0);
+	REQUIRE(streamer.residentMip(b) == 0);
+
+	streamer.requestMip(c, 0.0f, 6);
+
+	auto requests = step(streamer, 6);
+
+	// The most detailed mip of a makes room, b was used more recently and is left alone
+	REQUIRE(requests.size() == 2);
+	CHECK(requests[0].action == StreamingAction::Evict);
+	CHECK_EQUAL(requests[0].texture, a);
+	CHECK_EQUAL(requests[0].mip, 1u);
+	CHECK_EQUAL(requests[0].bytes, 512u);
+
+	CHECK(requests[1].action == StreamingAction::Load);
+	CHECK_EQUAL(requests[1].texture, c);
+	CHECK_EQUAL(requests[1].mip, 2u);
+
+	CHECK_EQUAL(streamer.residentMip(a), 1u);
+	CHECK_EQUAL(streamer.residentMip(b), 0u);
+	CHECK(streamer.statistics().residentBytes <= 2 * FullTextureBytes + 8);
+}
+
+TEST_CASE(textureStreamerKeepsMipsUsedThisFrame)
+{
+	TextureStreamer streamer(FullTextureBytes + 8);
+
+	auto a = streamer.registerTexture(testTexture());
+	auto b = streamer.registerTexture(testTexture());
+
+	step(streamer, 1);
+
+	for (uint64_t frame = 2; frame <= 4; frame++)
+	{
+		streamer.requestMip(a, 0.0f, frame);
+		step(streamer, frame);
+	}
+
+	REQUIRE(streamer.residentMip(a) == 0);
+
+	// Both are drawn this frame, a keeps what it asked for and b has to wait
+	streamer.requestMip(a, 0.0f, 5);
+	streamer.requestMip(b, 0.0f, 5);
+
+	auto requests = step(streamer, 5);
+
+	CHECK(requests.empty());
+	CHECK_EQUAL(streamer.statistics().loadsDeferred, 1u);
+	CHECK_EQUAL(streamer.residentMip(a), 0u);
+	CHECK_EQUAL(streamer.residentMip(b), 3u);
+
+	// The eviction goes through once a is no longer drawn
+	streamer.requestMip(b, 0.0f, 6);
+
+	requests = step(streamer, 6);
+
+	REQUIRE(requests.size() == 2);
+	CHECK(requests[0].action == StreamingAction::Evict);
+	CHECK_EQUAL(requests[0].texture, a);
+	CHECK_EQUAL(streamer.residentMip(b), 2u);
+}
+
+TEST_CASE(textureStreamerRequestsTimeOut)
+{
+	TextureStreamer streamer(2 * FullTextureBytes);
+	streamer.setRequestTimeout(2);
+
+	auto texture = streamer.registerTexture(testTexture());
+
+	step(streamer, 1);
+
+	for (uint64_t frame = 2; frame <= 4; frame++)
+	{
+		streamer.requestMip(texture, 0.0f, frame);
+		step(streamer, frame);
+	}
+
+	REQUIRE(streamer.residentMip(texture) == 0);
+
+	// Still wanted within the timeout
+	step(streamer, 6);
+	CHECK_EQUAL(streamer.desiredMip(texture), 0u);
+
+	// Decays to the tail afterwards, the resident mips stay until something needs the space
+	step(streamer, 7);
+	CHECK_EQUAL(streamer.desiredMip(texture), 3u);
+	CHECK_EQUAL(streamer.residentMip(texture), 0u);
+
+	// A new request restores the wish
+	streamer.requestMip(texture, 1.5f, 8);
+	CHECK_EQUAL(streamer.desiredMip(texture), 1u);
+}
+
+TEST_CASE(textureStreamerEvictsUnwantedMipsBeforeWantedOnes)
+{
+	TextureStreamer streamer(2 * FullTextureBytes + 8);
+
+	auto a = streamer.registerTexture(testTexture());
+	auto b = streamer.registerTexture(testTexture());
+	auto c = streamer.registerTexture(testTexture());
+
+	step(streamer, 1);
+
+	for (uint64_t frame = 2; frame <= 4; frame++)
+	{
+		streamer.requestMip(a, 0.0f, frame);
+		streamer.requestMip(b, 0.0f, frame);
+		step(streamer, frame);
+	}
+
+	REQUIRE(streamer.residentMip(a) == 0);
+	REQUIRE(streamer.residentMip(b) == 0);
+
+	// b is the least recently used but still wants all its mips, a was used later but only needs its tail now
+	streamer.requestMip(b, 0.0f, 5);
+	step(streamer, 5);
+
+	streamer.requestMip(a, 3.0f, 6);
+	CHECK(step(streamer, 6).empty());
+
+	streamer.requestMip(c, 0.0f, 7);
+
+	auto requests = step(streamer, 7);
+
+	REQUIRE(requests.size() == 2);
+	CHECK(requests[0].action == StreamingAction::Evict);
+	CHECK_EQUAL(requests[0].texture, a);
+	CHECK_EQUAL(streamer.residentMip(a), 1u);
+	CHECK_EQUAL(streamer.residentMip(b), 0u);
+	CHECK_EQUAL(streamer.residentMip(c), 2u);
+}
+
+TEST_CASE(textureStreamerDesiredMipFromScreenCoverage)
+{
+	// 1024x1024 texels over 256x256 pixels is 16 texels per pixel, two mips down
+	CHECK_EQUAL(TextureStreamer::calculateDesiredMip(1024, 1024, 256.0f * 256.0f), 2.0f);
+	CHECK_EQUAL(TextureStreamer::calculateDesiredMip(1024, 1024, 2048.0f * 2048.0f), 0.0f);
+	CHECK_EQUAL(TextureStreamer::calculateDesiredMip(1024, 1024, 0.0f), 10.0f);
+}
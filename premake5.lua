@@ -167,4 +167,77 @@ project "DirectX12FromScratch"
         -- debugdir "%{prj.location}"  -- 项目所在目录(.vcxproj)
         debugdir "%{wks.location}"     -- 解决方案所在目录(.sln)
 
+--单元测试：只测试不需要GPU和窗口的模块，被测试的源文件直接编译进测试程序
+--Linux上使用DirectX-Headers中的WSL适配头文件代替Windows SDK，可以用premake5 gmake2生成Makefile
+project "Tests"
+    kind "ConsoleApp"
+    language "C++"
+    location "Project"
+
+    files
+    {
+        "Tests/**.h",
+        "Tests/**.cpp",
+        "Src/AssetCache.cpp",
+        "Src/BCEncoder.cpp",
+        "Src/DescriptorAllocator.cpp",
+        "Src/DrawSort.cpp",
+        "Src/GeometryPool.cpp",
+        "Src/HeapAllocator.cpp",
+        "Src/IndirectCommands.cpp",
+        "Src/InstanceBatcher.cpp",
+        "Src/LinearAllocator.cpp",
+        "Src/MappedFile.cpp",
+        "Src/PipelineStateCache.cpp",
+        "Src/RenderGraph.cpp",
+        "Src/ResourceStateTracker.cpp",
+        "Src/ShaderCache.cpp",
+        "Src/ShaderHotReload.cpp",
+        "Src/StagingRing.cpp",
+        "Src/STBImage.cpp",
+        "Src/TaskScheduler.cpp",
+        "Src/TextureStreamer.cpp"
+    }
+
+    --Tests/Linux中是Linux上代替Windows SDK的头文件，只加到Linux构建的包含路径中
+    removefiles { "Tests/Linux/**" }
+
+    vpaths
+    {
+        {["Headers"] = {"**.h"} },
+        {["Sources"] = {"**.cpp"} }
+    }
+
+    includedirs
+    {
+        'Src',
+        'Tests',
+        'ThirdParty',
+        'ThirdParty/stb',
+        'ThirdParty/glm-0.9.9.8/glm',
+        'ThirdParty/fmt-9.1.0/include',
+        'ThirdParty/DirectX-Headers/include/directx'
+    }
+
+    debugdir "%{wks.location}"
+
+    filter "system:linux"
+        includedirs
+        {
+            'ThirdParty/DirectX-Headers/include',
+            'ThirdParty/DirectX-Headers/include/wsl/stubs',
+            'Tests/Linux'
+        }
+        links { "pthread" }
+
+    filter "configurations:Debug"
+        defines { "DEBUG", "FMT_HEADER_ONLY", "NOMINMAX" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG", "FMT_HEADER_ONLY", "NOMINMAX" }
+        optimize "On"
+
+    filter {}
+
 include "External.lua"
\ No newline at end of file